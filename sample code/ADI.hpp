@@ -0,0 +1,469 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ===================================================================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Two-dimensional ADI finite differences for Heston and two-asset options
+*
+*/
+
+/*   The value u(tau, x, y), with tau the time to expiry, solves
+*        u_tau = a_xx u_xx + a_yy u_yy + a_xy u_xy + a_x u_x + a_y u_y - r u = (A0 + A1 + A2) u
+*    with A0 the mixed derivative term, A1 the x terms and A2 the y terms, each of A1 and A2 carrying half of -r u.
+*    Spatial derivatives are the three-point central differences of a non-uniform grid; on the first and the last node
+*    of a direction the second derivative is dropped and the first one is one-sided. The grids start at zero, where
+*    the coefficients of the diffusions vanish and no boundary value is needed, and the far edges are linear.
+*
+*    Alternating direction implicit splitting with parameter theta, from U to the next step over dt:
+*        Douglas:        Y0 = U + dt (A0 + A1 + A2) U
+*                        (I - theta dt A1) Y1 = Y0 - theta dt A1 U
+*                        (I - theta dt A2) Y2 = Y1 - theta dt A2 U
+*        Craig-Sneyd:    then Y0' = Y0 + dt / 2 (A0 Y2 - A0 U), and the two implicit sweeps again from Y0'
+*    The first steps are damped with half steps of Douglas at theta = 1, against the kink of the payoff.
+*
+*    The implicit sweeps are tridiagonal solves along the grid lines. A task takes a batch of lines, gathers them so
+*    that the line index is innermost, and runs the Thomas recursion on the whole batch at once, so the loops
+*    vectorize. A solve runs a few short parallel loops per step, so it keeps one thread pool and one set of buffers
+*    for all its steps instead of starting threads and allocating on every loop. Prices and Greeks are read on the grid,
+*    bilinearly in between.
+*/
+
+// Multiple inclusion guards
+#ifndef ADI_HPP
+#define ADI_HPP
+
+#include <vector>
+#include <functional>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+#include "StochasticVol.hpp"
+#include "Parallel.hpp"
+
+// Splitting scheme of the ADI engine
+enum class ADIScheme { Douglas, CraigSneyd };
+
+// Price and Greeks at the spot point, in the coordinates x and y of the problem
+struct ADIResults {
+	double price = 0.0;
+	double delta_x = 0.0;
+	double delta_y = 0.0;
+	double gamma_xx = 0.0;
+	double gamma_yy = 0.0;
+	double gamma_xy = 0.0;
+};
+
+// Two-dimensional problem: grids, PDE coefficients at (x, y) and payoff
+struct ADIProblem {
+	std::vector<double> x;
+	std::vector<double> y;
+	std::function<void(double, double, double *)> coefficients;	// Writes a_xx, a_yy, a_xy, a_x, a_y
+	std::function<double(double, double)> payoff;
+	double r = 0.0;													// Interest rate
+};
+
+// Two-dimensional ADI engine
+class ADIEngine {
+private:
+	ADIProblem problem;
+	std::size_t nx, ny;
+
+	// Per node, x fastest: the three entries of A1 and A2 on their lines, and the mixed coefficient
+	std::vector<double> L1, D1, U1, L2, D2, U2, mixed;
+
+	// Three-point first and second derivative weights of each node of a grid
+	std::vector<double> wx1, wx2, wy1, wy2;
+
+	static constexpr std::size_t lanes = 32;	// Lines per batch of the implicit sweeps
+
+	// Weights of node k of grid z, as (previous, node, next)
+	inline static void Weights(const std::vector<double> & z, std::vector<double> & w1, std::vector<double> & w2) {
+		std::size_t n = z.size();
+		w1.assign(3 * n, 0.0);
+		w2.assign(3 * n, 0.0);
+		for (std::size_t k = 0; k < n; ++k) {
+			double * a = w1.data() + 3 * k, * b = w2.data() + 3 * k;
+			if (k == 0) {
+				double h = z[1] - z[0];
+				a[1] = -1.0 / h;
+				a[2] = 1.0 / h;
+			}
+			else if (k == n - 1) {
+				double h = z[k] - z[k - 1];
+				a[0] = -1.0 / h;
+				a[1] = 1.0 / h;
+			}
+			else {
+				double hm = z[k] - z[k - 1], hp = z[k + 1] - z[k], s = hm + hp;
+				a[0] = -hp / (hm * s);
+				a[1] = (hp - hm) / (hm * hp);
+				a[2] = hm / (hp * s);
+				b[0] = 2.0 / (hm * s);
+				b[1] = -2.0 / (hm * hp);
+				b[2] = 2.0 / (hp * s);
+			}
+		}
+	}
+
+	// Thomas algorithm on a batch of systems, stored as [k * m + lane] for row k of lane; solution in place of d
+	inline static void BatchedThomas(const double * a, const double * b, const double * c, double * d, double * cp, std::size_t n, std::size_t m) {
+		for (std::size_t l = 0; l < m; ++l) {
+			cp[l] = c[l] / b[l];
+			d[l] = d[l] / b[l];
+		}
+		for (std::size_t k = 1; k < n; ++k) {
+			const double * ak = a + k * m, * bk = b + k * m, * ck = c + k * m;
+			double * dk = d + k * m, * cpk = cp + k * m;
+			const double * dp = d + (k - 1) * m, * cpp = cp + (k - 1) * m;
+			for (std::size_t l = 0; l < m; ++l) {
+				double inv = 1.0 / (bk[l] - ak[l] * cpp[l]);
+				cpk[l] = ck[l] * inv;
+				dk[l] = (dk[l] - ak[l] * dp[l]) * inv;
+			}
+		}
+		for (std::size_t k = n - 1; k-- > 0;) {
+			double * dk = d + k * m;
+			const double * dn = d + (k + 1) * m, * cpk = cp + k * m;
+			for (std::size_t l = 0; l < m; ++l) dk[l] -= cpk[l] * dn[l];
+		}
+	}
+
+	// Buffers of a solve, allocated once: the operators of the step, the intermediate values and a line batch per thread
+	struct Workspace {
+		std::vector<double> a0, a1, a2, y0, y, z;
+		std::vector<std::vector<double>> lines;
+	};
+
+	// A1 U at node n = (i, j)
+	inline double ApplyX(const std::vector<double> & u, std::size_t i, std::size_t n) const {
+		double v = D1[n] * u[n];
+		if (i > 0) v += L1[n] * u[n - 1];
+		if (i + 1 < nx) v += U1[n] * u[n + 1];
+		return v;
+	}
+
+	// A2 U at node n = (i, j)
+	inline double ApplyY(const std::vector<double> & u, std::size_t j, std::size_t n) const {
+		double v = D2[n] * u[n];
+		if (j > 0) v += L2[n] * u[n - nx];
+		if (j + 1 < ny) v += U2[n] * u[n + nx];
+		return v;
+	}
+
+	// A0 U at node n = (i, j), zero on the edges
+	inline double ApplyMixed(const std::vector<double> & u, std::size_t i, std::size_t j, std::size_t n) const {
+		if (i == 0 || i + 1 == nx || j == 0 || j + 1 == ny || mixed[n] == 0.0) return 0.0;
+		const double * wx = wx1.data() + 3 * i, * wy = wy1.data() + 3 * j;
+		double v = 0.0;
+		for (int l = 0; l < 3; ++l) {
+			const double * row = u.data() + (j + l - 1) * nx + i - 1;
+			v += wy[l] * (wx[0] * row[0] + wx[1] * row[1] + wx[2] * row[2]);
+		}
+		return v * mixed[n];
+	}
+
+	// Solve (I - w A1) out = rhs along the x lines, in batches of rows
+	inline void SweepX(const std::vector<double> & rhs, std::vector<double> & out, double w, ThreadPool & pool, Workspace & ws) const {
+		std::size_t batches = (ny + lanes - 1) / lanes;
+		pool.For(0, batches, [&](std::size_t t, unsigned thread_id) {
+			std::size_t j0 = t * lanes, m = std::min(lanes, ny - j0), size = nx * m;
+			double * a = ws.lines[thread_id].data(), * b = a + size, * c = b + size, * d = c + size, * cp = d + size;
+			for (std::size_t l = 0; l < m; ++l) {
+				std::size_t row = (j0 + l) * nx;
+				for (std::size_t i = 0; i < nx; ++i) {
+					a[i * m + l] = -w * L1[row + i];
+					b[i * m + l] = 1.0 - w * D1[row + i];
+					c[i * m + l] = -w * U1[row + i];
+					d[i * m + l] = rhs[row + i];
+				}
+			}
+			BatchedThomas(a, b, c, d, cp, nx, m);
+			for (std::size_t l = 0; l < m; ++l) {
+				std::size_t row = (j0 + l) * nx;
+				for (std::size_t i = 0; i < nx; ++i) out[row + i] = d[i * m + l];
+			}
+		});
+	}
+
+	// Solve (I - w A2) out = rhs - w A2 U along the y lines, in batches of columns, with A2 U given in a2
+	inline void SweepY(const std::vector<double> & rhs, const std::vector<double> & a2, std::vector<double> & out, double w,
+		ThreadPool & pool, Workspace & ws) const {
+		std::size_t batches = (nx + lanes - 1) / lanes;
+		pool.For(0, batches, [&](std::size_t t, unsigned thread_id) {
+			std::size_t i0 = t * lanes, m = std::min(lanes, nx - i0), size = ny * m;
+			double * a = ws.lines[thread_id].data(), * b = a + size, * c = b + size, * d = c + size, * cp = d + size;
+			for (std::size_t j = 0; j < ny; ++j) {
+				std::size_t n = j * nx + i0;
+				for (std::size_t l = 0; l < m; ++l) {
+					a[j * m + l] = -w * L2[n + l];
+					b[j * m + l] = 1.0 - w * D2[n + l];
+					c[j * m + l] = -w * U2[n + l];
+					d[j * m + l] = rhs[n + l] - w * a2[n + l];
+				}
+			}
+			BatchedThomas(a, b, c, d, cp, ny, m);
+			for (std::size_t j = 0; j < ny; ++j) {
+				std::copy(d + j * m, d + (j + 1) * m, out.begin() + j * nx + i0);
+			}
+		});
+	}
+
+	// One step of length dt from u
+	// The explicit stages are computed row by row on the pool, fused with the right-hand sides of the x sweeps, and the
+	// A2 U terms of the y sweeps are subtracted while gathering the lines, so each stage is a single parallel pass
+	inline void Step(std::vector<double> & u, double dt, double theta, bool craig_sneyd, ThreadPool & pool, Workspace & ws) const {
+
+		const double w = theta * dt;
+		pool.For(0, ny, [&](std::size_t j, unsigned) {
+			for (std::size_t i = 0, n = j * nx; i < nx; ++i, ++n) {
+				double v0 = ApplyMixed(u, i, j, n), v1 = ApplyX(u, i, n), v2 = ApplyY(u, j, n);
+				ws.a0[n] = v0;
+				ws.a1[n] = v1;
+				ws.a2[n] = v2;
+				ws.y0[n] = u[n] + dt * (v0 + v1 + v2);
+				ws.y[n] = ws.y0[n] - w * v1;
+			}
+		});
+		SweepX(ws.y, ws.y, w, pool, ws);
+		SweepY(ws.y, ws.a2, ws.y, w, pool, ws);
+
+		if (craig_sneyd) {
+			pool.For(0, ny, [&](std::size_t j, unsigned) {
+				for (std::size_t i = 0, n = j * nx; i < nx; ++i, ++n) {
+					ws.z[n] = ws.y0[n] + 0.5 * dt * (ApplyMixed(ws.y, i, j, n) - ws.a0[n]) - w * ws.a1[n];
+				}
+			});
+			SweepX(ws.z, ws.z, w, pool, ws);
+			SweepY(ws.z, ws.a2, ws.z, w, pool, ws);
+			u.swap(ws.z);
+		}
+		else {
+			u.swap(ws.y);
+		}
+	}
+
+	// Cell of grid z containing z0, clamped to the grid, and the weight of its upper node
+	inline static std::size_t Locate(const std::vector<double> & z, double z0, double & w) {
+		std::size_t k = static_cast<std::size_t>(std::upper_bound(z.begin(), z.end(), z0) - z.begin());
+		k = std::min(std::max<std::size_t>(k, 1), z.size() - 1) - 1;
+		w = std::min(std::max((z0 - z[k]) / (z[k + 1] - z[k]), 0.0), 1.0);
+		return k;
+	}
+
+public:
+
+	// Constructor
+	explicit ADIEngine(const ADIProblem & problem_) : problem(problem_), nx(problem_.x.size()), ny(problem_.y.size()) {
+
+		if (nx < 3 || ny < 3) throw std::invalid_argument("ADI needs at least three nodes per direction");
+		if (!problem.coefficients || !problem.payoff) throw std::invalid_argument("ADI needs PDE coefficients and a payoff");
+		for (std::size_t i = 1; i < nx; ++i) if (problem.x[i] <= problem.x[i - 1]) throw std::invalid_argument("ADI grids must increase");
+		for (std::size_t j = 1; j < ny; ++j) if (problem.y[j] <= problem.y[j - 1]) throw std::invalid_argument("ADI grids must increase");
+
+		Weights(problem.x, wx1, wx2);
+		Weights(problem.y, wy1, wy2);
+
+		const std::size_t size = nx * ny;
+		L1.assign(size, 0.0); D1.assign(size, 0.0); U1.assign(size, 0.0);
+		L2.assign(size, 0.0); D2.assign(size, 0.0); U2.assign(size, 0.0);
+		mixed.assign(size, 0.0);
+
+		for (std::size_t j = 0; j < ny; ++j) {
+			for (std::size_t i = 0; i < nx; ++i) {
+				double c[5];
+				problem.coefficients(problem.x[i], problem.y[j], c);
+				std::size_t n = j * nx + i;
+				const double * a1 = wx1.data() + 3 * i, * a2 = wx2.data() + 3 * i;
+				const double * b1 = wy1.data() + 3 * j, * b2 = wy2.data() + 3 * j;
+				L1[n] = c[0] * a2[0] + c[3] * a1[0];
+				D1[n] = c[0] * a2[1] + c[3] * a1[1] - 0.5 * problem.r;
+				U1[n] = c[0] * a2[2] + c[3] * a1[2];
+				L2[n] = c[1] * b2[0] + c[4] * b1[0];
+				D2[n] = c[1] * b2[1] + c[4] * b1[1] - 0.5 * problem.r;
+				U2[n] = c[1] * b2[2] + c[4] * b1[2];
+				mixed[n] = c[2];
+			}
+		}
+	}
+
+	// Getters
+	inline const std::vector<double> & GridX() const { return problem.x; }
+	inline const std::vector<double> & GridY() const { return problem.y; }
+
+	// Values at expiry T on the grid, x fastest, with NT steps; the first damping steps are two half steps of Douglas at theta = 1
+	inline std::vector<double> Solve(double T, std::size_t NT, ADIScheme scheme = ADIScheme::CraigSneyd, double theta = 0.5,
+		std::size_t damping = 2, unsigned threads = 0) const {
+
+		if (T <= 0.0 || NT == 0 || theta <= 0.0) throw std::invalid_argument("Invalid ADI time stepping");
+
+		std::vector<double> u(nx * ny);
+		for (std::size_t j = 0; j < ny; ++j) {
+			for (std::size_t i = 0; i < nx; ++i) u[j * nx + i] = problem.payoff(problem.x[i], problem.y[j]);
+		}
+
+		// The workers and the buffers live for the whole solve
+		ThreadPool pool(threads);
+		Workspace ws;
+		for (auto v : { &ws.a0, &ws.a1, &ws.a2, &ws.y0, &ws.y, &ws.z }) v->resize(nx * ny);
+		ws.lines.assign(pool.Size(), std::vector<double>(5 * lanes * std::max(nx, ny)));
+
+		const double dt = T / static_cast<double>(NT);
+		for (std::size_t s = 0; s < NT; ++s) {
+			if (s < damping) {
+				Step(u, 0.5 * dt, 1.0, false, pool, ws);
+				Step(u, 0.5 * dt, 1.0, false, pool, ws);
+			}
+			else {
+				Step(u, dt, theta, scheme == ADIScheme::CraigSneyd, pool, ws);
+			}
+		}
+		return u;
+	}
+
+	// Price and Greeks at (x0, y0) from the values on the grid, bilinear between the nodes
+	inline ADIResults Evaluate(const std::vector<double> & u, double x0, double y0) const {
+
+		if (u.size() != nx * ny) throw std::invalid_argument("ADI values do not match the grid");
+
+		double wx, wy;
+		std::size_t i0 = Locate(problem.x, x0, wx), j0 = Locate(problem.y, y0, wy);
+
+		ADIResults res;
+		for (std::size_t dj = 0; dj < 2; ++dj) {
+			for (std::size_t di = 0; di < 2; ++di) {
+				std::size_t i = i0 + di, j = j0 + dj;
+				double w = (di ? wx : 1.0 - wx) * (dj ? wy : 1.0 - wy);
+				const double * a1 = wx1.data() + 3 * i, * a2 = wx2.data() + 3 * i;
+				const double * b1 = wy1.data() + 3 * j, * b2 = wy2.data() + 3 * j;
+
+				// Neighbours in each direction, with the missing ones at zero weight
+				auto U = [&](std::size_t p, std::size_t q) { return u[q * nx + p]; };
+				std::size_t im = (i > 0) ? i - 1 : i, ip = (i + 1 < nx) ? i + 1 : i;
+				std::size_t jm = (j > 0) ? j - 1 : j, jp = (j + 1 < ny) ? j + 1 : j;
+
+				double dx = a1[0] * U(im, j) + a1[1] * U(i, j) + a1[2] * U(ip, j);
+				double dy = b1[0] * U(i, jm) + b1[1] * U(i, j) + b1[2] * U(i, jp);
+				double gxx = a2[0] * U(im, j) + a2[1] * U(i, j) + a2[2] * U(ip, j);
+				double gyy = b2[0] * U(i, jm) + b2[1] * U(i, j) + b2[2] * U(i, jp);
+				double gxy = 0.0;
+				const std::size_t ix[3] = { im, i, ip }, jy[3] = { jm, j, jp };
+				for (int l = 0; l < 3; ++l) {
+					for (int k = 0; k < 3; ++k) gxy += b1[l] * a1[k] * U(ix[k], jy[l]);
+				}
+
+				res.price += w * U(i, j);
+				res.delta_x += w * dx;
+				res.delta_y += w * dy;
+				res.gamma_xx += w * gxx;
+				res.gamma_yy += w * gyy;
+				res.gamma_xy += w * gxy;
+			}
+		}
+		return res;
+	}
+
+	// Grid from lo to hi with n nodes, concentrated around centre; c sets the width of the concentration
+	inline static std::vector<double> SinhGrid(double lo, double hi, double centre, double c, std::size_t n) {
+		if (n < 2 || hi <= lo || c <= 0.0) throw std::invalid_argument("Invalid ADI grid");
+		double a = asinh((lo - centre) / c), b = asinh((hi - centre) / c);
+		std::vector<double> z(n);
+		for (std::size_t k = 0; k < n; ++k) z[k] = centre + c * sinh(a + (b - a) * static_cast<double>(k) / static_cast<double>(n - 1));
+		z.front() = lo;
+		z.back() = hi;
+		return z;
+	}
+
+	// Destructor
+	~ADIEngine() {}
+};
+
+// Heston vanilla with ADI: x = S, y = v
+class HestonADI {
+private:
+	HestonParameters p;
+	double r;	// Interest rate
+	double q;	// Dividend yield
+
+public:
+
+	// Constructor
+	explicit HestonADI(const HestonParameters & p_, double r_, double q_ = 0.0) : p(p_), r(r_), q(q_) {
+		if (p.xi <= 0.0 || p.kappa <= 0.0 || p.v0 < 0.0) throw std::invalid_argument("Heston ADI needs kappa > 0, xi > 0 and v0 >= 0");
+	}
+
+	// Call or put price with nS x nv nodes and NT steps; delta_x is the delta, delta_y the sensitivity to v
+	// The S grid reaches 8 K and is concentrated at the strike, the v grid reaches 5 and is concentrated at zero
+	inline ADIResults Price(bool call, double S, double K, double T, std::size_t nS = 100, std::size_t nv = 50, std::size_t NT = 50,
+		ADIScheme scheme = ADIScheme::CraigSneyd, unsigned threads = 0) const {
+
+		const HestonParameters h = p;
+		const double rate = r, yield = q;
+
+		ADIProblem problem;
+		problem.x = ADIEngine::SinhGrid(0.0, std::max(8.0 * K, 2.0 * S), K, K / 5.0, nS);
+		problem.y = ADIEngine::SinhGrid(0.0, std::max(5.0, 3.0 * p.v0), 0.0, 5.0 / 500.0, nv);
+		problem.r = r;
+		problem.coefficients = [h, rate, yield](double s, double v, double * c) {
+			c[0] = 0.5 * v * s * s;
+			c[1] = 0.5 * h.xi * h.xi * v;
+			c[2] = h.rho * h.xi * v * s;
+			c[3] = (rate - yield) * s;
+			c[4] = h.kappa * (h.theta - v);
+		};
+		problem.payoff = [call, K](double s, double) { return call ? std::max(s - K, 0.0) : std::max(K - s, 0.0); };
+
+		ADIEngine engine(problem);
+		return engine.Evaluate(engine.Solve(T, NT, scheme, 0.5, 2, threads), S, p.v0);
+	}
+
+	// Destructor
+	~HestonADI() {}
+};
+
+// Option on two correlated GBM assets with ADI: x = S1, y = S2
+class TwoAssetADI {
+private:
+	double vol1, vol2;	// Volatilities
+	double rho;			// Correlation
+	double r;			// Interest rate
+	double q1, q2;		// Dividend yields
+
+public:
+
+	// Constructor
+	explicit TwoAssetADI(double vol1_, double vol2_, double rho_, double r_, double q1_ = 0.0, double q2_ = 0.0)
+		: vol1(vol1_), vol2(vol2_), rho(rho_), r(r_), q1(q1_), q2(q2_) {
+		if (vol1 <= 0.0 || vol2 <= 0.0 || std::abs(rho) > 1.0) throw std::invalid_argument("Two-asset ADI needs positive volatilities and |rho| <= 1");
+	}
+
+	// Price of payoff(S1_T, S2_T) with n1 x n2 nodes and NT steps; each grid reaches six standard deviations and is
+	// concentrated at the spot. The payoff must be linear far from the spots, as for calls, puts, spreads and exchanges
+	inline ADIResults Price(const std::function<double(double, double)> & payoff, double S1, double S2, double T,
+		std::size_t n1 = 100, std::size_t n2 = 100, std::size_t NT = 50, ADIScheme scheme = ADIScheme::CraigSneyd, unsigned threads = 0) const {
+
+		const double s1 = vol1, s2 = vol2, c12 = rho * vol1 * vol2, b1 = r - q1, b2 = r - q2;
+
+		ADIProblem problem;
+		problem.x = ADIEngine::SinhGrid(0.0, S1 * std::max(4.0, exp(6.0 * vol1 * sqrt(T))), S1, S1 / 5.0, n1);
+		problem.y = ADIEngine::SinhGrid(0.0, S2 * std::max(4.0, exp(6.0 * vol2 * sqrt(T))), S2, S2 / 5.0, n2);
+		problem.r = r;
+		problem.coefficients = [s1, s2, c12, b1, b2](double x, double y, double * c) {
+			c[0] = 0.5 * s1 * s1 * x * x;
+			c[1] = 0.5 * s2 * s2 * y * y;
+			c[2] = c12 * x * y;
+			c[3] = b1 * x;
+			c[4] = b2 * y;
+		};
+		problem.payoff = payoff;
+
+		ADIEngine engine(problem);
+		return engine.Evaluate(engine.Solve(T, NT, scheme, 0.5, 2, threads), S1, S2);
+	}
+
+	// Destructor
+	~TwoAssetADI() {}
+};
+
+#endif // !ADI_HPP
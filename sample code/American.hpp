@@ -0,0 +1,306 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ===================================================================================================================================================
+*
+*	Monte Carlo Option Pricing Application - American options: regression lower bound and Andersen-Broadie dual upper bound
+*
+*/
+
+/*   The option can be exercised on the dates t_1, ..., t_M of a uniform grid (a Bermudan approximation of the American).
+*
+*    Lower bound (Longstaff-Schwartz): the continuation value is regressed on 1, x, x^2, x^3 (x = S / K) over the
+*    in-the-money paths, backwards from maturity. The fitted exercise policy is then applied to a new, independent
+*    set of paths, so the estimate is biased low.
+*
+*    Upper bound (Andersen-Broadie): with V the discounted value of the policy and Q_k = E_k[V_(k+1)] its continuation
+*    value, M_k = sum (V_(j+1) - Q_j) is a martingale with M_0 = 0, and for any such martingale
+*        V_0 <= E[max_k (h_k - M_k)] = L_0 + E[max_k (h_k - M_k) - L_0]
+*    where the last expectation is the duality gap. Q_k is estimated by nested simulation along each outer path.
+*    Since the optimal policy never exercises out of the money, the max runs over the in-the-money dates and the
+*    maturity only, and across out-of-the-money dates the increments telescope, so the nested simulation is needed
+*    only where the payoff is positive. Nested sub-paths stop at the first date where the policy exercises.
+*
+*    Outer paths are independent tasks on the parallel loop, each seeded from its index, so the bounds do not depend
+*    on the number of threads.
+*/
+
+// Multiple inclusion guards
+#ifndef AMERICAN_HPP
+#define AMERICAN_HPP
+
+#include <vector>
+#include <tuple>
+#include <random>
+#include <stdexcept>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+#include "LinearAlgebra.hpp"
+#include "TimeGrid.hpp"
+#include "Parallel.hpp"
+
+// Alias for the American output tuple:
+// lower bound, its standard error, upper bound, its standard error, number of lower bound paths, number of outer paths
+using AmericanResults = std::tuple<double, double, double, double, unsigned long, unsigned long>;
+
+// Exercise policy fitted by regression
+class ExercisePolicy {
+private:
+	bool call;
+	double K;
+	std::size_t dates;						// Number of exercise dates M
+	std::vector<double> coefficients;		// M x basis, row k - 1 for date t_k, continuation value at t_k in money of t_k
+
+public:
+	static constexpr std::size_t basis = 4;
+
+	// Constructor
+	explicit ExercisePolicy(bool call_, double K_, std::size_t dates_) : call(call_), K(K_), dates(dates_), coefficients(dates_ * basis, 0.0) {}
+
+	// Payoff of immediate exercise
+	inline double Payoff(double S) const { return call ? std::max(S - K, 0.0) : std::max(K - S, 0.0); }
+
+	// Regression basis at S
+	inline void Basis(double S, double * f) const {
+		double x = S / K;
+		f[0] = 1.0;
+		f[1] = x;
+		f[2] = x * x;
+		f[3] = x * x * x;
+	}
+
+	// Estimated continuation value at date k (1 <= k <= M), in money of t_k
+	inline double Continuation(std::size_t k, double S) const {
+		if (k >= dates) return 0.0;
+		double f[basis];
+		Basis(S, f);
+		const double * c = coefficients.data() + (k - 1) * basis;
+		double v = 0.0;
+		for (std::size_t i = 0; i < basis; ++i) v += c[i] * f[i];
+		return v;
+	}
+
+	// Exercise decision at date k: in the money, and the payoff is at least the continuation value
+	inline bool Exercise(std::size_t k, double S) const {
+		double h = Payoff(S);
+		return h > 0.0 && h >= Continuation(k, S);
+	}
+
+	// Setter
+	inline void setCoefficients(std::size_t k, const std::vector<double> & c) {
+		std::copy(c.begin(), c.end(), coefficients.begin() + (k - 1) * basis);
+	}
+
+	// Getter
+	inline std::size_t Dates() const { return dates; }
+
+	// Destructor
+	~ExercisePolicy() {}
+};
+
+// American option pricing engine under GBM
+class AmericanEngine {
+private:
+	double r;		// Interest rate
+	double q;		// Dividend yield
+	double vol;		// Volatility
+
+	// Exact GBM step over dt
+	inline double Step(double S, double dt, double z) const {
+		return S * exp((r - q - 0.5 * vol * vol) * dt + vol * sqrt(dt) * z);
+	}
+
+	// Continuation value at date k from S: mean over n sub-paths of the payoff of the policy, discounted to t_k
+	// Sub-paths stop at the first exercise
+	inline double NestedContinuation(const ExercisePolicy & policy, const TimeGrid & grid, std::size_t k, double S,
+		unsigned long n, std::mt19937_64 & eng) const {
+
+		std::normal_distribution<double> nd(0.0, 1.0);
+		const std::size_t M = grid.Steps();
+		double sum = 0.0;
+
+		for (unsigned long i = 0; i < n; ++i) {
+			double s = S;
+			for (std::size_t j = k + 1; j <= M; ++j) {
+				s = Step(s, grid.Dt(j - 1), nd(eng));
+				if (policy.Exercise(j, s)) {
+					sum += policy.Payoff(s) * exp(-r * (grid.Time(j) - grid.Time(k)));
+					break;
+				}
+			}
+		}
+		return sum / static_cast<double>(n);
+	}
+
+public:
+
+	// Constructor
+	explicit AmericanEngine(double r_, double vol_, double q_ = 0.0) : r(r_), q(q_), vol(vol_) {}
+
+	// Longstaff-Schwartz regression of the exercise policy on NSIM paths, with NExercise exercise dates up to T
+	inline ExercisePolicy Fit(bool call, double S, double K, double T, std::size_t NExercise, unsigned long NSIM, unsigned long seed = 5489u) const {
+
+		if (NExercise == 0 || NSIM < 2 * ExercisePolicy::basis) throw std::invalid_argument("Invalid American regression parameters");
+
+		const TimeGrid grid = TimeGrid::Uniform(T, NExercise);
+		const std::size_t M = NExercise, B = ExercisePolicy::basis;
+		ExercisePolicy policy(call, K, M);
+
+		// Paths on the exercise dates, M x NSIM
+		std::mt19937_64 eng(seed);
+		std::normal_distribution<double> nd(0.0, 1.0);
+		std::vector<double> paths(M * NSIM);
+		for (unsigned long p = 0; p < NSIM; ++p) {
+			double s = S;
+			for (std::size_t k = 1; k <= M; ++k) {
+				s = Step(s, grid.Dt(k - 1), nd(eng));
+				paths[(k - 1) * NSIM + p] = s;
+			}
+		}
+
+		// Cash flow of each path under the policy, in money of the current date
+		std::vector<double> cash(NSIM);
+		for (unsigned long p = 0; p < NSIM; ++p) cash[p] = policy.Payoff(paths[(M - 1) * NSIM + p]);
+
+		for (std::size_t k = M - 1; k >= 1; --k) {
+
+			double growth = exp(-r * grid.Dt(k));
+			for (auto & c : cash) c *= growth;
+
+			// Normal equations over the in-the-money paths
+			std::vector<double> A(B * B, 0.0), b(B, 0.0);
+			double f[ExercisePolicy::basis];
+			unsigned long itm = 0;
+			for (unsigned long p = 0; p < NSIM; ++p) {
+				double s = paths[(k - 1) * NSIM + p];
+				if (policy.Payoff(s) <= 0.0) continue;
+				policy.Basis(s, f);
+				for (std::size_t i = 0; i < B; ++i) {
+					b[i] += f[i] * cash[p];
+					for (std::size_t j = 0; j < B; ++j) A[i * B + j] += f[i] * f[j];
+				}
+				itm++;
+			}
+
+			// Too few paths to regress: never exercise early on this date
+			std::vector<double> c(B, 0.0);
+			if (itm > B && LinearAlgebra::Solve(A, b, B)) c = b;
+			else c[0] = std::numeric_limits<double>::max();
+			policy.setCoefficients(k, c);
+
+			for (unsigned long p = 0; p < NSIM; ++p) {
+				double s = paths[(k - 1) * NSIM + p];
+				if (policy.Exercise(k, s)) cash[p] = policy.Payoff(s);
+			}
+		}
+
+		return policy;
+	}
+
+	// Lower bound: the policy applied to NSIM independent paths, returns the price and its standard error
+	inline std::tuple<double, double> LowerBound(const ExercisePolicy & policy, double S, double T, unsigned long NSIM,
+		unsigned long seed = 5489u, std::size_t block_size = 4096, unsigned threads = 0) const {
+
+		if (NSIM < 2 || block_size == 0) throw std::invalid_argument("American lower bound needs at least two paths");
+
+		const TimeGrid grid = TimeGrid::Uniform(T, policy.Dates());
+		const std::size_t M = policy.Dates();
+
+		BlockSums sums(BlockCount(NSIM, block_size), 1);
+
+		ParallelFor(0, sums.Blocks(), [&](std::size_t b, unsigned) {
+
+			std::size_t count = std::min<std::size_t>(block_size, NSIM - b * block_size);
+			std::mt19937_64 eng(BlockSeed(seed, b));
+			std::normal_distribution<double> nd(0.0, 1.0);
+
+			double * slots = sums.Slots(b, 0);
+			for (std::size_t p = 0; p < count; ++p) {
+				double s = S, value = 0.0;
+				for (std::size_t k = 1; k <= M; ++k) {
+					s = Step(s, grid.Dt(k - 1), nd(eng));
+					if (policy.Exercise(k, s)) {
+						value = policy.Payoff(s) * exp(-r * grid.Time(k));
+						break;
+					}
+				}
+				BlockSums::Add(slots, value);
+			}
+		}, threads);
+
+		// The values are discounted path by path, the blocks are reduced in order
+		std::vector<double> mean, SE;
+		sums.Estimate(1.0, NSIM, mean, SE);
+		return std::make_tuple(mean[0], SE[0]);
+	}
+
+	// Upper bound from N_outer outer paths with N_inner sub-paths per nested continuation value, given the lower bound L0
+	// Returns the upper bound and its standard error (including the one of the lower bound)
+	inline std::tuple<double, double> UpperBound(const ExercisePolicy & policy, double S, double T, double L0, double L0_SE,
+		unsigned long N_outer, unsigned long N_inner, unsigned long seed = 5489u, unsigned threads = 0) const {
+
+		if (N_outer < 2 || N_inner == 0) throw std::invalid_argument("American upper bound needs outer and inner paths");
+
+		const TimeGrid grid = TimeGrid::Uniform(T, policy.Dates());
+		const std::size_t M = policy.Dates();
+		std::vector<double> penalty(N_outer, 0.0);
+
+		// One task per outer path: the nested simulations make their cost uneven, the loop balances them
+		ParallelFor(0, N_outer, [&](std::size_t p, unsigned) {
+
+			std::mt19937_64 eng(BlockSeed(seed, p));
+			std::normal_distribution<double> nd(0.0, 1.0);
+
+			double s = S;
+			double martingale = 0.0;	// M_k, discounted to 0
+			double previous_Q = L0;		// Q at the previous in-the-money date, discounted to 0, Q_0 = L_0
+			double max_gap = -std::numeric_limits<double>::max();	// max_k (h_k - M_k)
+
+			for (std::size_t k = 1; k <= M; ++k) {
+
+				s = Step(s, grid.Dt(k - 1), nd(eng));
+				double h = policy.Payoff(s);
+				if (h <= 0.0 && k < M) continue;
+
+				double df = exp(-r * grid.Time(k));
+				double Q = (k < M) ? NestedContinuation(policy, grid, k, s, N_inner, eng) * df : 0.0;
+				double V = policy.Exercise(k, s) ? h * df : Q;
+
+				martingale += V - previous_Q;
+				max_gap = std::max(max_gap, h * df - martingale);
+				previous_Q = Q;
+			}
+			penalty[p] = max_gap - L0;
+		}, threads);
+
+		double sum = 0.0, sum_sq = 0.0;
+		for (auto x : penalty) {
+			sum += x;
+			sum_sq += x * x;
+		}
+		double N = static_cast<double>(N_outer);
+		double mean = sum / N;
+		double SE = sqrt(std::max(sum_sq / N - mean * mean, 0.0) / (N - 1.0));
+		return std::make_tuple(L0 + mean, sqrt(SE * SE + L0_SE * L0_SE));
+	}
+
+	// Both bounds: regression on NSIM_fit paths, lower bound on NSIM paths, upper bound on N_outer x N_inner paths
+	inline AmericanResults Price(bool call, double S, double K, double T, std::size_t NExercise, unsigned long NSIM_fit,
+		unsigned long NSIM, unsigned long N_outer, unsigned long N_inner, unsigned long seed = 5489u, unsigned threads = 0) const {
+
+		// Independent streams for the three stages
+		ExercisePolicy policy = Fit(call, S, K, T, NExercise, NSIM_fit, seed);
+		auto lower = LowerBound(policy, S, T, NSIM, seed + 1, 4096, threads);
+		auto upper = UpperBound(policy, S, T, std::get<0>(lower), std::get<1>(lower), N_outer, N_inner, seed + 2, threads);
+
+		return std::make_tuple(std::get<0>(lower), std::get<1>(lower), std::get<0>(upper), std::get<1>(upper), NSIM, N_outer);
+	}
+
+	// Destructor
+	~AmericanEngine() {}
+};
+
+#endif // !AMERICAN_HPP
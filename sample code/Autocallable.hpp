@@ -0,0 +1,204 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ===================================================================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Autocallable engine with early redemption and live-path compaction
+*
+*/
+
+/*   An autocallable pays a coupon on each observation date where the underlying is above the coupon barrier (with
+*    memory, the missed coupons are paid as well), and redeems early at par on the first date the underlying is above
+*    the autocall barrier. At maturity, if the knock-in barrier was breached and the underlying is below its initial
+*    level, the holder is short a put and receives the notional times the performance.
+*
+*    Paths are simulated in blocks held as separate arrays (structure of arrays). On each observation date the paths
+*    that redeem are removed from the block with a stable stream compaction, so the later dates only step and test
+*    the live paths. Redemption counts and the expected life are accumulated on the fly for MIS.
+*/
+
+// Multiple inclusion guards
+#ifndef AUTOCALLABLE_HPP
+#define AUTOCALLABLE_HPP
+
+#include <vector>
+#include <tuple>
+#include <random>
+#include <memory>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+#include "TimeGrid.hpp"
+#include "DiscountCurve.hpp"
+
+// Contract terms of an autocallable, barriers as fractions of the initial stock price
+struct AutocallTerms {
+	ObservationSchedule		dates;				// Observation dates, the last one is the maturity
+	std::vector<double>		autocall_barrier;	// Autocall barrier on each date
+	std::vector<double>		coupon;				// Coupon on each date, as a fraction of the notional
+	double					coupon_barrier;		// Coupon barrier
+	bool					memory;				// Missed coupons are paid on the next coupon date
+	double					knock_in_barrier;	// Knock-in barrier of the put at maturity
+	double					monitoring_dt;		// Step between knock-in checks, 0 to check on the observation dates only
+	double					notional;
+};
+
+// Alias for the autocallable output tuple:
+// price, standard error, number of paths, redemptions per observation date, sum of the lives of all paths, number of knocked-in paths
+using AutocallResults = std::tuple<double, double, unsigned long, std::vector<unsigned long>, double, unsigned long>;
+
+// Autocallable pricing engine under GBM
+class AutocallEngine {
+private:
+	double r;		// Interest rate
+	double vol;		// Volatility
+	std::shared_ptr<const DiscountCurve> discount_curve;	// Optional term structure of rates
+
+	inline double Discount(double t) const {
+		return discount_curve ? discount_curve->Discount(t) : exp(-r * t);
+	}
+
+public:
+
+	// Constructors
+	// Barriers are fractions of the initial price, so the engine simulates the performance and needs no stock price
+	explicit AutocallEngine(double r_, double vol_) : r(r_), vol(vol_) {}
+
+	// Setter
+	inline void setDiscountCurve(const std::shared_ptr<const DiscountCurve> & curve) { discount_curve = curve; }
+
+	// Price the autocallable with NSIM paths, simulated in blocks of block_size paths
+	inline AutocallResults Price(const AutocallTerms & terms, unsigned long NSIM, unsigned long seed = 5489u, std::size_t block_size = 4096) const {
+
+		std::size_t ndates = terms.dates.size();
+		if (ndates == 0 || terms.autocall_barrier.size() != ndates || terms.coupon.size() != ndates) {
+			throw std::invalid_argument("Autocallable terms need one autocall barrier and one coupon per observation date");
+		}
+		if (NSIM == 0 || block_size == 0) throw std::invalid_argument("Autocallable needs at least one path");
+
+		double T = *std::max_element(terms.dates.begin(), terms.dates.end());
+		TimeGrid grid = TimeGrid::FromSchedule(T, terms.dates, terms.monitoring_dt);
+		if (grid.Observations() != ndates) throw std::invalid_argument("Autocallable observation dates must be distinct and positive");
+
+		// Per-step exact GBM transition constants, drifting at the forward rate of the curve over the step when it is set
+		std::vector<double> drift(grid.Steps()), diffusion(grid.Steps()), df(grid.Steps() + 1);
+		for (std::size_t j = 0; j < grid.Steps(); ++j) {
+			double rate = discount_curve ? discount_curve->Forward(grid.Time(j), grid.Time(j + 1)) : r;
+			drift[j] = (rate - 0.5 * vol * vol) * grid.Dt(j);
+			diffusion[j] = vol * grid.SqrtDt(j);
+		}
+		for (std::size_t j = 0; j <= grid.Steps(); ++j) df[j] = Discount(grid.Time(j));
+
+		// Sorted terms so that observation d matches the d-th observed date of the grid
+		std::vector<std::size_t> order(ndates);
+		for (std::size_t d = 0; d < ndates; ++d) order[d] = d;
+		std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return terms.dates[a] < terms.dates[b]; });
+
+		// Live block, structure of arrays
+		std::vector<double> log_spot(block_size), missed(block_size), pv(block_size);
+		std::vector<char> knocked(block_size);
+		std::vector<double> z(block_size);
+
+		std::mt19937_64 eng(seed);
+		std::normal_distribution<double> n(0.0, 1.0);
+
+		double log_ki = log(terms.knock_in_barrier);
+		double log_cb = log(terms.coupon_barrier);
+
+		// Streaming statistics
+		double sum = 0.0, sum_sq = 0.0, life = 0.0;
+		std::vector<unsigned long> redemptions(ndates, 0);
+		unsigned long knock_ins = 0;
+
+		// Finalize a path that leaves the block
+		auto redeem = [&](double value, double t, std::size_t d, bool ki) {
+			sum += value;
+			sum_sq += value * value;
+			life += t;
+			redemptions[d]++;
+			if (ki) knock_ins++;
+		};
+
+		for (unsigned long first = 0; first < NSIM; first += block_size) {
+
+			std::size_t live = static_cast<std::size_t>(std::min<unsigned long>(block_size, NSIM - first));
+
+			// Log-performance against the initial price, so the barriers are compared in log space
+			std::fill(log_spot.begin(), log_spot.begin() + live, 0.0);
+			std::fill(missed.begin(), missed.begin() + live, 0.0);
+			std::fill(pv.begin(), pv.begin() + live, 0.0);
+			std::fill(knocked.begin(), knocked.begin() + live, 0);
+
+			std::size_t d = 0;
+			for (std::size_t j = 0; j < grid.Steps() && live > 0; ++j) {
+
+				// Exact step of the live paths only
+				for (std::size_t p = 0; p < live; ++p) z[p] = n(eng);
+				const double mu = drift[j], sg = diffusion[j];
+				for (std::size_t p = 0; p < live; ++p) {
+					log_spot[p] += mu + sg * z[p];
+					knocked[p] |= static_cast<char>(log_spot[p] < log_ki);
+				}
+
+				if (!grid.IsObservation(j + 1)) continue;
+
+				// Observation date: coupons, autocall, and maturity redemption
+				std::size_t k = order[d];
+				double t = grid.Time(j + 1);
+				double coupon = terms.coupon[k] * terms.notional;
+				double discount = df[j + 1];
+				double log_ab = log(terms.autocall_barrier[k]);
+				bool maturity = (d + 1 == ndates);
+
+				for (std::size_t p = 0; p < live; ++p) {
+					bool pays = log_spot[p] >= log_cb;
+					if (terms.memory) {
+						pv[p] += pays ? (coupon + missed[p]) * discount : 0.0;
+						missed[p] = pays ? 0.0 : missed[p] + coupon;
+					}
+					else {
+						pv[p] += pays ? coupon * discount : 0.0;
+					}
+				}
+
+				// Stream compaction: redeemed paths are finalized, live paths are packed to the front of the block
+				std::size_t w = 0;
+				for (std::size_t p = 0; p < live; ++p) {
+
+					bool called = log_spot[p] >= log_ab;
+					if (called || maturity) {
+						double redemption = terms.notional;
+						if (!called && knocked[p] && log_spot[p] < 0.0) redemption *= exp(log_spot[p]);
+						redeem(pv[p] + redemption * discount, t, d, knocked[p] != 0);
+						continue;
+					}
+
+					log_spot[w] = log_spot[p];
+					missed[w] = missed[p];
+					pv[w] = pv[p];
+					knocked[w] = knocked[p];
+					w++;
+				}
+				live = w;
+				d++;
+			}
+		}
+
+		double N = static_cast<double>(NSIM);
+		double price = sum / N;
+		double SE = (NSIM > 1) ? sqrt(std::max(sum_sq - N * price * price, 0.0) / (N - 1.0) / N) : 0.0;
+
+		// Redemptions by original date order
+		std::vector<unsigned long> by_date(ndates);
+		for (std::size_t d = 0; d < ndates; ++d) by_date[order[d]] = redemptions[d];
+
+		return std::make_tuple(price, SE, NSIM, by_date, life, knock_ins);
+	}
+
+	// Destructor
+	~AutocallEngine() {}
+};
+
+#endif // !AUTOCALLABLE_HPP
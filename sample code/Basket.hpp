@@ -0,0 +1,359 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ==============================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Basket and index options on correlated GBM constituents
+*
+*/
+
+/*   Each constituent follows dS_i = (r - q_i) S_i dt + vol_i S_i dW_i, with the correlation of the W_i given by a
+*    factor model. The option pays max(w . S_T - K, 0) for a call. Paths are simulated in blocks held as count x d
+*    matrices of log spots, and every step draws count x k factor normals and count x d idiosyncratic normals that
+*    the factor model turns into correlated increments with one blocked matrix product. The blocks run in parallel,
+*    each with its own seed, so the result does not depend on the number of threads.
+*
+*    PriceQMC() draws each path as one point of dimension NSteps x d from a normal generator (i.e. a lattice rule or a
+*    Sobol sequence) and maps it to Brownian increments with the PCA construction over time and assets, so that the
+*    leading coordinates of the point set drive the directions of largest variance.
+*
+*    PriceCV() simulates the geometric basket G = M1 prod (S_i / F_i)^a_i alongside the arithmetic one, with F_i the
+*    forwards, M1 = sum w_i F_i and a_i = w_i F_i / M1. G is lognormal, so its option has a closed form computed once per
+*    job, and it is used as a control variate with the regression coefficient estimated from the same paths. LevyPrice()
+*    is the moment-matching approximation of Levy: a lognormal with the first two moments of the arithmetic basket.
+*/
+
+// Multiple inclusion guards
+#ifndef BASKET_HPP
+#define BASKET_HPP
+
+#include <vector>
+#include <tuple>
+#include <random>
+#include <memory>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+#include "FactorModel.hpp"
+#include "PathConstruction.hpp"
+#include "TimeGrid.hpp"
+#include "DiscountCurve.hpp"
+#include "Parallel.hpp"
+#include "BlackScholes.hpp"
+
+// Basket constituents: initial spots, basket weights, volatilities and continuous dividend yields
+struct BasketConstituents {
+	std::vector<double> spots;
+	std::vector<double> weights;
+	std::vector<double> vols;
+	std::vector<double> yields;
+};
+
+// Alias for the basket output: price, standard error, number of paths
+using BasketResults = std::tuple<double, double, unsigned long>;
+
+// Basket option pricing engine
+class BasketEngine {
+private:
+	BasketConstituents assets;
+	FactorCorrelation correlation;
+	double r;		// Interest rate
+	std::shared_ptr<const DiscountCurve> discount_curve;	// Optional term structure of rates
+	std::shared_ptr<PCAConstructionCache> pca_cache;		// PCA constructions, shared between engines on the same model
+
+	// Forward rate of each step of the grid
+	inline std::vector<double> StepRates(const TimeGrid & grid) const {
+		std::vector<double> rate(grid.Steps());
+		for (std::size_t j = 0; j < grid.Steps(); ++j) rate[j] = discount_curve ? discount_curve->Forward(grid.Time(j), grid.Time(j + 1)) : r;
+		return rate;
+	}
+
+	// Per-asset log drift per unit time, without the rate, and log of the initial spots
+	inline void LogDrifts(std::vector<double> & drift, std::vector<double> & log_spot0) const {
+		std::size_t d = correlation.Dimension();
+		drift.resize(d);
+		log_spot0.resize(d);
+		for (std::size_t i = 0; i < d; ++i) {
+			drift[i] = -assets.yields[i] - 0.5 * assets.vols[i] * assets.vols[i];
+			log_spot0[i] = log(assets.spots[i]);
+		}
+	}
+
+	// Forward of each asset to T
+	inline std::vector<double> Forwards(double T, double discount) const {
+		std::vector<double> F(correlation.Dimension());
+		for (std::size_t i = 0; i < F.size(); ++i) F[i] = assets.spots[i] * exp(-assets.yields[i] * T) / discount;
+		return F;
+	}
+
+	// Log spots at the end of the grid of the count paths of block b, as a count x d matrix
+	inline void SimulateBlock(std::size_t b, std::size_t count, const TimeGrid & grid, const std::vector<double> & rate,
+		const std::vector<double> & drift, const std::vector<double> & log_spot0, unsigned long seed, std::vector<double> & x) const {
+
+		const std::size_t d = correlation.Dimension();
+		const std::size_t k = correlation.Factors();
+
+		std::mt19937_64 eng(BlockSeed(seed, b));
+		std::normal_distribution<double> nd(0.0, 1.0);
+
+		// Block matrices: log spots, factor normals, idiosyncratic normals, correlated normals
+		x.resize(count * d);
+		std::vector<double> Z(count * k), eps(count * d), W(count * d);
+		for (std::size_t p = 0; p < count; ++p) std::copy(log_spot0.begin(), log_spot0.end(), x.begin() + p * d);
+
+		for (std::size_t j = 0; j < grid.Steps(); ++j) {
+
+			const double dt = grid.Dt(j), dt_sq = grid.SqrtDt(j);
+			for (auto & z : Z) z = nd(eng);
+			for (auto & e : eps) e = nd(eng);
+			correlation.Correlate(Z.data(), eps.data(), W.data(), count);
+
+			for (std::size_t p = 0; p < count; ++p) {
+				double * xp = x.data() + p * d;
+				const double * wp = W.data() + p * d;
+				for (std::size_t i = 0; i < d; ++i) xp[i] += (rate[j] + drift[i]) * dt + assets.vols[i] * dt_sq * wp[i];
+			}
+		}
+	}
+
+	// Geometric basket: weights a_i, log of M1 and mean and variance of ln G_T
+	// The weights need w_i F_i > 0, so that the geometric basket is defined
+	inline void Geometric(double T, double discount, std::vector<double> & a, double & log_M1, double & mean, double & variance) const {
+
+		const std::size_t d = correlation.Dimension();
+		const std::vector<double> F = Forwards(T, discount);
+
+		double M1 = 0.0;
+		for (std::size_t i = 0; i < d; ++i) {
+			if (assets.weights[i] * F[i] <= 0.0) throw std::invalid_argument("Geometric basket needs positive weights");
+			M1 += assets.weights[i] * F[i];
+		}
+		a.resize(d);
+		for (std::size_t i = 0; i < d; ++i) a[i] = assets.weights[i] * F[i] / M1;
+
+		log_M1 = log(M1);
+		mean = log_M1;
+		variance = 0.0;
+		for (std::size_t i = 0; i < d; ++i) {
+			mean -= 0.5 * a[i] * assets.vols[i] * assets.vols[i] * T;
+			for (std::size_t j = 0; j < d; ++j) {
+				variance += a[i] * a[j] * correlation.ImpliedCorrelation(i, j) * assets.vols[i] * assets.vols[j] * T;
+			}
+		}
+	}
+
+	// Undiscounted payoff of the basket from the log spots of one path
+	inline double Payoff(bool call, double K, const double * x) const {
+		double basket = 0.0;
+		for (std::size_t i = 0; i < correlation.Dimension(); ++i) basket += assets.weights[i] * exp(x[i]);
+		return call ? std::max(basket - K, 0.0) : std::max(K - basket, 0.0);
+	}
+
+	// Discounted price and standard error from the block sums, reduced in block order so the result is reproducible
+	inline static BasketResults Reduce(const BlockSums & sums, unsigned long NSIM, double discount) {
+		std::vector<double> price, error;
+		sums.Estimate(discount, NSIM, price, error);
+		return std::make_tuple(price[0], error[0], NSIM);
+	}
+
+public:
+
+	// Constructors
+	explicit BasketEngine(const BasketConstituents & assets_, const FactorCorrelation & correlation_, double r_)
+		: assets(assets_), correlation(correlation_), r(r_), pca_cache(std::make_shared<PCAConstructionCache>()) {
+
+		std::size_t d = correlation.Dimension();
+		if (assets.spots.size() != d || assets.weights.size() != d || assets.vols.size() != d) {
+			throw std::invalid_argument("Basket needs one spot, weight and volatility per asset of the correlation");
+		}
+		if (assets.yields.empty()) assets.yields.assign(d, 0.0);
+		if (assets.yields.size() != d) throw std::invalid_argument("Basket needs one dividend yield per asset");
+	}
+
+	// Setters
+	inline void setDiscountCurve(const std::shared_ptr<const DiscountCurve> & curve) { discount_curve = curve; }
+	inline void setPCACache(const std::shared_ptr<PCAConstructionCache> & cache) { pca_cache = cache; }
+
+	// Getters
+	inline const BasketConstituents & Constituents() const { return assets; }
+	inline const FactorCorrelation & Correlation() const { return correlation; }
+
+	// Price a call or put on the basket with NSIM paths of NSteps steps
+	// With constant coefficients the exact GBM step needs a single step for a European payoff
+	inline BasketResults Price(bool call, double K, double T, unsigned long NSIM, unsigned long NSteps = 1,
+		unsigned long seed = 5489u, std::size_t block_size = 256, unsigned threads = 0) const {
+
+		if (NSIM < 2 || block_size == 0) throw std::invalid_argument("Basket needs at least two paths");
+
+		const std::size_t d = correlation.Dimension();
+		const TimeGrid grid = TimeGrid::Uniform(T, NSteps);
+		const double discount = discount_curve ? discount_curve->Discount(T) : exp(-r * T);
+
+		const std::vector<double> rate = StepRates(grid);
+		std::vector<double> drift, log_spot0;
+		LogDrifts(drift, log_spot0);
+
+		BlockSums sums(BlockCount(NSIM, block_size), 1);
+
+		ParallelFor(0, sums.Blocks(), [&](std::size_t b, unsigned) {
+
+			std::size_t first = b * block_size;
+			std::size_t count = std::min<std::size_t>(block_size, NSIM - first);
+
+			std::vector<double> x;
+			SimulateBlock(b, count, grid, rate, drift, log_spot0, seed, x);
+
+			double * s = sums.Slots(b, 0);
+			for (std::size_t p = 0; p < count; ++p) BlockSums::Add(s, Payoff(call, K, x.data() + p * d));
+		}, threads);
+
+		return Reduce(sums, NSIM, discount);
+	}
+
+	// Closed-form price of a call or put on the geometric basket G
+	inline double GeometricPrice(bool call, double K, double T) const {
+		const double discount = discount_curve ? discount_curve->Discount(T) : exp(-r * T);
+		std::vector<double> a;
+		double log_M1, mean, variance;
+		Geometric(T, discount, a, log_M1, mean, variance);
+		return BlackScholes::Black(call, exp(mean + 0.5 * variance), K, T, discount, sqrt(variance / T));
+	}
+
+	// Levy approximation of a call or put on the arithmetic basket: lognormal with the mean M1 and second moment M2
+	// of the basket, M2 = sum w_i w_j F_i F_j exp(rho_ij vol_i vol_j T)
+	inline double LevyPrice(bool call, double K, double T) const {
+		const std::size_t d = correlation.Dimension();
+		const double discount = discount_curve ? discount_curve->Discount(T) : exp(-r * T);
+		const std::vector<double> F = Forwards(T, discount);
+
+		double M1 = 0.0, M2 = 0.0;
+		for (std::size_t i = 0; i < d; ++i) {
+			M1 += assets.weights[i] * F[i];
+			for (std::size_t j = 0; j < d; ++j) {
+				M2 += assets.weights[i] * assets.weights[j] * F[i] * F[j]
+					* exp(correlation.ImpliedCorrelation(i, j) * assets.vols[i] * assets.vols[j] * T);
+			}
+		}
+		if (M1 <= 0.0) throw std::invalid_argument("Levy approximation needs a positive basket forward");
+		return BlackScholes::Black(call, M1, K, T, discount, sqrt(std::max(log(M2 / (M1 * M1)), 0.0) / T));
+	}
+
+	// Price a call or put on the basket as Price(), with the geometric basket option as control variate
+	// Same paths as Price() for the same seed; the closed form of the control is computed once, before the simulation
+	inline BasketResults PriceCV(bool call, double K, double T, unsigned long NSIM, unsigned long NSteps = 1,
+		unsigned long seed = 5489u, std::size_t block_size = 256, unsigned threads = 0) const {
+
+		if (NSIM < 2 || block_size == 0) throw std::invalid_argument("Basket needs at least two paths");
+
+		const std::size_t d = correlation.Dimension();
+		const TimeGrid grid = TimeGrid::Uniform(T, NSteps);
+		const double discount = discount_curve ? discount_curve->Discount(T) : exp(-r * T);
+
+		const std::vector<double> rate = StepRates(grid);
+		std::vector<double> drift, log_spot0;
+		LogDrifts(drift, log_spot0);
+
+		// Control: ln G_T = log_M1 + sum a_i (x_i - ln F_i), and its undiscounted expected payoff
+		std::vector<double> a;
+		double log_M1, mean, variance;
+		Geometric(T, discount, a, log_M1, mean, variance);
+		const std::vector<double> F = Forwards(T, discount);
+		double shift = log_M1;
+		for (std::size_t i = 0; i < d; ++i) shift -= a[i] * log(F[i]);
+		const double control_mean = BlackScholes::Black(call, exp(mean + 0.5 * variance), K, T, 1.0, sqrt(variance / T));
+
+		// Per block: sums of the payoff X and the control Y, their squares and cross product
+		BlockSums sums(BlockCount(NSIM, block_size), 1, 5);
+
+		ParallelFor(0, sums.Blocks(), [&](std::size_t b, unsigned) {
+
+			std::size_t first = b * block_size;
+			std::size_t count = std::min<std::size_t>(block_size, NSIM - first);
+
+			std::vector<double> x;
+			SimulateBlock(b, count, grid, rate, drift, log_spot0, seed, x);
+
+			double * s = sums.Slots(b, 0);
+			for (std::size_t p = 0; p < count; ++p) {
+				const double * xp = x.data() + p * d;
+				double log_G = shift;
+				for (std::size_t i = 0; i < d; ++i) log_G += a[i] * xp[i];
+				double G = exp(log_G);
+				double X = Payoff(call, K, xp);
+				double Y = call ? std::max(G - K, 0.0) : std::max(K - G, 0.0);
+				s[0] += X;
+				s[1] += Y;
+				s[2] += X * X;
+				s[3] += Y * Y;
+				s[4] += X * Y;
+			}
+		}, threads);
+
+		// Reduce in block order, then regress the payoff on the control
+		std::vector<double> sum = sums.Total(0);
+
+		double N = static_cast<double>(NSIM);
+		double mX = sum[0] / N, mY = sum[1] / N;
+		double vX = sum[2] / N - mX * mX, vY = sum[3] / N - mY * mY, cXY = sum[4] / N - mX * mY;
+		double beta = (vY > 1e-300) ? cXY / vY : 0.0;
+
+		double price = mX - beta * (mY - control_mean);
+		double SE = sqrt(std::max(vX - beta * cXY, 0.0) / (N - 1.0));
+		return std::make_tuple(discount * price, discount * SE, NSIM);
+	}
+
+	// Price a call or put on the basket with NSIM points of dimension NSteps x d from the generator, mapped to paths
+	// with the PCA construction. The standard error is the one of the sample; for a randomized point set, the error
+	// estimate comes from independent randomizations instead
+	inline BasketResults PriceQMC(bool call, double K, double T, unsigned long NSIM, unsigned long NSteps,
+		const NormalBlockGenerator & generator, std::size_t block_size = 256, unsigned threads = 0) const {
+
+		if (NSIM < 2 || block_size == 0) throw std::invalid_argument("Basket needs at least two paths");
+		if (!generator) throw std::invalid_argument("Basket QMC needs a normal generator");
+
+		const std::size_t d = correlation.Dimension();
+		const TimeGrid grid = TimeGrid::Uniform(T, NSteps);
+		const double discount = discount_curve ? discount_curve->Discount(T) : exp(-r * T);
+		const std::shared_ptr<const PCAPathConstruction> pca = pca_cache->Get(grid, correlation.ImpliedMatrix(), d);
+		const std::size_t m = pca->Dimension();
+
+		const std::vector<double> rate = StepRates(grid);
+		std::vector<double> drift, log_spot0;
+		LogDrifts(drift, log_spot0);
+
+		BlockSums sums(BlockCount(NSIM, block_size), 1);
+
+		ParallelFor(0, sums.Blocks(), [&](std::size_t b, unsigned) {
+
+			unsigned long first = static_cast<unsigned long>(b * block_size);
+			std::size_t count = std::min<std::size_t>(block_size, NSIM - first);
+
+			// Block matrices: input normals, increments, log spots
+			std::vector<double> z(count * m), dW(count * m), x(count * d);
+			generator(first, count, m, z.data());
+			pca->Build(z.data(), dW.data(), count);
+			for (std::size_t p = 0; p < count; ++p) std::copy(log_spot0.begin(), log_spot0.end(), x.begin() + p * d);
+
+			for (std::size_t p = 0; p < count; ++p) {
+				double * xp = x.data() + p * d;
+				const double * wp = dW.data() + p * m;
+				for (std::size_t j = 0; j < grid.Steps(); ++j, wp += d) {
+					const double dt = grid.Dt(j);
+					for (std::size_t i = 0; i < d; ++i) xp[i] += (rate[j] + drift[i]) * dt + assets.vols[i] * wp[i];
+				}
+			}
+
+			double * s = sums.Slots(b, 0);
+			for (std::size_t p = 0; p < count; ++p) BlockSums::Add(s, Payoff(call, K, x.data() + p * d));
+		}, threads);
+
+		return Reduce(sums, NSIM, discount);
+	}
+
+	// Destructor
+	~BasketEngine() {}
+};
+
+#endif // !BASKET_HPP
@@ -0,0 +1,170 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ==============================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Black-Scholes closed-form kernels, scalar and batch
+*
+*/
+
+// Multiple inclusion guards
+#ifndef BLACKSCHOLES_HPP
+#define BLACKSCHOLES_HPP
+
+#include <algorithm>
+#include <cmath>
+
+// Black-Scholes closed forms with continuous yield q
+// The batch kernels price n options whose spot and volatility vary per element (i.e. one per path) with the same
+// contract; they use no library calls other than exp, log, sqrt and erfc, so the loops vectorize
+class BlackScholes {
+public:
+
+	// Standard normal cumulative distribution function
+	inline static double N(double x) {
+		return 0.5 * erfc(-x * 0.70710678118654752440);
+	}
+
+	// Standard normal density
+	inline static double n(double x) {
+		return 0.39894228040143267794 * exp(-0.5 * x * x);
+	}
+
+	// Inverse of the standard normal cumulative distribution function, for 0 < u < 1
+	// Acklam's rational approximation, refined with one Halley step to full double precision
+	inline static double InverseN(double u) {
+
+		static const double a[6] = { -3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+			1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00 };
+		static const double b[5] = { -5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+			6.680131188771972e+01, -1.328068155288572e+01 };
+		static const double c[6] = { -7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+			-2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00 };
+		static const double d[4] = { 7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00, 3.754408661907416e+00 };
+
+		u = std::min(std::max(u, 1e-300), 1.0 - 1e-16);
+
+		double x;
+		if (u < 0.02425) {
+			double q = sqrt(-2.0 * log(u));
+			x = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) / ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+		}
+		else if (u <= 1.0 - 0.02425) {
+			double q = u - 0.5, r = q * q;
+			x = (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q / (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+		}
+		else {
+			double q = sqrt(-2.0 * log(1.0 - u));
+			x = -(((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) / ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+		}
+
+		double e = N(x) - u;
+		double h = e * 2.50662827463100050242 * exp(0.5 * x * x);
+		return x - h / (1.0 + 0.5 * x * h);
+	}
+
+	// Call (call = true) or put price
+	inline static double Price(bool call, double S, double K, double T, double r, double q, double vol) {
+
+		double df = exp(-r * T);
+		double F = S * exp((r - q) * T);
+		double sd = vol * sqrt(T);
+
+		// No time value left: discounted intrinsic value of the forward
+		if (sd < 1e-12) return df * (call ? std::max(F - K, 0.0) : std::max(K - F, 0.0));
+
+		double d1 = (log(F / K) + 0.5 * sd * sd) / sd;
+		double d2 = d1 - sd;
+		return call ? df * (F * N(d1) - K * N(d2)) : df * (K * N(-d2) - F * N(-d1));
+	}
+
+	// Black-76 price from the forward and the discount factor
+	inline static double Black(bool call, double F, double K, double T, double df, double vol) {
+
+		double sd = vol * sqrt(T);
+		if (sd < 1e-12) return df * (call ? std::max(F - K, 0.0) : std::max(K - F, 0.0));
+
+		double d1 = (log(F / K) + 0.5 * sd * sd) / sd;
+		double d2 = d1 - sd;
+		return call ? df * (F * N(d1) - K * N(d2)) : df * (K * N(-d2) - F * N(-d1));
+	}
+
+	// Delta of a call or put
+	inline static double Delta(bool call, double S, double K, double T, double r, double q, double vol) {
+		double sd = vol * sqrt(T);
+		double d1 = (log(S / K) + (r - q) * T + 0.5 * sd * sd) / sd;
+		return call ? exp(-q * T) * N(d1) : -exp(-q * T) * N(-d1);
+	}
+
+	// Continuously monitored single barrier at H, no rebate: up (up = true) or down, knock-in or knock-out (Reiner-Rubinstein)
+	// The knock-in value is built from the four terms A, B, C, D of the formulas and the knock-out follows by in-out parity
+	inline static double Barrier(bool call, bool up, bool knock_in, double S, double K, double H, double T, double r, double q, double vol) {
+
+		double vanilla = Price(call, S, K, T, r, q, vol);
+
+		// Barrier already crossed: the knock-in is the vanilla, the knock-out is dead
+		if (up ? S >= H : S <= H) return knock_in ? vanilla : 0.0;
+
+		double sd = vol * sqrt(T);
+		if (sd < 1e-12) return knock_in ? 0.0 : vanilla;
+
+		double phi = call ? 1.0 : -1.0, eta = up ? -1.0 : 1.0;
+		double mu = (r - q - 0.5 * vol * vol) / (vol * vol);
+		double a = (1.0 + mu) * sd;
+		double Sq = S * exp(-q * T), Kr = K * exp(-r * T);
+
+		double x1 = log(S / K) / sd + a, x2 = log(S / H) / sd + a;
+		double y1 = log(H * H / (S * K)) / sd + a, y2 = log(H / S) / sd + a;
+		double h1 = pow(H / S, 2.0 * (mu + 1.0)), h2 = pow(H / S, 2.0 * mu);
+
+		double A = phi * Sq * N(phi * x1) - phi * Kr * N(phi * (x1 - sd));
+		double B = phi * Sq * N(phi * x2) - phi * Kr * N(phi * (x2 - sd));
+		double C = phi * Sq * h1 * N(eta * y1) - phi * Kr * h2 * N(eta * (y1 - sd));
+		double D = phi * Sq * h1 * N(eta * y2) - phi * Kr * h2 * N(eta * (y2 - sd));
+
+		double in;
+		if (call && !up)		in = (K > H) ? C : A - B + D;
+		else if (call && up)	in = (K > H) ? A : B - C + D;
+		else if (!up)			in = (K > H) ? B - C + D : A;
+		else					in = (K > H) ? A - B + D : C;
+
+		in = std::max(in, 0.0);
+		return knock_in ? in : std::max(vanilla - in, 0.0);
+	}
+
+	// Batch kernel: out[i] = price with spot S[i] and volatility vol[i], same strike, expiry, rate and yield
+	inline static void PriceBatch(bool call, const double * S, const double * vol, double K, double T, double r, double q,
+		double * out, std::size_t count) {
+
+		const double df = exp(-r * T);
+		const double growth = exp((r - q) * T);
+		const double sqrt_T = sqrt(T);
+		const double sign = call ? 1.0 : -1.0;
+
+		for (std::size_t i = 0; i < count; ++i) {
+			double F = S[i] * growth;
+			double sd = std::max(vol[i] * sqrt_T, 1e-12);
+			double d1 = (log(F / K) + 0.5 * sd * sd) / sd;
+			double d2 = d1 - sd;
+			out[i] = sign * df * (F * N(sign * d1) - K * N(sign * d2));
+		}
+	}
+
+	// Batch Black-76 kernel: out[i] = price with forward F[i], strike K[i] and volatility vol[i], same expiry and discount
+	inline static void BlackBatch(bool call, const double * F, const double * K, const double * vol, double T, double df,
+		double * out, std::size_t count) {
+
+		const double sqrt_T = sqrt(T);
+		const double sign = call ? 1.0 : -1.0;
+
+		for (std::size_t i = 0; i < count; ++i) {
+			double sd = std::max(vol[i] * sqrt_T, 1e-12);
+			double d1 = (log(F[i] / K[i]) + 0.5 * sd * sd) / sd;
+			double d2 = d1 - sd;
+			out[i] = sign * df * (F[i] * N(sign * d1) - K[i] * N(sign * d2));
+		}
+	}
+};
+
+#endif // !BLACKSCHOLES_HPP
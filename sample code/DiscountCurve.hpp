@@ -0,0 +1,194 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ===================================================================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Discount curve with precomputed dense grid and per-snapshot curve cache
+*
+*/
+
+/*   The curve is built once from the zero rate pillars of a snapshot (linear interpolation of the log-discount between
+*    pillars, i.e. piecewise flat forwards) and then tabulated on a dense uniform time grid. A lookup is an index
+*    computation and a linear interpolation of the log-discount between two grid nodes, with no search and no branches.
+*    Discount factors, zero rates and forwards all come from the same log table, so they are consistent with each other.
+*    One extra node past the grid continues the last forward, so times beyond t_max need no branch either.
+*/
+
+// Multiple inclusion guards
+#ifndef DISCOUNTCURVE_HPP
+#define DISCOUNTCURVE_HPP
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+
+#include "MarketData.hpp"
+
+// Discount curve class
+class DiscountCurve {
+private:
+	double t_max;					// Last time of the dense grid
+	double h;						// Grid spacing
+	double inv_h;					// Inverse grid spacing
+	std::size_t n;					// Number of grid intervals
+	std::vector<double> log_df;		// Log-discount factors on the grid, n + 1 values, and the flat forward extension node
+
+	// Log-discount at time t from the pillars: linear in t*r(t) between pillars, flat rate before the first pillar
+	// and flat forward after the last one
+	inline static double PillarLogDiscount(const std::vector<double> & times, const std::vector<double> & rates, double t) {
+
+		if (t <= times.front()) return -rates.front() * t;
+
+		std::size_t m = times.size();
+		if (t >= times.back()) {
+			if (m == 1) return -rates.back() * t;
+			double fwd = (rates[m - 1] * times[m - 1] - rates[m - 2] * times[m - 2]) / (times[m - 1] - times[m - 2]);
+			return -rates.back() * times.back() - fwd * (t - times.back());
+		}
+
+		std::size_t i = std::upper_bound(times.begin(), times.end(), t) - times.begin();
+		double w = (t - times[i - 1]) / (times[i] - times[i - 1]);
+		return -((1.0 - w) * rates[i - 1] * times[i - 1] + w * rates[i] * times[i]);
+	}
+
+	// Tabulate the curve on the dense grid
+	inline void Build(const std::vector<double> & times, const std::vector<double> & rates) {
+
+		if (times.empty() || times.size() != rates.size()) throw std::invalid_argument("Invalid discount curve pillars");
+		if (t_max <= 0.0 || n == 0) throw std::invalid_argument("Invalid discount curve grid");
+
+		h = t_max / static_cast<double>(n);
+		inv_h = 1.0 / h;
+
+		log_df.resize(n + 2);
+		for (std::size_t i = 0; i <= n; ++i) {
+			log_df[i] = PillarLogDiscount(times, rates, h * static_cast<double>(i));
+		}
+
+		// Beyond the grid: flat forward at the rate of the last grid interval
+		log_df[n + 1] = 2.0 * log_df[n] - log_df[n - 1];
+	}
+
+	// Grid index and interpolation weight of time t >= 0
+	// Beyond t_max the index stays on the extension interval and the weight exceeds 1, which extrapolates its forward
+	inline void Locate(double t, std::size_t & i, double & w) const {
+		if (t < 0.0) throw std::invalid_argument("Discount curve queried at a negative time");
+		double x = t * inv_h;
+		i = static_cast<std::size_t>(std::min(x, static_cast<double>(n)));
+		w = x - static_cast<double>(i);
+	}
+
+public:
+
+	// Constructors
+	// The default grid of 4096 intervals keeps the interpolation error far below Monte Carlo noise for maturities up to 50 years
+	explicit DiscountCurve(const std::vector<double> & times, const std::vector<double> & zero_rates, double t_max_ = 50.0, std::size_t grid_intervals = 4096)
+		: t_max(t_max_), n(grid_intervals) {
+		Build(times, zero_rates);
+	}
+
+	explicit DiscountCurve(const MarketHandle & curve, double t_max_ = 50.0, std::size_t grid_intervals = 4096)
+		: t_max(t_max_), n(grid_intervals) {
+		if (curve.kind != MarketDataKind::Curve) throw std::invalid_argument("Market data is not a curve");
+		std::vector<double> times(curve.data, curve.data + curve.cols);
+		std::vector<double> rates(curve.data + curve.cols, curve.data + 2 * curve.cols);
+		Build(times, rates);
+	}
+
+	// Flat curve, e.g. for the scalar rate of OptionData
+	explicit DiscountCurve(double flat_rate, double t_max_ = 50.0, std::size_t grid_intervals = 4096)
+		: t_max(t_max_), n(grid_intervals) {
+		Build(std::vector<double>(1, 1.0), std::vector<double>(1, flat_rate));
+	}
+
+	// Discount factor P(0, t), extrapolated flat forward beyond the grid
+	inline double Discount(double t) const {
+		return exp(LogDiscount(t));
+	}
+
+	// Log-discount factor ln P(0, t)
+	inline double LogDiscount(double t) const {
+		std::size_t i; double w;
+		Locate(t, i, w);
+		return log_df[i] + w * (log_df[i + 1] - log_df[i]);
+	}
+
+	// Continuously compounded zero rate r(t)
+	inline double ZeroRate(double t) const {
+		return (t > 0.0) ? -LogDiscount(t) / t : -(log_df[1] - log_df[0]) * inv_h;
+	}
+
+	// Continuously compounded forward rate between t1 and t2
+	inline double Forward(double t1, double t2) const {
+		return (LogDiscount(t1) - LogDiscount(t2)) / (t2 - t1);
+	}
+
+	// Instantaneous forward rate f(0, t), constant on each grid interval and beyond the grid
+	inline double InstantaneousForward(double t) const {
+		std::size_t i; double w;
+		Locate(t, i, w);
+		return -(log_df[i + 1] - log_df[i]) * inv_h;
+	}
+
+	// Getters
+	inline double MaxTime() const { return t_max; }
+	inline std::size_t GridIntervals() const { return n; }
+	inline const std::vector<double> & LogDiscountTable() const { return log_df; }
+
+	// Destructor
+	~DiscountCurve() {}
+};
+
+// Cache of discount curves built from a snapshot, shared by all pricing jobs that use the same snapshot
+// When a newer snapshot is requested the cache is flushed; jobs still running on the old snapshot keep their curves alive
+class DiscountCurveCache {
+private:
+	mutable std::mutex m;
+	std::uint64_t snapshot_version = 0;
+	std::unordered_map<std::string, std::shared_ptr<const DiscountCurve>> curves;
+
+public:
+
+	// Constructor
+	explicit DiscountCurveCache() {}
+
+	// Get the curve with the given name from the snapshot, building it only the first time it is requested
+	inline std::shared_ptr<const DiscountCurve> Get(const MarketSnapshot & snapshot, const std::string & name) {
+
+		std::lock_guard<std::mutex> lock(m);
+
+		// A job still running on an older snapshot gets its own curve, without flushing the cache
+		if (snapshot.Version() < snapshot_version) {
+			return std::make_shared<const DiscountCurve>(snapshot.Curve(name));
+		}
+
+		if (snapshot.Version() > snapshot_version) {
+			curves.clear();
+			snapshot_version = snapshot.Version();
+		}
+
+		auto it = curves.find(name);
+		if (it != curves.end()) return it->second;
+
+		std::shared_ptr<const DiscountCurve> curve = std::make_shared<const DiscountCurve>(snapshot.Curve(name));
+		curves[name] = curve;
+		return curve;
+	}
+
+	// Number of curves in the cache
+	inline std::size_t Size() const {
+		std::lock_guard<std::mutex> lock(m);
+		return curves.size();
+	}
+
+	// Destructor
+	~DiscountCurveCache() {}
+};
+
+#endif // !DISCOUNTCURVE_HPP
@@ -0,0 +1,109 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ==============================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Continuous yield and discrete dividend schedule
+*
+*/
+
+/*   Between ex-dates the stock grows at r - q. On an ex-date it drops by the proportional part of the dividend and
+*    then by the cash part: S -> max(S * (1 - p) - c, 0). The ex-dates are added to the simulation time grid, and
+*    the jump is applied to a whole block of spots at once.
+*
+*    For the closed-form reference the cash dividends are escrowed: the spot is reduced by the present value of the
+*    cash dividends until expiry (each one scaled by the proportional dividends paid after it), so that the Black-Scholes
+*    forward matches the forward of the simulated dynamics.
+*/
+
+// Multiple inclusion guards
+#ifndef DIVIDENDS_HPP
+#define DIVIDENDS_HPP
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <cmath>
+
+// One discrete dividend
+struct DiscreteDividend {
+	double t;				// Ex-date, in years
+	double cash;			// Cash amount
+	double proportional;	// Proportional amount, as a fraction of the stock price
+};
+
+// Dividend schedule class
+class DividendSchedule {
+private:
+	double q;									// Continuous dividend yield
+	std::vector<DiscreteDividend> dividends;	// Discrete dividends, sorted by ex-date
+
+	// Ex-dates closer than this are the same date
+	static constexpr double tolerance = 1e-10;
+
+public:
+
+	// Constructors
+	explicit DividendSchedule(double q_ = 0.0, const std::vector<DiscreteDividend> & dividends_ = std::vector<DiscreteDividend>())
+		: q(q_), dividends(dividends_) {
+
+		for (auto & d : dividends) {
+			if (d.t <= 0.0 || d.cash < 0.0 || d.proportional < 0.0 || d.proportional >= 1.0) {
+				throw std::invalid_argument("Invalid discrete dividend");
+			}
+		}
+		std::sort(dividends.begin(), dividends.end(), [](const DiscreteDividend & a, const DiscreteDividend & b) { return a.t < b.t; });
+	}
+
+	// Getters
+	inline double Yield() const { return q; }
+	inline bool HasDiscrete() const { return !dividends.empty(); }
+	inline const std::vector<DiscreteDividend> & Discrete() const { return dividends; }
+
+	// Ex-dates in (0, T), to be added to the simulation grid
+	// A dividend paid exactly at expiry would not change the payoff date, it is ex-dated at T and included as well
+	inline std::vector<double> ExDates(double T) const {
+		std::vector<double> dates;
+		for (auto & d : dividends) if (d.t <= T + tolerance) dates.push_back(d.t);
+		return dates;
+	}
+
+	// Combined jump of the dividends with ex-date t: S -> S * factor - cash
+	// Returns false if there is no dividend on that date
+	inline bool Jump(double t, double & factor, double & cash) const {
+		factor = 1.0;
+		cash = 0.0;
+		bool found = false;
+		for (auto & d : dividends) {
+			if (std::abs(d.t - t) > tolerance) continue;
+			cash = cash * (1.0 - d.proportional) + d.cash;
+			factor *= 1.0 - d.proportional;
+			found = true;
+		}
+		return found;
+	}
+
+	// Batch jump adjustment of n spots on an ex-date, floored at zero
+	inline static void ApplyJump(double factor, double cash, double * S, std::size_t n) {
+		for (std::size_t i = 0; i < n; ++i) S[i] = std::max(S[i] * factor - cash, 0.0);
+	}
+
+	// Escrowed spot for the closed-form reference with expiry T: the spot minus the present value (at the growth rate
+	// r - q) of the cash dividends until T, all scaled by the proportional dividends, so that S* exp((r - q)T) is the forward
+	inline double EscrowedSpot(double S, double T, const std::function<double(double)> & discount) const {
+
+		double escrowed = S;
+		for (auto & d : dividends) {
+			if (d.t > T + tolerance) break;
+			escrowed = escrowed * (1.0 - d.proportional) - d.cash * discount(d.t) * exp(q * d.t);
+		}
+		return escrowed;
+	}
+
+	// Destructor
+	~DividendSchedule() {}
+};
+
+#endif // !DIVIDENDS_HPP
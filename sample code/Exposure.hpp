@@ -0,0 +1,352 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ===================================================================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Counterparty exposure profiles (EE, ENE, PFE) and CVA inputs
+*
+*/
+
+/*   The underlying follows a GBM and is stepped exactly from one exposure date to the next. On each date the value of
+*    the netting set is computed on every path:
+*        - calls, puts and forwards in closed form, at their remaining maturity;
+*        - any other payoff at maturity through a regression proxy: E[payoff(S_T) | S_t] is fitted on 1, y, ..., y^4
+*          (y = S_t / F(t), the spot over its forward) on a pilot simulation, one set of coefficients per date, as in
+*          Longstaff-Schwartz.
+*
+*    The values are never stored as a path x date matrix. They stream into per-date accumulators of the positive and
+*    negative parts, for EE and ENE, and into per-date quantile sketches, for PFE. A sketch is a histogram over a range
+*    taken from the pilot run, with exact counts of the values that fall outside it. The sums are kept per block and
+*    reduced in block order; the sketches are kept per thread, since adding integer counts does not depend on the
+*    order. The results do not depend on the number of threads.
+*
+*    CVA and DVA follow from the discounted EE and ENE profiles with a flat hazard rate.
+*/
+
+// Multiple inclusion guards
+#ifndef EXPOSURE_HPP
+#define EXPOSURE_HPP
+
+#include <vector>
+#include <random>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+#include "BlackScholes.hpp"
+#include "LinearAlgebra.hpp"
+#include "Parallel.hpp"
+
+// One trade of the netting set, on the single underlying of the engine
+struct ExposureTrade {
+	enum class Kind { Call, Put, Forward, Payoff };
+
+	Kind kind;
+	double K;								// Strike
+	double T;								// Maturity
+	double notional;						// Signed: negative for a short position
+	std::function<double(double)> payoff;	// Payoff at maturity, for Kind::Payoff only
+
+	inline static ExposureTrade Call(double K, double T, double notional = 1.0) { return { Kind::Call, K, T, notional, nullptr }; }
+	inline static ExposureTrade Put(double K, double T, double notional = 1.0) { return { Kind::Put, K, T, notional, nullptr }; }
+	inline static ExposureTrade Forward(double K, double T, double notional = 1.0) { return { Kind::Forward, K, T, notional, nullptr }; }
+
+	// A payoff without closed form, valued by a regression proxy
+	inline static ExposureTrade Payoff(const std::function<double(double)> & f, double T, double notional = 1.0) {
+		return { Kind::Payoff, 0.0, T, notional, f };
+	}
+};
+
+// Mergeable quantile sketch: histogram over [lo, hi], with the values outside counted apart
+class QuantileSketch {
+private:
+	double lo = 0.0, hi = 1.0, inv_width = 1.0;
+	std::vector<unsigned long> counts;
+	unsigned long below = 0, above = 0;
+	double min_value = std::numeric_limits<double>::max();
+	double max_value = -std::numeric_limits<double>::max();
+
+public:
+
+	// Constructors
+	explicit QuantileSketch() {}
+	explicit QuantileSketch(double lo_, double hi_, std::size_t bins = 1024) : lo(lo_), hi(hi_), counts(bins, 0) {
+		if (bins == 0 || !(hi > lo)) throw std::invalid_argument("Invalid quantile sketch range");
+		inv_width = static_cast<double>(bins) / (hi - lo);
+	}
+
+	inline void Add(double x) {
+		min_value = std::min(min_value, x);
+		max_value = std::max(max_value, x);
+		if (x < lo) { below++; return; }
+		if (x >= hi) { above++; return; }
+		counts[std::min(static_cast<std::size_t>((x - lo) * inv_width), counts.size() - 1)]++;
+	}
+
+	// Add the counts of a sketch over the same range
+	inline void Merge(const QuantileSketch & other) {
+		for (std::size_t k = 0; k < counts.size(); ++k) counts[k] += other.counts[k];
+		below += other.below;
+		above += other.above;
+		min_value = std::min(min_value, other.min_value);
+		max_value = std::max(max_value, other.max_value);
+	}
+
+	inline unsigned long Count() const {
+		unsigned long n = below + above;
+		for (auto c : counts) n += c;
+		return n;
+	}
+
+	// Quantile of level p, linear within a bin; outside the range, linear between the range and the extreme value
+	inline double Quantile(double p) const {
+
+		const unsigned long n = Count();
+		if (n == 0) return 0.0;
+		double target = p * static_cast<double>(n);
+
+		if (target <= static_cast<double>(below)) {
+			return (below == 0) ? lo : min_value + (lo - min_value) * target / static_cast<double>(below);
+		}
+		double cumulative = static_cast<double>(below);
+		const double width = (hi - lo) / static_cast<double>(counts.size());
+		for (std::size_t k = 0; k < counts.size(); ++k) {
+			double c = static_cast<double>(counts[k]);
+			if (c > 0.0 && cumulative + c >= target) return lo + width * (static_cast<double>(k) + (target - cumulative) / c);
+			cumulative += c;
+		}
+		return (above == 0) ? hi : hi + (max_value - hi) * (target - cumulative) / static_cast<double>(above);
+	}
+
+	// Destructor
+	~QuantileSketch() {}
+};
+
+// Exposure profile on the exposure dates
+struct ExposureProfile {
+	std::vector<double> times;		// Exposure dates
+	std::vector<double> discount;	// Discount factor to each date
+	std::vector<double> EE;			// Expected exposure E[max(V, 0)]
+	std::vector<double> ENE;		// Expected negative exposure E[min(V, 0)]
+	std::vector<double> PFE;		// Potential future exposure, quantile of V (floored at 0)
+	unsigned long NSIM = 0;
+
+	// Credit valuation adjustment with a flat counterparty hazard rate: (1 - R) sum DF(t_i) EE(t_i) PD(t_(i-1), t_i)
+	inline double CVA(double recovery, double hazard) const {
+		double cva = 0.0, t_prev = 0.0;
+		for (std::size_t i = 0; i < times.size(); ++i) {
+			cva += discount[i] * EE[i] * (exp(-hazard * t_prev) - exp(-hazard * times[i]));
+			t_prev = times[i];
+		}
+		return (1.0 - recovery) * cva;
+	}
+
+	// Debit valuation adjustment with a flat own hazard rate, from the negative exposure (returned as a positive number)
+	inline double DVA(double recovery, double hazard) const {
+		double dva = 0.0, t_prev = 0.0;
+		for (std::size_t i = 0; i < times.size(); ++i) {
+			dva -= discount[i] * ENE[i] * (exp(-hazard * t_prev) - exp(-hazard * times[i]));
+			t_prev = times[i];
+		}
+		return (1.0 - recovery) * dva;
+	}
+
+	// Expected positive exposure: time-weighted average of EE over the dates
+	inline double EPE() const {
+		double sum = 0.0, t_prev = 0.0;
+		for (std::size_t i = 0; i < times.size(); ++i) {
+			sum += EE[i] * (times[i] - t_prev);
+			t_prev = times[i];
+		}
+		return times.empty() ? 0.0 : sum / times.back();
+	}
+};
+
+// Exposure simulation engine
+class ExposureEngine {
+private:
+	double r;		// Interest rate
+	double vol;		// Volatility of the underlying
+	double q;		// Dividend yield
+
+	static constexpr std::size_t basis = 5;
+
+	// Regression proxies: coefficients per trade of kind Payoff and per exposure date
+	using Proxies = std::vector<std::vector<std::vector<double>>>;
+
+	// Value of the netting set on date i at spot S
+	inline double Value(const std::vector<ExposureTrade> & trades, const Proxies & proxies, std::size_t i, double t, double S) const {
+
+		double V = 0.0, y = S * exp(-(r - q) * t);
+		for (std::size_t n = 0; n < trades.size(); ++n) {
+			const ExposureTrade & trade = trades[n];
+			if (trade.T <= t) continue;
+			double tau = trade.T - t;
+			switch (trade.kind) {
+			case ExposureTrade::Kind::Call:
+				V += trade.notional * BlackScholes::Price(true, S, trade.K, tau, r, q, vol);
+				break;
+			case ExposureTrade::Kind::Put:
+				V += trade.notional * BlackScholes::Price(false, S, trade.K, tau, r, q, vol);
+				break;
+			case ExposureTrade::Kind::Forward:
+				V += trade.notional * (S * exp(-q * tau) - trade.K * exp(-r * tau));
+				break;
+			default:
+			{
+				const std::vector<double> & c = proxies[n][i];
+				V += trade.notional * (c[0] + y * (c[1] + y * (c[2] + y * (c[3] + y * c[4]))));
+				break;
+			}
+			}
+		}
+		return V;
+	}
+
+	// Exact GBM step
+	inline double Step(double S, double dt, double z) const {
+		return S * exp((r - q - 0.5 * vol * vol) * dt + vol * sqrt(dt) * z);
+	}
+
+	// Fit the proxies on a pilot run, and return the range of the netting set value on each date
+	inline Proxies Fit(const std::vector<ExposureTrade> & trades, double S, const std::vector<double> & dates, unsigned long pilot,
+		unsigned long seed, std::vector<double> & lo, std::vector<double> & hi) const {
+
+		const std::size_t D = dates.size();
+		Proxies proxies(trades.size());
+
+		// Pilot paths on the exposure dates, D x pilot, then each regression regresses a terminal payoff on them
+		std::mt19937_64 eng(seed);
+		std::normal_distribution<double> nd(0.0, 1.0);
+		std::vector<double> paths(D * pilot);
+		for (unsigned long p = 0; p < pilot; ++p) {
+			double s = S, t = 0.0;
+			for (std::size_t i = 0; i < D; ++i) {
+				s = Step(s, dates[i] - t, nd(eng));
+				t = dates[i];
+				paths[i * pilot + p] = s;
+			}
+		}
+
+		for (std::size_t n = 0; n < trades.size(); ++n) {
+
+			const ExposureTrade & trade = trades[n];
+			if (trade.kind != ExposureTrade::Kind::Payoff) continue;
+			proxies[n].assign(D, std::vector<double>(basis, 0.0));
+
+			// Continue each pilot path from each date to maturity, so that the regressand is conditional on that date
+			for (std::size_t i = 0; i < D && dates[i] < trade.T; ++i) {
+				const double tau = trade.T - dates[i], df = exp(-r * tau);
+				std::vector<double> A(basis * basis, 0.0), b(basis, 0.0);
+				for (unsigned long p = 0; p < pilot; ++p) {
+					double s = paths[i * pilot + p];
+					double y = s * exp(-(r - q) * dates[i]);
+					double cash = df * trade.payoff(Step(s, tau, nd(eng)));
+					double f[basis] = { 1.0, y, y * y, y * y * y, y * y * y * y };
+					for (std::size_t a = 0; a < basis; ++a) {
+						b[a] += f[a] * cash;
+						for (std::size_t c = 0; c < basis; ++c) A[a * basis + c] += f[a] * f[c];
+					}
+				}
+				if (!LinearAlgebra::Solve(A, b, basis)) throw std::runtime_error("Exposure proxy regression is singular, use more pilot paths");
+				proxies[n][i] = b;
+			}
+		}
+
+		// Range of the netting set value on each date, widened by half of it on each side
+		lo.assign(D, std::numeric_limits<double>::max());
+		hi.assign(D, -std::numeric_limits<double>::max());
+		for (std::size_t i = 0; i < D; ++i) {
+			for (unsigned long p = 0; p < pilot; ++p) {
+				double V = Value(trades, proxies, i, dates[i], paths[i * pilot + p]);
+				lo[i] = std::min(lo[i], V);
+				hi[i] = std::max(hi[i], V);
+			}
+			double margin = std::max(0.5 * (hi[i] - lo[i]), 1e-8);
+			lo[i] -= margin;
+			hi[i] += margin;
+		}
+		return proxies;
+	}
+
+public:
+
+	// Constructor
+	explicit ExposureEngine(double r_, double vol_, double q_ = 0.0) : r(r_), vol(vol_), q(q_) {}
+
+	// Exposure profile of the netting set on the dates, with NSIM paths, and the PFE at the given quantile
+	// The regression proxies and the sketch ranges come from a pilot run of pilot paths
+	inline ExposureProfile Profile(const std::vector<ExposureTrade> & trades, double S, std::vector<double> dates, unsigned long NSIM,
+		double quantile = 0.975, unsigned long pilot = 20000, unsigned long seed = 5489u, std::size_t block_size = 4096, unsigned threads = 0) const {
+
+		if (trades.empty() || dates.empty() || NSIM < 2 || block_size == 0 || pilot < 4 * basis) {
+			throw std::invalid_argument("Invalid exposure parameters");
+		}
+		std::sort(dates.begin(), dates.end());
+		if (dates.front() <= 0.0) throw std::invalid_argument("Exposure dates must be positive");
+
+		const std::size_t D = dates.size();
+		std::vector<double> lo, hi;
+		const Proxies proxies = Fit(trades, S, dates, pilot, seed ^ 0xA5A5A5A5ULL, lo, hi);
+
+		if (threads == 0) threads = ThreadCount();
+		std::vector<QuantileSketch> sketches;
+		for (unsigned t = 0; t < threads; ++t) for (std::size_t i = 0; i < D; ++i) sketches.emplace_back(lo[i], hi[i]);
+
+		// Per block and date: sums of the positive and negative parts
+		BlockSums sums(BlockCount(NSIM, block_size), D);
+
+		ParallelFor(0, sums.Blocks(), [&](std::size_t b, unsigned thread_id) {
+
+			std::size_t count = std::min<std::size_t>(block_size, NSIM - b * block_size);
+			std::mt19937_64 eng(BlockSeed(seed, b));
+			std::normal_distribution<double> nd(0.0, 1.0);
+
+			std::vector<double> spot(count, S);
+			QuantileSketch * sketch = sketches.data() + thread_id * D;
+
+			double t = 0.0;
+			for (std::size_t i = 0; i < D; ++i) {
+				const double dt = dates[i] - t;
+				t = dates[i];
+				for (std::size_t p = 0; p < count; ++p) {
+					spot[p] = Step(spot[p], dt, nd(eng));
+					double V = Value(trades, proxies, i, t, spot[p]);
+					double * s = sums.Slots(b, i);
+					s[0] += std::max(V, 0.0);
+					s[1] += std::min(V, 0.0);
+					sketch[i].Add(V);
+				}
+			}
+		}, threads);
+
+		ExposureProfile profile;
+		profile.times = dates;
+		profile.NSIM = NSIM;
+		profile.discount.resize(D);
+		profile.EE.assign(D, 0.0);
+		profile.ENE.assign(D, 0.0);
+		profile.PFE.resize(D);
+
+		const double N = static_cast<double>(NSIM);
+		for (std::size_t i = 0; i < D; ++i) {
+			std::vector<double> total = sums.Total(i);
+			profile.EE[i] = total[0] / N;
+			profile.ENE[i] = total[1] / N;
+			profile.discount[i] = exp(-r * dates[i]);
+
+			QuantileSketch merged(lo[i], hi[i]);
+			for (unsigned t = 0; t < threads; ++t) merged.Merge(sketches[t * D + i]);
+			profile.PFE[i] = std::max(merged.Quantile(quantile), 0.0);
+		}
+		return profile;
+	}
+
+	// Destructor
+	~ExposureEngine() {}
+};
+
+#endif // !EXPOSURE_HPP
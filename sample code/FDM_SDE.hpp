@@ -67,7 +67,32 @@ public:
 		return 0.5 * vol * (betaCEV)* pow(S, 2.0 * betaCEV - 1.0);
 	}
 
-	// 4. Add another method's supportive functions below to extend the functionality, i.e. Centered/Forward Approximations, etc.
+	// 4. For SABR approach: dF = alpha F^beta dW_F, d alpha = nu alpha dW_alpha, d<W_F, W_alpha> = rho dt
+
+	// Exact step of the lognormal SABR volatility
+	inline static double SABRVolatility(double alpha, double nu, double dt, double Normal) {
+		return alpha * exp(nu * sqrt(dt) * Normal - 0.5 * nu * nu * dt);
+	}
+
+	// Conditional log step of the forward, given the volatility at both ends of the step
+	// Conditional on the volatility, int alpha dW_alpha = (alpha_next - alpha) / nu exactly, the orthogonal part is Gaussian with
+	// variance (1 - rho^2) int alpha^2 dt (trapezoid), and the local factor F^(beta - 1) is frozen at the start of the step.
+	// Exact for beta = 1 up to the trapezoid, stays positive, and needs no small steps to follow the volatility
+	inline static double SABRForward(double F, double alpha, double alpha_next, double beta, double rho, double nu, double dt,
+		double NormalVol, double NormalOrth) {
+
+		// Zero is absorbing for beta < 1
+		if (F <= 0.0) return 0.0;
+
+		double local = pow(F, beta - 1.0);
+		double integrated = 0.5 * (alpha * alpha + alpha_next * alpha_next) * dt;
+		double correlated = (nu > 1e-12) ? (alpha_next - alpha) / nu : alpha * sqrt(dt) * NormalVol;
+		double orthogonal = sqrt((1.0 - rho * rho) * integrated) * NormalOrth;
+		double exponent = local * (rho * correlated + orthogonal) - 0.5 * local * local * integrated;
+		return (exponent > -700.0) ? F * exp(exponent) : 0.0;
+	}
+
+	// 5. Add another method's supportive functions below to extend the functionality, i.e. Centered/Forward Approximations, etc.
 	// Don't forget to modify FDM() below so that the user can choose it for pricing
 	// Lastly, add an extra conditional statement and the algorithm in Pricer<...> class
 	// See 'readme' file for more details
@@ -81,7 +106,8 @@ public:
 			std::cout << "\n\nWhat kind of FDM method you want to use in the evaluation?\n";
 			std::cout << "1. Geometric Brownian Motion\n";
 			std::cout << "2. Explicit Euler Method\n";
-			std::cout << "3. Milstein Method\n\n";
+			std::cout << "3. Milstein Method\n";
+			std::cout << "4. SABR Model\n\n";
 			// In case you add more FDM models, add another choice here, and adapt the code below likewise
 
 			// Get the user's choice of the model
@@ -102,7 +128,8 @@ public:
 				std::cout << "What kind of FDM method you want to use in the evaluation?\n";
 				std::cout << "1. Geometric Brownian Motion\n";
 				std::cout << "2. Explicit Euler Method\n";
-				std::cout << "3. Milstein Method\n\n";
+				std::cout << "3. Milstein Method\n";
+				std::cout << "4. SABR Model\n\n";
 
 				// Get the user's choice of the model
 				std::cout << "Your answer: "; 	std::cin >> fdm_choice;
@@ -131,6 +158,13 @@ public:
 				break;
 
 
+			case 4:
+				// SABR model selected, set appropriately
+				std::cout << "Choice of Finite Differences Approximation: SABR with exact volatility steps\n\n";
+				fdm_name = "SABR";
+				break;
+
+
 			default:
 				// Wrong input. Set to GBM model
 				std::cout << "Invalid choice. Using GBM Model\n";
@@ -0,0 +1,144 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ==============================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Radix-2 FFT plans and batched real convolution
+*
+*/
+
+/*   FFTPlan holds the bit-reversal permutation and the twiddle factors of one power-of-two size, so a transform is
+*    only the butterflies. RealConvolution multiplies by the spectrum of a fixed real kernel, computed once, and
+*    convolves two real signals with one complex transform pair: the first signal goes in the real part and the
+*    second in the imaginary part, and since the kernel is real the two results come back in the same parts.
+*
+*    A RealConvolution owns its work buffer, so each thread uses its own copy.
+*/
+
+// Multiple inclusion guards
+#ifndef FFT_HPP
+#define FFT_HPP
+
+#include <vector>
+#include <complex>
+#include <stdexcept>
+#include <cmath>
+
+// Radix-2 FFT plan for one size
+class FFTPlan {
+private:
+	std::size_t n = 0;
+	std::vector<std::size_t> reversed;				// Bit-reversed index of each index
+	std::vector<std::complex<double>> twiddle;		// exp(-2 pi i k / n), k < n / 2
+
+public:
+
+	// Constructor
+	explicit FFTPlan(std::size_t n_) : n(n_) {
+
+		if (n == 0 || (n & (n - 1)) != 0) throw std::invalid_argument("FFT size must be a power of two");
+
+		unsigned log_n = 0;
+		while ((std::size_t(1) << log_n) < n) log_n++;
+
+		reversed.resize(n);
+		for (std::size_t i = 0; i < n; ++i) {
+			std::size_t r = 0;
+			for (unsigned b = 0; b < log_n; ++b) r |= ((i >> b) & 1) << (log_n - 1 - b);
+			reversed[i] = r;
+		}
+
+		const double pi = 3.14159265358979323846;
+		twiddle.resize(n / 2);
+		for (std::size_t k = 0; k < n / 2; ++k) {
+			double angle = -2.0 * pi * static_cast<double>(k) / static_cast<double>(n);
+			twiddle[k] = std::complex<double>(cos(angle), sin(angle));
+		}
+	}
+
+	// Smallest power of two not below m
+	inline static std::size_t Size(std::size_t m) {
+		std::size_t n = 1;
+		while (n < m) n <<= 1;
+		return n;
+	}
+
+	// Getter
+	inline std::size_t Points() const { return n; }
+
+	// In-place transform of n points; the inverse is scaled by 1 / n
+	inline void Transform(std::complex<double> * data, bool inverse = false) const {
+
+		for (std::size_t i = 0; i < n; ++i) {
+			if (i < reversed[i]) std::swap(data[i], data[reversed[i]]);
+		}
+
+		for (std::size_t len = 2; len <= n; len <<= 1) {
+			std::size_t half = len / 2, stride = n / len;
+			for (std::size_t start = 0; start < n; start += len) {
+				for (std::size_t k = 0; k < half; ++k) {
+					std::complex<double> w = inverse ? std::conj(twiddle[k * stride]) : twiddle[k * stride];
+					std::complex<double> t = w * data[start + k + half];
+					data[start + k + half] = data[start + k] - t;
+					data[start + k] += t;
+				}
+			}
+		}
+
+		if (inverse) {
+			double scale = 1.0 / static_cast<double>(n);
+			for (std::size_t i = 0; i < n; ++i) data[i] *= scale;
+		}
+	}
+
+	// Destructor
+	~FFTPlan() {}
+};
+
+// Causal convolution of signals of a fixed length with a fixed real kernel: out[i] = sum_(m <= i) kernel[m] signal[i - m]
+class RealConvolution {
+private:
+	std::size_t length = 0;
+	FFTPlan plan;
+	std::vector<std::complex<double>> spectrum;		// Transform of the zero-padded kernel
+	std::vector<std::complex<double>> work;			// Work buffer, hence one object per thread
+
+public:
+
+	// Constructor, for signals of the length of the kernel; the padding to twice the length avoids wrap-around
+	explicit RealConvolution(const std::vector<double> & kernel) : length(kernel.size()), plan(FFTPlan::Size(2 * kernel.size())) {
+
+		if (kernel.empty()) throw std::invalid_argument("Convolution needs a kernel");
+
+		spectrum.assign(plan.Points(), std::complex<double>(0.0, 0.0));
+		for (std::size_t m = 0; m < length; ++m) spectrum[m] = kernel[m];
+		plan.Transform(spectrum.data());
+		work.resize(plan.Points());
+	}
+
+	// Getter
+	inline std::size_t Length() const { return length; }
+
+	// Convolve two signals at once, O(length log length)
+	inline void ConvolvePair(const double * a, const double * b, double * out_a, double * out_b) {
+
+		const std::size_t n = plan.Points();
+		for (std::size_t i = 0; i < length; ++i) work[i] = std::complex<double>(a[i], b[i]);
+		for (std::size_t i = length; i < n; ++i) work[i] = 0.0;
+
+		plan.Transform(work.data());
+		for (std::size_t i = 0; i < n; ++i) work[i] *= spectrum[i];
+		plan.Transform(work.data(), true);
+
+		for (std::size_t i = 0; i < length; ++i) {
+			out_a[i] = work[i].real();
+			out_b[i] = work[i].imag();
+		}
+	}
+
+	// Destructor
+	~RealConvolution() {}
+};
+
+#endif // !FFT_HPP
@@ -0,0 +1,135 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ==============================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Low-rank plus diagonal factor representation of a correlation matrix
+*
+*/
+
+/*   A d x d correlation matrix C is approximated by its k leading principal components plus a diagonal residual:
+*        C ~ L L^T + D,    L = V_k sqrt(Lambda_k)  (d x k),    D_ii = 1 - sum_f L_if^2
+*    so the diagonal is exact and only the off-diagonal correlations are truncated. k is the smallest number of
+*    factors whose eigenvalues explain the requested fraction of the total variance (the trace, d).
+*
+*    Correlated normals are then X = Z L^T + eps sqrt(D), with Z a block of k common factors and eps a block of d
+*    idiosyncratic normals per path. For a block of n paths this is an n x k by k x d product, O(n d k), against
+*    O(n d^2) for the Cholesky factor -- for a 500-name index with 20 factors, 25 times fewer flops per step.
+*/
+
+// Multiple inclusion guards
+#ifndef FACTORMODEL_HPP
+#define FACTORMODEL_HPP
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+
+#include "LinearAlgebra.hpp"
+
+// Factor correlation class
+class FactorCorrelation {
+private:
+	std::size_t d = 0;					// Number of assets
+	std::size_t k = 0;					// Number of factors
+	std::vector<double> loadings_T;		// L^T, k x d row-major, so a row of the product is contiguous in the assets
+	std::vector<double> residual;		// sqrt(D_ii), d
+	double explained = 0.0;				// Fraction of the total variance explained by the k factors
+
+public:
+
+	// Constructors
+	// correlation is d x d row-major; explained_variance in (0, 1]; max_factors = 0 means no cap on k
+	explicit FactorCorrelation(const std::vector<double> & correlation, std::size_t d_, double explained_variance = 0.99,
+		std::size_t max_factors = 0) : d(d_) {
+
+		if (d == 0 || correlation.size() != d * d) throw std::invalid_argument("Factor model needs a square correlation matrix");
+		if (explained_variance <= 0.0 || explained_variance > 1.0) throw std::invalid_argument("Explained variance must be in (0, 1]");
+
+		for (std::size_t i = 0; i < d; ++i) {
+			if (std::abs(correlation[i * d + i] - 1.0) > 1e-8) throw std::invalid_argument("Correlation matrix must have a unit diagonal");
+			for (std::size_t j = 0; j < i; ++j) {
+				if (std::abs(correlation[i * d + j] - correlation[j * d + i]) > 1e-8) {
+					throw std::invalid_argument("Correlation matrix must be symmetric");
+				}
+			}
+		}
+
+		std::vector<double> values, vectors;
+		LinearAlgebra::SymmetricEigen(correlation, d, values, vectors);
+
+		// Negative eigenvalues of a slightly inconsistent matrix carry no variance
+		double total = 0.0;
+		for (auto & v : values) {
+			v = std::max(v, 0.0);
+			total += v;
+		}
+
+		// Smallest k reaching the threshold
+		std::size_t cap = (max_factors == 0) ? d : std::min(max_factors, d);
+		double cumulative = 0.0;
+		while (k < cap && values[k] > 0.0) {
+			cumulative += values[k];
+			k++;
+			if (cumulative >= explained_variance * total) break;
+		}
+		if (k == 0) k = 1;
+		explained = cumulative / total;
+
+		// Loadings and residual volatilities
+		loadings_T.assign(k * d, 0.0);
+		residual.assign(d, 0.0);
+		for (std::size_t f = 0; f < k; ++f) {
+			double s = sqrt(values[f]);
+			for (std::size_t i = 0; i < d; ++i) loadings_T[f * d + i] = vectors[i * d + f] * s;
+		}
+		for (std::size_t i = 0; i < d; ++i) {
+			double common = 0.0;
+			for (std::size_t f = 0; f < k; ++f) common += loadings_T[f * d + i] * loadings_T[f * d + i];
+			residual[i] = sqrt(std::max(1.0 - common, 0.0));
+		}
+	}
+
+	// Getters
+	inline std::size_t Dimension() const { return d; }
+	inline std::size_t Factors() const { return k; }
+	inline double ExplainedVariance() const { return explained; }
+	inline double Loading(std::size_t i, std::size_t f) const { return loadings_T[f * d + i]; }
+	inline double Residual(std::size_t i) const { return residual[i]; }
+
+	// Correlation between assets i and j implied by the factor representation
+	inline double ImpliedCorrelation(std::size_t i, std::size_t j) const {
+		if (i == j) return 1.0;
+		double c = 0.0;
+		for (std::size_t f = 0; f < k; ++f) c += loadings_T[f * d + i] * loadings_T[f * d + j];
+		return c;
+	}
+
+	// Full d x d correlation matrix implied by the factor representation, row-major
+	inline std::vector<double> ImpliedMatrix() const {
+		std::vector<double> c(d * d);
+		for (std::size_t i = 0; i < d; ++i) {
+			for (std::size_t j = 0; j < d; ++j) c[i * d + j] = ImpliedCorrelation(i, j);
+		}
+		return c;
+	}
+
+	// Correlate a block of count paths: X = Z L^T + eps sqrt(D)
+	// Z is count x k (factor normals), eps is count x d (idiosyncratic normals), X is count x d; all row-major
+	inline void Correlate(const double * Z, const double * eps, double * X, std::size_t count) const {
+
+		for (std::size_t p = 0; p < count; ++p) {
+			const double * e = eps + p * d;
+			double * x = X + p * d;
+			for (std::size_t i = 0; i < d; ++i) x[i] = e[i] * residual[i];
+		}
+		LinearAlgebra::Gemm(Z, k, loadings_T.data(), d, X, d, count, d, k);
+	}
+
+	// Destructor
+	~FactorCorrelation() {}
+};
+
+#endif // !FACTORMODEL_HPP
@@ -0,0 +1,218 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ===================================================================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Hull-White short rate with exact stepping and equity under stochastic discounting
+*
+*/
+
+/*   Hull-White one-factor model: r(t) = x(t) + phi(t), with
+*        dx = -a x dt + sigma dW_r,    x(0) = 0
+*    and phi fitted to the discount curve, so that E[exp(-int_0^t r)] = P(0, t) for every t:
+*        int_0^t phi = -ln P(0, t) + V(t) / 2,    V(t) = Var(int_0^t x) = sigma^2 / a^2 (t - 2 B(t) + B_2(t))
+*    with B(h) = (1 - e^(-a h)) / a and B_2(h) = (1 - e^(-2 a h)) / (2 a).
+*
+*    The equity follows d ln S = (r - q - vol^2 / 2) dt + vol dW_S, with d<W_r, W_S> = rho dt. Over a step of length h
+*    the triple (x, Y = int x, ln S) has an exact Gaussian transition:
+*        x'     = x e^(-a h) + e_x,             Var e_x = sigma^2 B_2(h)
+*        Y      = x B(h) + e_I,                 Var e_I = sigma^2 / a^2 (h - 2 B(h) + B_2(h))
+*        ln S' = ln S + Y + int phi - (q + vol^2 / 2) h + e_S,      Var e_S = vol^2 h
+*    with Cov(e_x, e_I) = sigma^2 B(h)^2 / 2, Cov(e_x, e_S) = rho sigma vol B(h), Cov(e_I, e_S) = rho sigma vol (h - B(h)) / a.
+*    The Cholesky factor of each step's covariance is computed once, and each path accumulates its discount factor
+*    exp(-int r) = exp(-sum (Y + int phi)) on the fly, so any step size is exact.
+*/
+
+// Multiple inclusion guards
+#ifndef HULLWHITE_HPP
+#define HULLWHITE_HPP
+
+#include <vector>
+#include <tuple>
+#include <random>
+#include <memory>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+#include "DiscountCurve.hpp"
+#include "BlackScholes.hpp"
+#include "TimeGrid.hpp"
+#include "Parallel.hpp"
+
+// Hull-White parameters
+struct HullWhiteParameters {
+	double a;		// Mean reversion speed
+	double sigma;	// Short rate volatility
+};
+
+// Hull-White model calibrated to a discount curve
+class HullWhite {
+private:
+	HullWhiteParameters p;
+	std::shared_ptr<const DiscountCurve> curve;
+
+public:
+
+	// Constructor
+	explicit HullWhite(const HullWhiteParameters & p_, const std::shared_ptr<const DiscountCurve> & curve_) : p(p_), curve(curve_) {
+		if (p.a <= 0.0 || p.sigma < 0.0) throw std::invalid_argument("Hull-White needs a > 0 and sigma >= 0");
+		if (!curve) throw std::invalid_argument("Hull-White needs a discount curve");
+	}
+
+	// Getters
+	inline const HullWhiteParameters & Parameters() const { return p; }
+	inline const DiscountCurve & Curve() const { return *curve; }
+
+	// B(h) = (1 - e^(-a h)) / a
+	inline double B(double h) const { return (1.0 - exp(-p.a * h)) / p.a; }
+
+	// B_2(h) = (1 - e^(-2 a h)) / (2 a)
+	inline double B2(double h) const { return (1.0 - exp(-2.0 * p.a * h)) / (2.0 * p.a); }
+
+	// Variance of int_t^(t+h) x given x(t)
+	inline double IntegralVariance(double h) const {
+		return p.sigma * p.sigma / (p.a * p.a) * (h - 2.0 * B(h) + B2(h));
+	}
+
+	// int_t1^t2 phi, fitted to the curve
+	inline double PhiIntegral(double t1, double t2) const {
+		return curve->LogDiscount(t1) - curve->LogDiscount(t2) + 0.5 * (IntegralVariance(t2) - IntegralVariance(t1));
+	}
+
+	// Zero coupon bond P(t, T) given x(t)
+	inline double BondPrice(double t, double T, double x) const {
+		double h = T - t;
+		return exp(curve->LogDiscount(T) - curve->LogDiscount(t) - B(h) * x
+			+ 0.5 * (IntegralVariance(h) - IntegralVariance(T) + IntegralVariance(t)));
+	}
+
+	// Destructor
+	~HullWhite() {}
+};
+
+// Alias for the hybrid output: price, standard error, number of paths
+using HybridResults = std::tuple<double, double, unsigned long>;
+
+// Equity option engine with Hull-White rates
+class HullWhiteEquityEngine {
+private:
+	HullWhite model;
+	double vol;		// Equity volatility
+	double rho;		// Correlation between the rate and the equity
+	double q;		// Dividend yield
+
+	// Exact transition constants of one step
+	struct Transition {
+		double e;			// e^(-a h)
+		double B;			// B(h)
+		double drift;		// int phi - (q + vol^2 / 2) h
+		double phi;			// int phi
+		double L[6];		// Lower Cholesky factor of Cov(e_x, e_I, e_S): L00, L10, L11, L20, L21, L22
+	};
+
+	inline std::vector<Transition> Transitions(const TimeGrid & grid) const {
+
+		const double a = model.Parameters().a, sigma = model.Parameters().sigma;
+		std::vector<Transition> steps(grid.Steps());
+
+		for (std::size_t j = 0; j < grid.Steps(); ++j) {
+			double h = grid.Dt(j);
+			Transition & s = steps[j];
+			s.e = exp(-a * h);
+			s.B = model.B(h);
+			s.phi = model.PhiIntegral(grid.Time(j), grid.Time(j + 1));
+			s.drift = s.phi - (q + 0.5 * vol * vol) * h;
+
+			// Covariance of (e_x, e_I, e_S)
+			double cxx = sigma * sigma * model.B2(h);
+			double cii = model.IntegralVariance(h);
+			double css = vol * vol * h;
+			double cxi = 0.5 * sigma * sigma * s.B * s.B;
+			double cxs = rho * sigma * vol * s.B;
+			double cis = rho * sigma * vol * (h - s.B) / a;
+
+			// 3 x 3 Cholesky, with the diagonal floored for sigma = 0 or perfect correlation
+			double l00 = sqrt(std::max(cxx, 0.0));
+			double l10 = (l00 > 0.0) ? cxi / l00 : 0.0;
+			double l11 = sqrt(std::max(cii - l10 * l10, 0.0));
+			double l20 = (l00 > 0.0) ? cxs / l00 : 0.0;
+			double l21 = (l11 > 1e-14) ? (cis - l20 * l10) / l11 : 0.0;
+			double l22 = sqrt(std::max(css - l20 * l20 - l21 * l21, 0.0));
+			s.L[0] = l00; s.L[1] = l10; s.L[2] = l11; s.L[3] = l20; s.L[4] = l21; s.L[5] = l22;
+		}
+		return steps;
+	}
+
+public:
+
+	// Constructor
+	explicit HullWhiteEquityEngine(const HullWhite & model_, double vol_, double rho_, double q_ = 0.0)
+		: model(model_), vol(vol_), rho(rho_), q(q_) {
+		if (rho < -1.0 || rho > 1.0) throw std::invalid_argument("Correlation must be in [-1, 1]");
+	}
+
+	// Closed form of a European call or put: Black on the T-forward with the variance of int x + vol W_S
+	inline double ClosedForm(bool call, double S, double K, double T) const {
+
+		const double a = model.Parameters().a, sigma = model.Parameters().sigma;
+		double P = model.Curve().Discount(T);
+		double F = S * exp(-q * T) / P;
+		double variance = model.IntegralVariance(T) + vol * vol * T + 2.0 * rho * sigma * vol * (T - model.B(T)) / a;
+		return BlackScholes::Black(call, F, K, T, P, sqrt(variance / T));
+	}
+
+	// Price a call or put with NSIM paths on NSteps exact steps, discounting each path with its own rate path
+	inline HybridResults Price(bool call, double S, double K, double T, unsigned long NSIM, unsigned long NSteps,
+		unsigned long seed = 5489u, std::size_t block_size = 4096, unsigned threads = 0) const {
+
+		if (NSIM < 2 || block_size == 0) throw std::invalid_argument("Hull-White engine needs at least two paths");
+
+		const TimeGrid grid = TimeGrid::Uniform(T, NSteps);
+		const std::vector<Transition> steps = Transitions(grid);
+		const double log_S = log(S);
+
+		BlockSums sums(BlockCount(NSIM, block_size), 1);
+
+		ParallelFor(0, sums.Blocks(), [&](std::size_t b, unsigned) {
+
+			std::size_t count = std::min<std::size_t>(block_size, NSIM - b * block_size);
+			std::mt19937_64 eng(BlockSeed(seed, b));
+			std::normal_distribution<double> nd(0.0, 1.0);
+
+			// Structure of arrays: short rate factor, log discount factor, log stock
+			std::vector<double> x(count, 0.0), log_D(count, 0.0), log_s(count, log_S);
+
+			for (const Transition & s : steps) {
+				for (std::size_t p = 0; p < count; ++p) {
+					double z0 = nd(eng), z1 = nd(eng), z2 = nd(eng);
+					double ex = s.L[0] * z0;
+					double ei = s.L[1] * z0 + s.L[2] * z1;
+					double es = s.L[3] * z0 + s.L[4] * z1 + s.L[5] * z2;
+
+					double Y = x[p] * s.B + ei;
+					x[p] = x[p] * s.e + ex;
+					log_D[p] -= Y + s.phi;
+					log_s[p] += Y + s.drift + es;
+				}
+			}
+
+			double * slots = sums.Slots(b, 0);
+			for (std::size_t p = 0; p < count; ++p) {
+				double ST = exp(log_s[p]);
+				BlockSums::Add(slots, exp(log_D[p]) * (call ? std::max(ST - K, 0.0) : std::max(K - ST, 0.0)));
+			}
+		}, threads);
+
+		// Each path is discounted with its own rate path, the blocks are reduced in order
+		std::vector<double> mean, SE;
+		sums.Estimate(1.0, NSIM, mean, SE);
+		return std::make_tuple(mean[0], SE[0], NSIM);
+	}
+
+	// Destructor
+	~HullWhiteEquityEngine() {}
+};
+
+#endif // !HULLWHITE_HPP
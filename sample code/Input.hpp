@@ -14,6 +14,9 @@
 
 #include <tuple>
 #include <iostream>
+#include <string>
+
+#include "MarketData.hpp"
 
 // Alias for the tuple that holds the option parameters:
 // volatility, interest rate, expiry time, stock price, strike price, number of simulations
@@ -162,6 +165,22 @@ public:
 		return std::move(std::make_tuple(vol, r, T, S, K, NSIM));
 	}
 	
+	// Market data interface to set the member data from a snapshot instead of typing them in
+	// The stock price is read from the spot entry, the rate from the zero curve at expiry, and the volatility
+	// from the surface at (expiry, strike)
+	inline OptionData setOptionData(const MarketSnapshot & snapshot, const std::string & spot_name, const std::string & curve_name,
+		const std::string & surface_name, double T_, double K_, unsigned long NSIM_) {
+
+		T		= T_;
+		K		= K_;
+		NSIM	= NSIM_;
+		S		= snapshot.Spot(spot_name);
+		r		= snapshot.Curve(curve_name).Interpolate(T);
+		vol		= snapshot.Surface(surface_name).Interpolate(T, K);
+
+		return std::make_tuple(vol, r, T, S, K, NSIM);
+	}
+
 	// Destructor
 	~Input();
 };
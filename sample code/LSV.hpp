@@ -0,0 +1,210 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ===================================================================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Local-stochastic volatility with particle-method leverage calibration
+*
+*/
+
+/*   LSV dynamics, with x = ln(S / F(t)) the log-moneyness against the forward:
+*        dx = -L(t, x)^2 v / 2 dt + L(t, x) sqrt(v) dW1
+*        dv = kappa (theta - v) dt + xi sqrt(v) dW2,        d<W1, W2> = rho dt
+*    The model reprices the vanillas of the surface when the leverage satisfies (Gyongy)
+*        L(t, x)^2 E[v | x_t = x] = sigma_loc(t, x)^2
+*    with sigma_loc the Dupire local volatility of the surface.
+*
+*    Particle method (Guyon and Henry-Labordere): all the paths are advanced together, and at each step the conditional
+*    expectation is estimated from the particles themselves. The x axis, from the smallest to the largest particle, is
+*    cut in equal bins; each block of particles fills its own histogram of counts and sums of v, and the histograms are
+*    reduced in block order, so the result does not depend on the number of threads. Bins with too few particles
+*    are widened with their neighbours, with prefix sums, and the leverage is interpolated linearly between bin centres.
+*    The calibration and the pricing happen in the same simulation.
+*
+*    The variance uses the QE step of StochasticVol, and the log-moneyness the correlated part int sqrt(v) dW2 implied
+*    by the variance increment, as in the conditional Heston scheme, with the leverage frozen over the step.
+*/
+
+// Multiple inclusion guards
+#ifndef LSV_HPP
+#define LSV_HPP
+
+#include <vector>
+#include <tuple>
+#include <random>
+#include <limits>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+#include "VolSurface.hpp"
+#include "StochasticVol.hpp"
+#include "TimeGrid.hpp"
+#include "Parallel.hpp"
+
+// Alias for the LSV output: price per strike, standard error per strike, number of paths
+using LSVResults = std::tuple<std::vector<double>, std::vector<double>, unsigned long>;
+
+// Local-stochastic volatility engine
+class LSVEngine {
+private:
+	VolSurface surface;
+	HestonParameters p;
+	double r;				// Interest rate
+	double q;				// Dividend yield
+	std::size_t bins;		// Bins of the conditional expectation per step
+	std::size_t min_count;	// Particles a bin needs, otherwise it is widened
+
+	// Leverage of the last run, per step: bin centres and leverage values
+	std::vector<std::vector<double>> centres;
+	std::vector<std::vector<double>> leverage;
+
+	// Leverage at x, linear between bin centres and flat outside
+	inline static double Interpolate(const std::vector<double> & c, const std::vector<double> & L, double x) {
+		if (x <= c.front()) return L.front();
+		if (x >= c.back()) return L.back();
+		double u = (x - c.front()) / (c[1] - c[0]);
+		std::size_t j = std::min(static_cast<std::size_t>(u), c.size() - 2);
+		double w = u - static_cast<double>(j);
+		return L[j] + w * (L[j + 1] - L[j]);
+	}
+
+public:
+
+	// Constructor
+	explicit LSVEngine(const VolSurface & surface_, const HestonParameters & p_, double r_, double q_ = 0.0,
+		std::size_t bins_ = 100, std::size_t min_count_ = 200)
+		: surface(surface_), p(p_), r(r_), q(q_), bins(bins_), min_count(min_count_) {
+		if (p.xi <= 0.0 || p.kappa <= 0.0 || p.v0 <= 0.0) throw std::invalid_argument("LSV needs kappa > 0, xi > 0 and v0 > 0");
+		if (bins < 2 || min_count == 0) throw std::invalid_argument("LSV needs at least two bins");
+	}
+
+	// Getters: leverage of the last run, bin centres and values per step
+	inline const std::vector<std::vector<double>> & LeverageCentres() const { return centres; }
+	inline const std::vector<std::vector<double>> & Leverage() const { return leverage; }
+
+	// Calibrate the leverage and price calls or puts for all the strikes with NSIM particles and NSteps steps
+	// Each block of particles keeps its own generator across the steps
+	inline LSVResults Price(bool call, double S, const std::vector<double> & strikes, double T, unsigned long NSIM, unsigned long NSteps,
+		unsigned long seed = 5489u, std::size_t block_size = 4096, unsigned threads = 0) {
+
+		if (NSIM < 2 || NSteps == 0 || T <= 0.0 || block_size == 0 || strikes.empty()) throw std::invalid_argument("Invalid LSV parameters");
+
+		const TimeGrid grid = TimeGrid::Uniform(T, NSteps);
+		const double dt = T / static_cast<double>(NSteps);
+		const HestonQE qe(p, dt);
+		const LocalVolGrid local_vol(surface, grid.Times(), -3.0, 3.0, 301, threads);
+		const double orth = sqrt(1.0 - p.rho * p.rho), inv_xi = 1.0 / p.xi;
+
+		const std::size_t nblocks = BlockCount(NSIM, block_size);
+		std::vector<std::mt19937_64> engines;
+		for (std::size_t b = 0; b < nblocks; ++b) engines.emplace_back(BlockSeed(seed, b));
+
+		// Particles: log-moneyness and variance
+		std::vector<double> x(NSIM, 0.0), v(NSIM, p.v0);
+
+		// Per block: range of x, then histogram of counts and sums of v
+		std::vector<double> block_min(nblocks, 0.0), block_max(nblocks, 0.0), histogram(nblocks * bins * 2);
+
+		centres.assign(grid.Steps(), std::vector<double>(bins));
+		leverage.assign(grid.Steps(), std::vector<double>(bins));
+
+		for (std::size_t j = 0; j < grid.Steps(); ++j) {
+
+			// Bins from the smallest to the largest particle
+			double lo = *std::min_element(block_min.begin(), block_min.end());
+			double hi = *std::max_element(block_max.begin(), block_max.end());
+			if (hi - lo < 1e-10) { lo -= 1e-5; hi += 1e-5; }
+			const double width = (hi - lo) / static_cast<double>(bins), inv_width = 1.0 / width;
+
+			ParallelFor(0, nblocks, [&](std::size_t b, unsigned) {
+				std::size_t first = b * block_size, last = std::min<std::size_t>(first + block_size, NSIM);
+				double * h = histogram.data() + b * bins * 2;
+				std::fill(h, h + bins * 2, 0.0);
+				for (std::size_t i = first; i < last; ++i) {
+					std::size_t k = std::min(static_cast<std::size_t>(std::max((x[i] - lo) * inv_width, 0.0)), bins - 1);
+					h[2 * k] += 1.0;
+					h[2 * k + 1] += v[i];
+				}
+			}, threads);
+
+			// Reduce the histograms in block order, then prefix sums for the widened bins
+			std::vector<double> count(bins + 1, 0.0), sum(bins + 1, 0.0);
+			for (std::size_t b = 0; b < nblocks; ++b) {
+				const double * h = histogram.data() + b * bins * 2;
+				for (std::size_t k = 0; k < bins; ++k) {
+					count[k + 1] += h[2 * k];
+					sum[k + 1] += h[2 * k + 1];
+				}
+			}
+			for (std::size_t k = 0; k < bins; ++k) {
+				count[k + 1] += count[k];
+				sum[k + 1] += sum[k];
+			}
+
+			// Leverage per bin: local volatility over the root of E[v | x]
+			std::vector<double> & c = centres[j];
+			std::vector<double> & L = leverage[j];
+			for (std::size_t k = 0; k < bins; ++k) {
+				std::size_t a = k, e = k + 1;
+				while (count[e] - count[a] < static_cast<double>(min_count) && (a > 0 || e < bins)) {
+					if (a > 0) a--;
+					if (e < bins) e++;
+				}
+				double expected_v = (sum[e] - sum[a]) / std::max(count[e] - count[a], 1.0);
+				c[k] = lo + (static_cast<double>(k) + 0.5) * width;
+				L[k] = local_vol(j, c[k]) / sqrt(std::max(expected_v, 1e-12));
+			}
+
+			// Advance the particles
+			ParallelFor(0, nblocks, [&](std::size_t b, unsigned) {
+
+				std::size_t first = b * block_size, last = std::min<std::size_t>(first + block_size, NSIM);
+				std::mt19937_64 & eng = engines[b];
+				std::normal_distribution<double> nd(0.0, 1.0);
+				std::uniform_real_distribution<double> ud(0.0, 1.0);
+
+				double x_min = std::numeric_limits<double>::max(), x_max = -x_min;
+				for (std::size_t i = first; i < last; ++i) {
+					double lev = Interpolate(c, L, x[i]);
+					double v_next = qe.Step(v[i], nd(eng), ud(eng));
+					double I = 0.5 * (v[i] + v_next) * dt;
+					double J = (v_next - v[i] - p.kappa * p.theta * dt + p.kappa * I) * inv_xi;
+					x[i] += -0.5 * lev * lev * I + lev * (p.rho * J + orth * sqrt(I) * nd(eng));
+					v[i] = v_next;
+					x_min = std::min(x_min, x[i]);
+					x_max = std::max(x_max, x[i]);
+				}
+				block_min[b] = x_min;
+				block_max[b] = x_max;
+			}, threads);
+		}
+
+		// Payoffs on the calibrated particles
+		const std::size_t n_strikes = strikes.size();
+		const double F = S * exp((r - q) * T);
+		BlockSums sums(nblocks, n_strikes);
+
+		ParallelFor(0, nblocks, [&](std::size_t b, unsigned) {
+			std::size_t first = b * block_size, last = std::min<std::size_t>(first + block_size, NSIM);
+			for (std::size_t k = 0; k < n_strikes; ++k) {
+				double * s = sums.Slots(b, k);
+				const double K = strikes[k];
+				for (std::size_t i = first; i < last; ++i) {
+					double ST = F * exp(x[i]);
+					BlockSums::Add(s, call ? std::max(ST - K, 0.0) : std::max(K - ST, 0.0));
+				}
+			}
+		}, threads);
+
+		std::vector<double> prices, errors;
+		sums.Estimate(exp(-r * T), NSIM, prices, errors);
+		return std::make_tuple(prices, errors, NSIM);
+	}
+
+	// Destructor
+	~LSVEngine() {}
+};
+
+#endif // !LSV_HPP
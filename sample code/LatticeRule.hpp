@@ -0,0 +1,262 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ==============================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Rank-1 lattice rules with random shifts for quasi-Monte Carlo
+*
+*/
+
+/*   A rank-1 lattice rule with n points and generating vector z in dimension s has the points
+*        x_i = frac(i z / n + Delta),    i = 0, ..., n - 1
+*    where Delta is a uniform random shift. Each coordinate is a multiply-mod, and along a block of consecutive
+*    indices it is an add-and-wrap recurrence, so the generation loop is integer arithmetic that vectorizes.
+*
+*    Independent shifts give independent unbiased estimates, so a handful of replicates yields an honest standard
+*    error. The baker's (tent) transform x -> 1 - |2x - 1| periodizes smooth integrands, which then converge close
+*    to O(1/n^2) for vanillas and Asians.
+*
+*    Good generating vectors are found by the component-by-component (CBC) construction, minimizing the shift-averaged
+*    worst-case error in the weighted Sobolev space with weights gamma_j = 1 / j^2. Construct() evaluates a random
+*    subset of the candidates for each component, O(s n L) for L candidates. Vectors can be saved and loaded, so
+*    published vectors or vectors built offline with many points can be used as well; one vector is embedded.
+*/
+
+// Multiple inclusion guards
+#ifndef LATTICERULE_HPP
+#define LATTICERULE_HPP
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <limits>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+
+#include "BlackScholes.hpp"
+#include "PathConstruction.hpp"
+#include "Parallel.hpp"
+
+// Rank-1 lattice rule class
+class LatticeRule {
+private:
+	std::uint64_t n = 0;				// Number of points
+	std::vector<std::uint64_t> z;		// Generating vector, one component per dimension
+
+	// Embedded generating vector for n = 2^16 points, up to 64 dimensions, built with Construct(1 << 16, 64, 1024)
+	static const std::uint64_t * EmbeddedVector() {
+		static const std::uint64_t embedded[64] = {
+			1, 23539, 7545, 28375, 27507, 17357, 15771, 30023, 19121, 20791, 8911, 18027, 14345, 28179, 8041, 8513,
+			30343, 22929, 31727, 26503, 21179, 6967, 25733, 27215, 4939, 25823, 11419, 20371, 6607, 4543, 16759, 29357,
+			3533, 16701, 28801, 31203, 10763, 16653, 9741, 21227, 20613, 11853, 26607, 31413, 6017, 19887, 11609, 31377,
+			25075, 31665, 20099, 20495, 26949, 18129, 20519, 25793, 29941, 4007, 31273, 10741, 21351, 18297, 12165, 3105
+		};
+		return embedded;
+	}
+	static constexpr std::uint64_t embedded_points = 1 << 16;
+	static constexpr std::size_t embedded_dimension = 64;
+
+	// Shift-invariant kernel of the Sobolev space, B2(x) = x^2 - x + 1/6, tabulated on the points m / n
+	inline static std::vector<double> KernelTable(std::uint64_t n) {
+		std::vector<double> omega(static_cast<std::size_t>(n));
+		for (std::uint64_t m = 0; m < n; ++m) {
+			double x = static_cast<double>(m) / static_cast<double>(n);
+			omega[static_cast<std::size_t>(m)] = x * x - x + 1.0 / 6.0;
+		}
+		return omega;
+	}
+
+	inline static std::uint64_t Gcd(std::uint64_t a, std::uint64_t b) {
+		while (b != 0) {
+			std::uint64_t t = a % b;
+			a = b;
+			b = t;
+		}
+		return a;
+	}
+
+public:
+
+	// Constructors
+	explicit LatticeRule(std::uint64_t n_, const std::vector<std::uint64_t> & z_) : n(n_), z(z_) {
+		if (n < 2 || n > (std::uint64_t(1) << 32)) throw std::invalid_argument("Lattice rule needs 2 <= n <= 2^32 points");
+		if (z.empty()) throw std::invalid_argument("Lattice rule needs a generating vector");
+		for (auto & c : z) c %= n;
+	}
+
+	// Embedded rule with 2^16 points in the first dims dimensions
+	inline static LatticeRule Default(std::size_t dims) {
+		if (dims == 0 || dims > embedded_dimension) {
+			throw std::invalid_argument("The embedded lattice rule has 64 dimensions, construct or load a rule for more");
+		}
+		return LatticeRule(embedded_points, std::vector<std::uint64_t>(EmbeddedVector(), EmbeddedVector() + dims));
+	}
+
+	// Component-by-component construction with n points in dims dimensions
+	// For each component, candidates generators coprime to n are drawn at random and the one with the smallest
+	// shift-averaged worst-case error is kept; candidates = 0 searches all of them
+	inline static LatticeRule Construct(std::uint64_t n, std::size_t dims, std::size_t candidates = 256, unsigned long seed = 5489u) {
+
+		if (n < 2 || n > (std::uint64_t(1) << 32) || dims == 0) throw std::invalid_argument("Invalid lattice rule construction");
+
+		const std::vector<double> omega = KernelTable(n);
+		const std::size_t N = static_cast<std::size_t>(n);
+
+		// Units modulo n, only the first half since c and n - c give the same rule up to a reflection
+		std::vector<std::uint64_t> units;
+		for (std::uint64_t c = 1; c <= n / 2; ++c) if (Gcd(c, n) == 1) units.push_back(c);
+
+		std::mt19937_64 eng(seed);
+		std::vector<double> product(N, 1.0);
+		std::vector<std::uint64_t> z(1, 1);
+
+		// First component is 1, the product holds prod_j (1 + gamma_j omega(k z_j / n))
+		for (std::size_t k = 0; k < N; ++k) product[k] *= 1.0 + omega[k];
+
+		for (std::size_t j = 1; j < dims; ++j) {
+
+			double gamma = 1.0 / static_cast<double>((j + 1) * (j + 1));
+
+			std::vector<std::uint64_t> pool;
+			if (candidates == 0 || candidates >= units.size()) pool = units;
+			else {
+				std::uniform_int_distribution<std::size_t> pick(0, units.size() - 1);
+				for (std::size_t c = 0; c < candidates; ++c) pool.push_back(units[pick(eng)]);
+			}
+
+			std::uint64_t best = pool[0];
+			double best_error = std::numeric_limits<double>::max();
+			for (auto c : pool) {
+				double e = 0.0;
+				std::uint64_t m = 0;
+				for (std::size_t k = 0; k < N; ++k) {
+					e += product[k] * omega[static_cast<std::size_t>(m)];
+					m += c;
+					if (m >= n) m -= n;
+				}
+				if (e < best_error) {
+					best_error = e;
+					best = c;
+				}
+			}
+
+			std::uint64_t m = 0;
+			for (std::size_t k = 0; k < N; ++k) {
+				product[k] *= 1.0 + gamma * omega[static_cast<std::size_t>(m)];
+				m += best;
+				if (m >= n) m -= n;
+			}
+			z.push_back(best);
+		}
+
+		return LatticeRule(n, z);
+	}
+
+	// Load a rule: the number of points on the first line, then one component per line, either "z_j" or "j z_j"
+	inline static LatticeRule Load(const std::string & file_name) {
+
+		std::ifstream file(file_name);
+		if (!file) throw std::runtime_error("Cannot open lattice rule file " + file_name);
+
+		std::uint64_t n = 0;
+		std::string line;
+		if (!std::getline(file, line) || !(std::istringstream(line) >> n)) throw std::runtime_error("Lattice rule file without the number of points");
+
+		std::vector<std::uint64_t> z;
+		while (std::getline(file, line)) {
+			std::istringstream ss(line);
+			std::uint64_t a, b;
+			if (!(ss >> a)) continue;
+			z.push_back((ss >> b) ? b : a);
+		}
+		return LatticeRule(n, z);
+	}
+
+	// Save the rule in the format read by Load()
+	inline void Save(const std::string & file_name) const {
+		std::ofstream file(file_name);
+		if (!file) throw std::runtime_error("Cannot write lattice rule file " + file_name);
+		file << n << "\n";
+		for (auto c : z) file << c << "\n";
+	}
+
+	// Getters
+	inline std::uint64_t Points() const { return n; }
+	inline std::size_t Dimension() const { return z.size(); }
+	inline const std::vector<std::uint64_t> & GeneratingVector() const { return z; }
+
+	// Shift-averaged worst-case error of the rule in its first dims dimensions, O(n dims)
+	inline double Error(std::size_t dims) const {
+
+		dims = std::min(dims, z.size());
+		const std::vector<double> omega = KernelTable(n);
+		double sum = 0.0;
+		for (std::uint64_t k = 0; k < n; ++k) {
+			double p = 1.0;
+			for (std::size_t j = 0; j < dims; ++j) {
+				double gamma = 1.0 / static_cast<double>((j + 1) * (j + 1));
+				p *= 1.0 + gamma * omega[static_cast<std::size_t>((k * z[j]) % n)];
+			}
+			sum += p;
+		}
+		return sqrt(std::max(sum / static_cast<double>(n) - 1.0, 0.0));
+	}
+
+	// Random shift of replicate q, in the first dims dimensions
+	inline std::vector<double> Shift(unsigned q, std::size_t dims, unsigned long seed = 5489u) const {
+		std::mt19937_64 eng(BlockSeed(seed, q));
+		std::uniform_real_distribution<double> ud(0.0, 1.0);
+		std::vector<double> shift(dims);
+		for (auto & s : shift) s = ud(eng);
+		return shift;
+	}
+
+	// Points first, ..., first + count - 1 in the first dims dimensions with the given shift, count x dims row-major
+	inline void Uniforms(std::uint64_t first, std::size_t count, std::size_t dims, const double * shift, bool baker, double * u) const {
+
+		if (dims > z.size()) throw std::invalid_argument("Lattice rule has fewer dimensions than requested");
+		if (first + count > n) throw std::invalid_argument("Lattice rule has fewer points than requested");
+
+		const double inv_n = 1.0 / static_cast<double>(n);
+
+		// Current multiple k z_j mod n of each component, advanced by z_j from one point to the next
+		std::vector<std::uint64_t> m(dims);
+		for (std::size_t j = 0; j < dims; ++j) m[j] = (first * z[j]) % n;
+
+		for (std::size_t p = 0; p < count; ++p) {
+			double * up = u + p * dims;
+			for (std::size_t j = 0; j < dims; ++j) {
+				double x = static_cast<double>(m[j]) * inv_n + shift[j];
+				x -= (x >= 1.0) ? 1.0 : 0.0;
+				up[j] = baker ? 1.0 - std::abs(2.0 * x - 1.0) : x;
+				m[j] += z[j];
+				m[j] -= (m[j] >= n) ? n : 0;
+			}
+		}
+	}
+
+	// Normal generator of replicate q for the engines: shifted points mapped through the inverse normal distribution
+	// A lattice rule is only a good point set as a whole, so an estimate must use all Points() points
+	inline NormalBlockGenerator Generator(unsigned q, std::size_t dims, unsigned long seed = 5489u, bool baker = false) const {
+
+		if (dims > z.size()) throw std::invalid_argument("Lattice rule has fewer dimensions than requested");
+
+		LatticeRule rule(*this);
+		std::vector<double> shift = Shift(q, dims, seed);
+		return [rule, shift, baker](unsigned long first, std::size_t count, std::size_t dimension, double * out) {
+			if (dimension != shift.size()) throw std::invalid_argument("Lattice generator used with a different dimension");
+			rule.Uniforms(first, count, dimension, shift.data(), baker, out);
+			for (std::size_t i = 0; i < count * dimension; ++i) out[i] = BlackScholes::InverseN(out[i]);
+		};
+	}
+
+	// Destructor
+	~LatticeRule() {}
+};
+
+#endif // !LATTICERULE_HPP
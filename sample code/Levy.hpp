@@ -0,0 +1,327 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ===================================================================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Variance-Gamma and NIG models by exact subordination, with a COS reference
+*
+*/
+
+/*   Both models are a Brownian motion with drift evaluated at a random business time:
+*        Variance-Gamma:  X_t = theta G_t + sigma W(G_t),    G_t ~ Gamma(shape t / nu, scale nu)
+*        NIG:             X_t = beta I_t + W(I_t),           I_t ~ IG(mean delta t / gamma, shape delta^2 t^2),    gamma = sqrt(alpha^2 - beta^2)
+*    and ln S_t = ln S_0 + (r - q + omega) t + X_t, with the martingale correction omega = -ln E[exp(X_1)].
+*
+*    The subordinator increment over any interval is sampled exactly, so a European payoff needs one step and a
+*    path-dependent payoff one step per observation date, with no discretization error. The Gamma variates use
+*    Marsaglia-Tsang and the inverse Gaussian ones Michael-Schucany-Haas; both are drawn for a whole block of paths,
+*    the Gamma rejection loop running in passes over the pending paths.
+*
+*    The COS method (Fang and Oosterlee) prices Europeans from the characteristic function, with the truncation range
+*    from the cumulants. It converges exponentially for these models and serves as the exact reference in MIS.
+*/
+
+// Multiple inclusion guards
+#ifndef LEVY_HPP
+#define LEVY_HPP
+
+#include <vector>
+#include <tuple>
+#include <random>
+#include <complex>
+#include <functional>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+#include "TimeGrid.hpp"
+#include "Parallel.hpp"
+
+// Batched variates of the subordinators
+class LevySampler {
+public:
+
+	// count Gamma(shape, scale) variates, Marsaglia-Tsang, with the boost U^(1/shape) for shape < 1
+	inline static void Gamma(double shape, double scale, std::size_t count, std::mt19937_64 & eng, double * out) {
+
+		std::normal_distribution<double> nd(0.0, 1.0);
+		std::uniform_real_distribution<double> ud(0.0, 1.0);
+
+		const bool boost = shape < 1.0;
+		const double d = (boost ? shape + 1.0 : shape) - 1.0 / 3.0, c = 1.0 / sqrt(9.0 * d);
+
+		// Passes over the pending variates: propose for all of them, then keep the rejected ones
+		std::vector<std::size_t> pending(count), rejected;
+		std::vector<double> x(count), u(count);
+		for (std::size_t i = 0; i < count; ++i) pending[i] = i;
+
+		while (!pending.empty()) {
+			const std::size_t m = pending.size();
+			for (std::size_t k = 0; k < m; ++k) {
+				x[k] = nd(eng);
+				u[k] = ud(eng);
+			}
+			rejected.clear();
+			for (std::size_t k = 0; k < m; ++k) {
+				double t = 1.0 + c * x[k];
+				double v = t * t * t;
+				double x2 = x[k] * x[k];
+				if (v > 0.0 && (u[k] < 1.0 - 0.0331 * x2 * x2 || log(u[k]) < 0.5 * x2 + d * (1.0 - v + log(v)))) out[pending[k]] = d * v;
+				else rejected.push_back(pending[k]);
+			}
+			pending.swap(rejected);
+		}
+
+		if (boost) {
+			const double inv_shape = 1.0 / shape;
+			for (std::size_t i = 0; i < count; ++i) out[i] *= pow(ud(eng), inv_shape);
+		}
+		for (std::size_t i = 0; i < count; ++i) out[i] *= scale;
+	}
+
+	// count inverse Gaussian IG(mean, shape) variates, Michael-Schucany-Haas
+	inline static void InverseGaussian(double mean, double shape, std::size_t count, std::mt19937_64 & eng, double * out) {
+
+		std::normal_distribution<double> nd(0.0, 1.0);
+		std::uniform_real_distribution<double> ud(0.0, 1.0);
+
+		std::vector<double> u(count);
+		for (std::size_t i = 0; i < count; ++i) {
+			out[i] = nd(eng);
+			u[i] = ud(eng);
+		}
+
+		// Root of the chi-square transform, then the choice between the root and its reciprocal
+		const double a = mean / (2.0 * shape);
+		for (std::size_t i = 0; i < count; ++i) {
+			double y = mean * out[i] * out[i];
+			double x = mean + a * (y - sqrt(y * (4.0 * shape + y)));
+			out[i] = (u[i] * (mean + x) <= mean) ? x : mean * mean / x;
+		}
+	}
+};
+
+// Variance-Gamma model
+class VarianceGamma {
+private:
+	double sigma;	// Volatility of the Brownian motion
+	double nu;		// Variance rate of the Gamma time
+	double theta;	// Drift of the Brownian motion, the skew
+
+public:
+
+	// Constructor
+	explicit VarianceGamma(double sigma_, double nu_, double theta_) : sigma(sigma_), nu(nu_), theta(theta_) {
+		if (sigma <= 0.0 || nu <= 0.0) throw std::invalid_argument("Variance-Gamma needs sigma > 0 and nu > 0");
+		if (1.0 - theta * nu - 0.5 * sigma * sigma * nu <= 0.0) throw std::invalid_argument("Variance-Gamma has no exponential moment");
+	}
+
+	// Martingale correction per year, omega = -ln E[exp(X_1)]
+	inline double Omega() const { return log(1.0 - theta * nu - 0.5 * sigma * sigma * nu) / nu; }
+
+	// Characteristic exponent per year, E[exp(i u X_t)] = exp(t psi(u))
+	inline std::complex<double> Exponent(double u) const {
+		const std::complex<double> i(0.0, 1.0);
+		return -log(1.0 - i * u * theta * nu + 0.5 * sigma * sigma * nu * u * u) / nu;
+	}
+
+	// Cumulants c1, c2, c4 of X_1
+	inline void Cumulants(double & c1, double & c2, double & c4) const {
+		double s2 = sigma * sigma, t2 = theta * theta;
+		c1 = theta;
+		c2 = s2 + nu * t2;
+		c4 = 3.0 * (s2 * s2 * nu + 2.0 * t2 * t2 * nu * nu * nu + 4.0 * s2 * t2 * nu * nu);
+	}
+
+	// count increments of X over dt, out must hold count values
+	inline void Increments(double dt, std::size_t count, std::mt19937_64 & eng, double * out) const {
+		LevySampler::Gamma(dt / nu, nu, count, eng, out);
+		std::normal_distribution<double> nd(0.0, 1.0);
+		for (std::size_t i = 0; i < count; ++i) out[i] = theta * out[i] + sigma * sqrt(out[i]) * nd(eng);
+	}
+
+	// Destructor
+	~VarianceGamma() {}
+};
+
+// Normal inverse Gaussian model
+class NormalInverseGaussian {
+private:
+	double alpha;	// Tail heaviness
+	double beta;	// Skew
+	double delta;	// Scale
+	double gamma;	// sqrt(alpha^2 - beta^2)
+
+public:
+
+	// Constructor
+	explicit NormalInverseGaussian(double alpha_, double beta_, double delta_) : alpha(alpha_), beta(beta_), delta(delta_) {
+		if (delta <= 0.0 || alpha <= std::abs(beta)) throw std::invalid_argument("NIG needs delta > 0 and alpha > |beta|");
+		if (alpha <= std::abs(beta + 1.0)) throw std::invalid_argument("NIG has no exponential moment");
+		gamma = sqrt(alpha * alpha - beta * beta);
+	}
+
+	// Martingale correction per year, omega = -ln E[exp(X_1)]
+	inline double Omega() const { return -delta * (gamma - sqrt(alpha * alpha - (beta + 1.0) * (beta + 1.0))); }
+
+	// Characteristic exponent per year, E[exp(i u X_t)] = exp(t psi(u))
+	inline std::complex<double> Exponent(double u) const {
+		const std::complex<double> b(beta, u);
+		return delta * (gamma - sqrt(alpha * alpha - b * b));
+	}
+
+	// Cumulants c1, c2, c4 of X_1
+	inline void Cumulants(double & c1, double & c2, double & c4) const {
+		double a2 = alpha * alpha, g3 = gamma * gamma * gamma;
+		c1 = delta * beta / gamma;
+		c2 = delta * a2 / g3;
+		c4 = 3.0 * delta * a2 * (a2 + 4.0 * beta * beta) / (g3 * g3 * gamma);
+	}
+
+	// count increments of X over dt, out must hold count values
+	inline void Increments(double dt, std::size_t count, std::mt19937_64 & eng, double * out) const {
+		LevySampler::InverseGaussian(delta * dt / gamma, delta * delta * dt * dt, count, eng, out);
+		std::normal_distribution<double> nd(0.0, 1.0);
+		for (std::size_t i = 0; i < count; ++i) out[i] = beta * out[i] + sqrt(out[i]) * nd(eng);
+	}
+
+	// Destructor
+	~NormalInverseGaussian() {}
+};
+
+// COS pricing of Europeans from the characteristic function of a Levy model
+class COSPricer {
+public:
+
+	// Call or put price with N cosine terms on the range of L standard deviations of ln(S_T / K) around its mean
+	template <class Model>
+	inline static double Price(const Model & model, bool call, double S, double K, double T, double r, double q,
+		std::size_t N = 256, double L = 10.0) {
+
+		double c1, c2, c4;
+		model.Cumulants(c1, c2, c4);
+
+		// Truncation range of x = ln(S_T / K)
+		const double mu = log(S / K) + (r - q + model.Omega()) * T;
+		const double a = mu + c1 * T - L * sqrt(c2 * T + sqrt(c4 * T));
+		const double b = mu + c1 * T + L * sqrt(c2 * T + sqrt(c4 * T));
+		const double pi = 3.14159265358979323846, width = b - a;
+
+		// Cosine coefficients of the payoff on [lo, hi], in units of K
+		auto Coefficient = [&](std::size_t k, double lo, double hi) {
+			double w = static_cast<double>(k) * pi / width;
+			double chi = (cos(w * (hi - a)) * exp(hi) - cos(w * (lo - a)) * exp(lo)
+				+ w * (sin(w * (hi - a)) * exp(hi) - sin(w * (lo - a)) * exp(lo))) / (1.0 + w * w);
+			double psi = (k == 0) ? hi - lo : (sin(w * (hi - a)) - sin(w * (lo - a))) / w;
+			return call ? 2.0 / width * (chi - psi) : 2.0 / width * (psi - chi);
+		};
+
+		double sum = 0.0;
+		for (std::size_t k = 0; k < N; ++k) {
+			double u = static_cast<double>(k) * pi / width;
+			std::complex<double> phi = exp(model.Exponent(u) * T + std::complex<double>(0.0, u * (mu - a)));
+			double V = call ? Coefficient(k, std::max(a, 0.0), b) : Coefficient(k, a, std::min(b, 0.0));
+			sum += (k == 0 ? 0.5 : 1.0) * phi.real() * V;
+		}
+		return std::max(K * exp(-r * T) * sum, 0.0);
+	}
+};
+
+// Alias for the Levy European output: price per strike, standard error per strike, number of paths
+using LevyResults = std::tuple<std::vector<double>, std::vector<double>, unsigned long>;
+
+// Alias for the Levy path-dependent output: price, standard error, number of paths
+using LevyPathResults = std::tuple<double, double, unsigned long>;
+
+// Monte Carlo engine for a Levy model (VarianceGamma or NormalInverseGaussian)
+template <class Model>
+class LevyEngine {
+private:
+	Model model;
+	double r;	// Interest rate
+	double q;	// Dividend yield
+
+public:
+
+	// Constructor
+	explicit LevyEngine(const Model & model_, double r_, double q_ = 0.0) : model(model_), r(r_), q(q_) {}
+
+	// European calls or puts for all the strikes, one exact step to expiry
+	inline LevyResults Price(bool call, double S, const std::vector<double> & strikes, double T, unsigned long NSIM,
+		unsigned long seed = 5489u, std::size_t block_size = 4096, unsigned threads = 0) const {
+
+		if (NSIM < 2 || T <= 0.0 || block_size == 0 || strikes.empty()) throw std::invalid_argument("Invalid Levy engine parameters");
+
+		const std::size_t n_strikes = strikes.size();
+		const double log_forward = log(S) + (r - q + model.Omega()) * T;
+
+		BlockSums sums(BlockCount(NSIM, block_size), n_strikes);
+
+		ParallelFor(0, sums.Blocks(), [&](std::size_t b, unsigned) {
+
+			std::size_t count = std::min<std::size_t>(block_size, NSIM - b * block_size);
+			std::mt19937_64 eng(BlockSeed(seed, b));
+
+			std::vector<double> X(count);
+			model.Increments(T, count, eng, X.data());
+			for (std::size_t i = 0; i < count; ++i) X[i] = exp(log_forward + X[i]);
+
+			for (std::size_t k = 0; k < n_strikes; ++k) {
+				double * s = sums.Slots(b, k);
+				const double K = strikes[k];
+				for (std::size_t i = 0; i < count; ++i) BlockSums::Add(s, call ? std::max(X[i] - K, 0.0) : std::max(K - X[i], 0.0));
+			}
+		}, threads);
+
+		std::vector<double> prices, errors;
+		sums.Estimate(exp(-r * T), NSIM, prices, errors);
+		return std::make_tuple(prices, errors, NSIM);
+	}
+
+	// Path-dependent payoff of the spots on the observation dates, payoff(spots, number of dates), paid at the last date
+	// The subordinator is sampled exactly between consecutive dates, so the schedule is the only grid
+	inline LevyPathResults PricePath(const std::function<double(const double *, std::size_t)> & payoff, double S,
+		const ObservationSchedule & schedule, unsigned long NSIM, unsigned long seed = 5489u, std::size_t block_size = 4096, unsigned threads = 0) const {
+
+		if (NSIM < 2 || schedule.empty() || block_size == 0) throw std::invalid_argument("Invalid Levy engine parameters");
+
+		const double T = *std::max_element(schedule.begin(), schedule.end());
+		const TimeGrid grid = TimeGrid::FromSchedule(T, schedule);
+		const std::size_t n_dates = grid.Observations();
+
+		BlockSums sums(BlockCount(NSIM, block_size), 1);
+
+		ParallelFor(0, sums.Blocks(), [&](std::size_t b, unsigned) {
+
+			std::size_t count = std::min<std::size_t>(block_size, NSIM - b * block_size);
+			std::mt19937_64 eng(BlockSeed(seed, b));
+
+			// Log spots of the block, the increments of one step, and the observed spots path by path
+			std::vector<double> x(count, log(S)), dX(count), spots(count * n_dates);
+
+			std::size_t observed = 0;
+			for (std::size_t j = 0; j < grid.Steps(); ++j) {
+				const double dt = grid.Dt(j);
+				model.Increments(dt, count, eng, dX.data());
+				for (std::size_t i = 0; i < count; ++i) x[i] += (r - q + model.Omega()) * dt + dX[i];
+				if (grid.IsObservation(j + 1)) {
+					for (std::size_t i = 0; i < count; ++i) spots[i * n_dates + observed] = exp(x[i]);
+					observed++;
+				}
+			}
+
+			double * s = sums.Slots(b, 0);
+			for (std::size_t i = 0; i < count; ++i) BlockSums::Add(s, payoff(spots.data() + i * n_dates, n_dates));
+		}, threads);
+
+		std::vector<double> price, error;
+		sums.Estimate(exp(-r * T), NSIM, price, error);
+		return std::make_tuple(price[0], error[0], NSIM);
+	}
+
+	// Destructor
+	~LevyEngine() {}
+};
+
+#endif // !LEVY_HPP
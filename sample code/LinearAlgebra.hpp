@@ -0,0 +1,280 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ==============================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Dense linear algebra kernels for correlation and path construction
+*
+*/
+
+/*   Matrices are stored row-major in a std::vector<double>, element (i, j) of an m x n matrix at i * n + j.
+*
+*    - SymmetricEigen: Householder reduction to tridiagonal form followed by the implicit QL algorithm, O(d^3) once.
+*      The eigenvalues are returned in decreasing order, the eigenvectors as the columns of a d x d matrix.
+*    - Solve: dense linear system by Gaussian elimination with partial pivoting, for the small regressions.
+*    - Gemm: C += A B, blocked so that a tile of A, a tile of B and a tile of C stay in cache. The inner loop runs over
+*      contiguous rows of B and C, so it vectorizes.
+*/
+
+// Multiple inclusion guards
+#ifndef LINEARALGEBRA_HPP
+#define LINEARALGEBRA_HPP
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <stdexcept>
+#include <cmath>
+
+// Dense linear algebra class with static kernels
+class LinearAlgebra {
+private:
+
+	// Householder reduction of the symmetric matrix V (n x n) to tridiagonal form: diagonal d, sub-diagonal e
+	// On exit V holds the accumulated orthogonal transformation
+	inline static void Tridiagonalize(std::vector<double> & V, std::vector<double> & d, std::vector<double> & e, std::size_t n) {
+
+		for (std::size_t j = 0; j < n; ++j) d[j] = V[(n - 1) * n + j];
+
+		for (std::size_t i = n - 1; i > 0; --i) {
+
+			// Scale to avoid under/overflow
+			double scale = 0.0, h = 0.0;
+			for (std::size_t k = 0; k < i; ++k) scale += std::abs(d[k]);
+
+			if (scale == 0.0) {
+				e[i] = d[i - 1];
+				for (std::size_t j = 0; j < i; ++j) {
+					d[j] = V[(i - 1) * n + j];
+					V[i * n + j] = 0.0;
+					V[j * n + i] = 0.0;
+				}
+			}
+			else {
+				// Generate the Householder vector
+				for (std::size_t k = 0; k < i; ++k) {
+					d[k] /= scale;
+					h += d[k] * d[k];
+				}
+				double f = d[i - 1];
+				double g = sqrt(h);
+				if (f > 0) g = -g;
+				e[i] = scale * g;
+				h = h - f * g;
+				d[i - 1] = f - g;
+				for (std::size_t j = 0; j < i; ++j) e[j] = 0.0;
+
+				// Apply the similarity transformation to the remaining columns
+				for (std::size_t j = 0; j < i; ++j) {
+					f = d[j];
+					V[j * n + i] = f;
+					g = e[j] + V[j * n + j] * f;
+					for (std::size_t k = j + 1; k <= i - 1; ++k) {
+						g += V[k * n + j] * d[k];
+						e[k] += V[k * n + j] * f;
+					}
+					e[j] = g;
+				}
+				f = 0.0;
+				for (std::size_t j = 0; j < i; ++j) {
+					e[j] /= h;
+					f += e[j] * d[j];
+				}
+				double hh = f / (h + h);
+				for (std::size_t j = 0; j < i; ++j) e[j] -= hh * d[j];
+				for (std::size_t j = 0; j < i; ++j) {
+					f = d[j];
+					g = e[j];
+					for (std::size_t k = j; k <= i - 1; ++k) V[k * n + j] -= (f * e[k] + g * d[k]);
+					d[j] = V[(i - 1) * n + j];
+					V[i * n + j] = 0.0;
+				}
+			}
+			d[i] = h;
+		}
+
+		// Accumulate the transformations
+		for (std::size_t i = 0; i < n - 1; ++i) {
+			V[(n - 1) * n + i] = V[i * n + i];
+			V[i * n + i] = 1.0;
+			double h = d[i + 1];
+			if (h != 0.0) {
+				for (std::size_t k = 0; k <= i; ++k) d[k] = V[k * n + i + 1] / h;
+				for (std::size_t j = 0; j <= i; ++j) {
+					double g = 0.0;
+					for (std::size_t k = 0; k <= i; ++k) g += V[k * n + i + 1] * V[k * n + j];
+					for (std::size_t k = 0; k <= i; ++k) V[k * n + j] -= g * d[k];
+				}
+			}
+			for (std::size_t k = 0; k <= i; ++k) V[k * n + i + 1] = 0.0;
+		}
+		for (std::size_t j = 0; j < n; ++j) {
+			d[j] = V[(n - 1) * n + j];
+			V[(n - 1) * n + j] = 0.0;
+		}
+		V[(n - 1) * n + n - 1] = 1.0;
+		e[0] = 0.0;
+	}
+
+	// Implicit QL iterations on the tridiagonal matrix (d, e), accumulating the rotations in V
+	inline static void QL(std::vector<double> & V, std::vector<double> & d, std::vector<double> & e, std::size_t n) {
+
+		for (std::size_t i = 1; i < n; ++i) e[i - 1] = e[i];
+		e[n - 1] = 0.0;
+
+		double f = 0.0, tst1 = 0.0;
+		const double eps = std::numeric_limits<double>::epsilon();
+
+		for (std::size_t l = 0; l < n; ++l) {
+
+			// Find a small sub-diagonal element
+			tst1 = std::max(tst1, std::abs(d[l]) + std::abs(e[l]));
+			std::size_t m = l;
+			while (m < n - 1 && std::abs(e[m]) > eps * tst1) m++;
+
+			// If m == l, d[l] is already an eigenvalue, otherwise iterate
+			if (m > l) {
+				int iterations = 0;
+				do {
+					if (++iterations > 60) throw std::runtime_error("Symmetric eigen decomposition did not converge");
+
+					// Compute the implicit shift
+					double g = d[l];
+					double p = (d[l + 1] - g) / (2.0 * e[l]);
+					double r = std::hypot(p, 1.0);
+					if (p < 0) r = -r;
+					d[l] = e[l] / (p + r);
+					d[l + 1] = e[l] * (p + r);
+					double dl1 = d[l + 1];
+					double h = g - d[l];
+					for (std::size_t i = l + 2; i < n; ++i) d[i] -= h;
+					f += h;
+
+					// Implicit QL transformation
+					p = d[m];
+					double c = 1.0, c2 = 1.0, c3 = 1.0;
+					double el1 = e[l + 1];
+					double s = 0.0, s2 = 0.0;
+					for (std::size_t ii = m; ii-- > l;) {
+						c3 = c2;
+						c2 = c;
+						s2 = s;
+						g = c * e[ii];
+						h = c * p;
+						r = std::hypot(p, e[ii]);
+						e[ii + 1] = s * r;
+						s = e[ii] / r;
+						c = p / r;
+						p = c * d[ii] - s * g;
+						d[ii + 1] = h + s * (c * g + s * d[ii]);
+
+						// Accumulate the rotation
+						for (std::size_t k = 0; k < n; ++k) {
+							h = V[k * n + ii + 1];
+							V[k * n + ii + 1] = s * V[k * n + ii] + c * h;
+							V[k * n + ii] = c * V[k * n + ii] - s * h;
+						}
+					}
+					p = -s * s2 * c3 * el1 * e[l] / dl1;
+					e[l] = s * p;
+					d[l] = c * p;
+
+				} while (std::abs(e[l]) > eps * tst1);
+			}
+			d[l] = d[l] + f;
+			e[l] = 0.0;
+		}
+	}
+
+public:
+
+	// Eigen decomposition of the symmetric n x n matrix A = V diag(values) V^T
+	// values are sorted in decreasing order, column k of vectors is the eigenvector of values[k]
+	inline static void SymmetricEigen(const std::vector<double> & A, std::size_t n, std::vector<double> & values, std::vector<double> & vectors) {
+
+		if (n == 0 || A.size() != n * n) throw std::invalid_argument("Symmetric eigen decomposition needs a square matrix");
+
+		std::vector<double> V(A), d(n), e(n);
+		if (n > 1) {
+			Tridiagonalize(V, d, e, n);
+			QL(V, d, e, n);
+		}
+		else {
+			d[0] = A[0];
+			V[0] = 1.0;
+		}
+
+		// Sort in decreasing order
+		std::vector<std::size_t> order(n);
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return d[a] > d[b]; });
+
+		values.resize(n);
+		vectors.resize(n * n);
+		for (std::size_t k = 0; k < n; ++k) {
+			values[k] = d[order[k]];
+			for (std::size_t i = 0; i < n; ++i) vectors[i * n + k] = V[i * n + order[k]];
+		}
+	}
+
+	// Solve A x = b for the n x n matrix A by Gaussian elimination with partial pivoting, b is overwritten by x
+	// Returns false if A is singular
+	inline static bool Solve(std::vector<double> A, std::vector<double> & b, std::size_t n) {
+
+		for (std::size_t c = 0; c < n; ++c) {
+
+			std::size_t pivot = c;
+			for (std::size_t i = c + 1; i < n; ++i) if (std::abs(A[i * n + c]) > std::abs(A[pivot * n + c])) pivot = i;
+			if (std::abs(A[pivot * n + c]) < 1e-300) return false;
+
+			if (pivot != c) {
+				for (std::size_t j = 0; j < n; ++j) std::swap(A[c * n + j], A[pivot * n + j]);
+				std::swap(b[c], b[pivot]);
+			}
+
+			for (std::size_t i = c + 1; i < n; ++i) {
+				double f = A[i * n + c] / A[c * n + c];
+				for (std::size_t j = c; j < n; ++j) A[i * n + j] -= f * A[c * n + j];
+				b[i] -= f * b[c];
+			}
+		}
+
+		for (std::size_t i = n; i-- > 0;) {
+			double s = b[i];
+			for (std::size_t j = i + 1; j < n; ++j) s -= A[i * n + j] * b[j];
+			b[i] = s / A[i * n + i];
+		}
+		return true;
+	}
+
+	// C (m x n) += A (m x k) B (k x n), all row-major with leading dimensions lda, ldb, ldc
+	inline static void Gemm(const double * A, std::size_t lda, const double * B, std::size_t ldb, double * C, std::size_t ldc,
+		std::size_t m, std::size_t n, std::size_t k) {
+
+		// Tile sizes: a 64 x 256 tile of B and a 32 x 256 tile of C fit in L2 together with the tile of A
+		const std::size_t MB = 32, NB = 256, KB = 64;
+
+		for (std::size_t i0 = 0; i0 < m; i0 += MB) {
+			std::size_t i1 = std::min(i0 + MB, m);
+			for (std::size_t p0 = 0; p0 < k; p0 += KB) {
+				std::size_t p1 = std::min(p0 + KB, k);
+				for (std::size_t j0 = 0; j0 < n; j0 += NB) {
+					std::size_t j1 = std::min(j0 + NB, n);
+
+					for (std::size_t i = i0; i < i1; ++i) {
+						double * c = C + i * ldc;
+						for (std::size_t p = p0; p < p1; ++p) {
+							const double a = A[i * lda + p];
+							const double * b = B + p * ldb;
+							for (std::size_t j = j0; j < j1; ++j) c[j] += a * b[j];
+						}
+					}
+				}
+			}
+		}
+	}
+};
+
+#endif // !LINEARALGEBRA_HPP
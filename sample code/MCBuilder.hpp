@@ -14,6 +14,7 @@
 
 #include "Pricer.hpp"
 #include "MIS.hpp"
+#include "RepricingCache.hpp"
 
 #include <thread>
 
@@ -31,6 +32,10 @@ template <class ISDE, class IRNG, class IPayoff, class IInput, template <class I
 		// Not goint to be used in single option pricing
 		MultiOutputList multi_output_list;
 
+		// Results and input fingerprints of the previous multipricing run, so that only the dirty options are repriced
+		RepricingCache repricing_cache;
+		std::string cache_file = "Monte Carlo Option Pricing Cache.txt";
+
 	public:
 
 		// Constructor
@@ -108,9 +113,21 @@ template <class ISDE, class IRNG, class IPayoff, class IInput, template <class I
 				// Assemble data
 				IPricer<ISDE, IRNG, IPayoff, IInput>::get();
 
+				// Load the previous run's results -- if there is no cache file every option is dirty
+				repricing_cache.Load(cache_file);
+
 				// For as many as selected simulations...
 				for (unsigned i = 0; i < number_of_threads; i++) {
 
+					// Fingerprint the inputs of the option and identify it by its contract terms, not by its position in the book
+					auto fingerprint = RepricingCache::Fingerprint(IPricer<ISDE, IRNG, IPayoff, IInput>::getOptionData(),
+						IPricer<ISDE, IRNG, IPayoff, IInput>::getParameterNames(), IPricer<ISDE, IRNG, IPayoff, IInput>::NSteps,
+						IPricer<ISDE, IRNG, IPayoff, IInput>::GetUpperCap(), IPricer<ISDE, IRNG, IPayoff, IInput>::GetLowerCap(),
+						IPricer<ISDE, IRNG, IPayoff, IInput>::getDiscountCurve().get(), &IPricer<ISDE, IRNG, IPayoff, IInput>::getDividends(),
+						&IPricer<ISDE, IRNG, IPayoff, IInput>::getObservationSchedule(), IPricer<ISDE, IRNG, IPayoff, IInput>::getMonitoringDt(),
+						&IPricer<ISDE, IRNG, IPayoff, IInput>::getSABR());
+					std::string option_id = RepricingCache::TradeId(fingerprint);
+
 					// Define a lambda that process the pricing request and saves the outcome of each simulation 
 					// in a multi output list for later use
 					auto multiPricer = [&]() {
@@ -143,15 +160,21 @@ template <class ISDE, class IRNG, class IPayoff, class IInput, template <class I
 
 						// Store the output of this simulation
 						multi_output_list.push_back(std::make_tuple(general_output, mis_output));
+						repricing_cache.Store(option_id, fingerprint, general_output, mis_output);
 
 						// Clear the vectors for the next iteration
 						IPricer<ISDE, IRNG, IPayoff, IInput>::ClearStockFlunctuationsVector();
 						IPricer<ISDE, IRNG, IPayoff, IInput>::ClearTempOptionPriceVector();
 					};
 	
-					// Run the pricing process
-					std::cout << "\nRunning simulation...\n\n";
-					std::thread(multiPricer).join();
+					// Run the pricing process only if the terms, market data or model of the option changed
+					if (repricing_cache.CarryForward(option_id, fingerprint)) {
+						std::cout << "\n" << option_id << ": inputs unchanged, carrying forward the previous result\n\n";
+					}
+					else {
+						std::cout << "\nRunning simulation...\n\n";
+						std::thread(multiPricer).join();
+					}
 						
 					// For n-1 times ask the user to determine the next option to be priced
 					if (i < (number_of_threads - 1)) {
@@ -164,7 +187,12 @@ template <class ISDE, class IRNG, class IPayoff, class IInput, template <class I
 					}
 				}
 	
+				// Keep this run's results for the next one
+				repricing_cache.Save(cache_file);
+				std::cout << "\nRepriced: " << repricing_cache.DirtyIds().size() << "\tCarried forward: " << repricing_cache.CarriedForward() << "\n";
+
 				// Now all options has been pricing and we are going to use the multi-output list for printing
+				// Only the repriced options are written out, the carried forward ones are unchanged since the last run
 				// Choose Output Format by passing the list of multiple outputs to be used iteratively inside the multi-print function
 				IOutput::MultiPrint(multi_output_list); 
 
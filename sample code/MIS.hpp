@@ -27,10 +27,22 @@
 #include "RNG.hpp"
 #include "Payoff.hpp"
 #include "Input.hpp"
+#include "DiscountCurve.hpp"
+#include "Autocallable.hpp"
+#include "Dividends.hpp"
+#include "American.hpp"
+#include "Levy.hpp"
+#include "Schwartz.hpp"
 
 // Alias for the MIS output tuple: mean price, max price, min price, SD, SE, and exact price, decision, elapsed time in seconds
 using Statistics = std::tuple<double, double, double, double, double, double, bool, double>;
 
+// Alias for the autocallable statistics: price, expected life in years, redemption probability on each observation date, knock-in probability
+using AutocallStatistics = std::tuple<double, double, std::vector<double>, double>;
+
+// Alias for the American statistics: price (midpoint of the bounds), lower bound, upper bound, duality gap, and the 95% confidence interval of the price
+using AmericanStatistics = std::tuple<double, double, double, double, double, double>;
+
 // Alias to improve readability for chrono use
 using SystemClock = std::chrono::system_clock;
 
@@ -50,8 +62,33 @@ private:
 	bool decision;
 	double elapsed_time;
 
+	// Autocallable statistics
+	double autocall_price = 0;
+	double expected_life = 0;
+	std::vector<double> redemption_probabilities;
+	double knock_in_probability = 0;
+
+	// American statistics
+	double american_price = 0;
+	double lower_bound = 0;
+	double upper_bound = 0;
+	double duality_gap = 0;
+	double interval_low = 0;
+	double interval_high = 0;
+
 	// Extras for measuring time with StopWatch
 	std::chrono::time_point<SystemClock> start, end;
+
+	// Term structure of rates, otherwise the scalar rate of OptionData is used
+	std::shared_ptr<const DiscountCurve> discount_curve;
+
+	// Dividends of the underlying, none by default
+	DividendSchedule dividends;
+
+	// Discount factor to T: a table read when a discount curve is set
+	inline double Discount(double r, double T) const {
+		return discount_curve ? discount_curve->Discount(T) : exp(-r * T);
+	}
 public:
 
 	// Constructors 
@@ -62,6 +99,16 @@ public:
 	// Assignment Operator
 	MIS & operator=(const MIS & mis);
 
+	// Use the same discount curve as the Pricer
+	inline void setDiscountCurve(const std::shared_ptr<const DiscountCurve> & curve) {
+		discount_curve = curve;
+	}
+
+	// Use the same dividends as the Pricer
+	inline void setDividends(const DividendSchedule & dividends_) {
+		dividends = dividends_;
+	}
+
 	// MIS method to compute statistics given pricer input
 	inline void ComputeStatistics(const PricerOutputMIS & pricer_res) {
 
@@ -94,7 +141,7 @@ public:
 		mean_price /= stock_prices.size();
 
 		// Compute the Standard deviation -- functuations between stock prices
-		SD = (sqrt((sum_sq - (1.0 / option_prices.size())*pow(sum, 2)) / (option_prices.size() - 1))) * exp(-r * T);
+		SD = (sqrt((sum_sq - (1.0 / option_prices.size())*pow(sum, 2)) / (option_prices.size() - 1))) * Discount(r, T);
 
 		// Compute the Standard Error
 		SE = SD / sqrt(option_prices.size());
@@ -107,6 +154,56 @@ public:
 		elapsed_time = std::chrono::duration<double>(end - start).count();
 	}
 	
+	// MIS method to compute the statistics of an autocallable from the redemption counts streamed by AutocallEngine
+	inline void ComputeAutocallStatistics(const AutocallResults & results) {
+
+		double N = static_cast<double>(std::get<2>(results));
+		const std::vector<unsigned long> & redemptions = std::get<3>(results);
+
+		// Price and standard error come straight from the engine; mean_price stays the mean simulated stock price
+		autocall_price = std::get<0>(results);
+		SE = std::get<1>(results);
+		SD = SE * sqrt(N);
+
+		// Probability of redeeming on each date, and the expected life of the product
+		redemption_probabilities.resize(redemptions.size());
+		std::transform(redemptions.begin(), redemptions.end(), redemption_probabilities.begin(), [&](unsigned long c) {
+			return static_cast<double>(c) / N;
+		});
+		expected_life = std::get<4>(results) / N;
+		knock_in_probability = static_cast<double>(std::get<5>(results)) / N;
+
+		elapsed_time = std::chrono::duration<double>(end - start).count();
+	}
+
+	// MIS output tuple with the autocallable statistics
+	inline const AutocallStatistics getAutocallStatistics() const {
+		return std::make_tuple(autocall_price, expected_life, redemption_probabilities, knock_in_probability);
+	}
+
+	// MIS method to compute the statistics of an American option from the bounds of AmericanEngine
+	// The true price lies in [lower, upper]; the interval widens it by the sampling error of each bound
+	inline void ComputeAmericanStatistics(const AmericanResults & results) {
+
+		lower_bound = std::get<0>(results);
+		upper_bound = std::get<2>(results);
+		duality_gap = upper_bound - lower_bound;
+		interval_low = lower_bound - 1.96 * std::get<1>(results);
+		interval_high = upper_bound + 1.96 * std::get<3>(results);
+
+		// The midpoint is the point estimate; mean_price stays the mean simulated stock price
+		american_price = 0.5 * (lower_bound + upper_bound);
+		SE = std::get<1>(results);
+		SD = SE * sqrt(static_cast<double>(std::get<4>(results)));
+
+		elapsed_time = std::chrono::duration<double>(end - start).count();
+	}
+
+	// MIS output tuple with the American statistics
+	inline const AmericanStatistics getAmericanStatistics() const {
+		return std::make_tuple(american_price, lower_bound, upper_bound, duality_gap, interval_low, interval_high);
+	}
+
 	// MIS method that computes the exact prices of the options using the BS formulas
 	// This function is of type int to emulate the advantage of switch-case that breaks the 
 	// conditional statement flow in case a conditionis satisfied
@@ -125,6 +222,17 @@ public:
 		double S	= std::get<3>(option_data);		// Stock price
 		double K	= std::get<4>(option_data);		// Strike price
 
+		// With a discount curve, price with the zero rate to expiry
+		double df	= Discount(r, T);
+		double rate	= r;
+		r			= -log(df) / T;
+
+		// Dividends: continuous yield, and discrete dividends escrowed out of the stock price
+		double q	= dividends.Yield();
+		if (dividends.HasDiscrete()) {
+			S = dividends.EscrowedSpot(S, T, [&](double t) { return Discount(rate, t); });
+		}
+
 		// Regular expression to be used to indicate if the underlying option is a call or a put
 		std::regex reg("(.*)(Call)");
 
@@ -133,10 +241,10 @@ public:
 
 			boost::math::normal_distribution<double> n(0, 1);
 
-			double d1	= (log(S / K) + (r + pow(vol, 2) / 2)*T) / (vol*sqrt(T));
+			double d1	= (log(S / K) + (r - q + pow(vol, 2) / 2)*T) / (vol*sqrt(T));
 			double d2	= d1 - vol*sqrt(T);
 
-			exact_price = S*exp((r - r)*T)*cdf(n, d1) - K*exp(-r*T)*cdf(n, d2);
+			exact_price = S*exp(-q*T)*cdf(n, d1) - K*df*cdf(n, d2);
 
 			return 0;
 		}
@@ -145,15 +253,92 @@ public:
 
 			boost::math::normal_distribution<double> n(0, 1);
 
-			double d1	= (log(S / K) + (r + pow(vol, 2) / 2)*T) / (vol*sqrt(T));
+			double d1	= (log(S / K) + (r - q + pow(vol, 2) / 2)*T) / (vol*sqrt(T));
 			double d2	= d1 - vol*sqrt(T);
 
-			exact_price = K*exp(-r*T)*cdf(n, -d2) - S*exp((r - r)*T)*cdf(n, -d1);
+			exact_price = K*df*cdf(n, -d2) - S*exp(-q*T)*cdf(n, -d1);
 
 			return 0;
 		}
 	}
 
+	// MIS method that computes the exact price of a knock-in or knock-out Call/Put with the Reiner-Rubinstein formulas
+	// The barrier is the upper or the lower cap of the payoff (see PayoffSmoothing::HasBarrier), monitored continuously
+	inline int BarrierExactPrice(const PricerOutputMIS & pricer_res, double upper, double lower) {
+
+		// Get the stock price names and the option data
+		auto names = std::get<4>(pricer_res);
+		auto option_data = std::get<1>(pricer_res);
+
+		double vol	= std::get<0>(option_data);		// Volatility
+		double r	= std::get<1>(option_data);		// Rate
+		double T	= std::get<2>(option_data);		// Expiry
+		double S	= std::get<3>(option_data);		// Stock price
+		double K	= std::get<4>(option_data);		// Strike price
+
+		bool has_upper = PayoffSmoothing::HasBarrier(upper), has_lower = PayoffSmoothing::HasBarrier(lower);
+		if (has_upper == has_lower) throw std::invalid_argument("Reiner-Rubinstein formulas need exactly one barrier");
+
+		// With a discount curve, price with the zero rate to expiry
+		double rate = r;
+		r = -log(Discount(r, T)) / T;
+
+		// Discrete dividends escrowed out of the stock price, as in ExactPrice()
+		if (dividends.HasDiscrete()) {
+			S = dividends.EscrowedSpot(S, T, [&](double t) { return Discount(rate, t); });
+		}
+
+		bool call = std::regex_match(names[2], std::regex("(.*)(Call)(.*)"));
+		bool knock_in = std::regex_match(names[2], std::regex("(.*)([Kk]nock-?[Ii]n)(.*)"));
+		exact_price = BlackScholes::Barrier(call, has_upper, knock_in, S, K, has_upper ? upper : lower, T, r, dividends.Yield(), vol);
+
+		return 0;
+	}
+
+	// MIS method that computes the exact price of a European under a Levy model (VarianceGamma, NormalInverseGaussian) with the COS method
+	// Use it instead of ExactPrice() when the prices come from LevyEngine
+	template <class Model>
+	inline int LevyExactPrice(const PricerOutputMIS & pricer_res, const Model & model) {
+
+		// Get the stock price names and the option data
+		auto names = std::get<4>(pricer_res);
+		auto option_data = std::get<1>(pricer_res);
+
+		double r	= std::get<1>(option_data);		// Rate
+		double T	= std::get<2>(option_data);		// Expiry
+		double S	= std::get<3>(option_data);		// Stock price
+		double K	= std::get<4>(option_data);		// Strike price
+
+		// With a discount curve, price with the zero rate to expiry
+		r = -log(Discount(r, T)) / T;
+
+		std::regex reg("(.*)(Call)");
+		exact_price = COSPricer::Price(model, std::regex_match(names[2], reg), S, K, T, r, dividends.Yield());
+
+		return 0;
+	}
+
+	// MIS method that computes the exact price of a European on a commodity spot (T_f = 0) or on its futures of maturity T_f
+	// under the Schwartz-Smith model; the spot of the option data is not used, the model carries its own curve
+	inline int CommodityExactPrice(const PricerOutputMIS & pricer_res, const SchwartzSmith & model, double T_f = 0.0) {
+
+		// Get the stock price names and the option data
+		auto names = std::get<4>(pricer_res);
+		auto option_data = std::get<1>(pricer_res);
+
+		double r	= std::get<1>(option_data);		// Rate
+		double T	= std::get<2>(option_data);		// Expiry
+		double K	= std::get<4>(option_data);		// Strike price
+
+		// With a discount curve, price with the zero rate to expiry
+		r = -log(Discount(r, T)) / T;
+
+		std::regex reg("(.*)(Call)");
+		exact_price = model.FuturesOption(std::regex_match(names[2], reg), K, T, (T_f > 0.0) ? T_f : T, r);
+
+		return 0;
+	}
+
 	// Decision making function that compares the approximated option price to the exact price and determines if they are 'epsilon' close
 	// 'epsilon can be determined depending on the accuracy the user wants. Here we pick epsilon = 0.01
 	inline void DecisionMaking(const PricerOutputMIS & pricer_res) {
@@ -0,0 +1,457 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ===================================================================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Versioned market data snapshots, memory-mapped and shared zero-copy
+*
+*/
+
+/*   A snapshot is an immutable binary file that holds all market inputs of a pricing run: spots, rate curves, volatility
+*    surfaces and correlation matrices. It is mapped read-only into memory, so that all pricing threads and processes
+*    that open the same file share the same physical pages and nothing is copied or parsed. A small index built when
+*    the snapshot is opened resolves names to handles that point directly into the mapping.
+*
+*    File layout:
+*        SnapshotHeader
+*        SnapshotEntry[entry_count]
+*        double payload[]                -- 8-byte aligned, each entry points to its first double
+*
+*    Curves hold 2 rows: pillar times and continuously compounded zero rates
+*    Surfaces hold expiries (rows), strikes (cols), followed by the rows x cols volatilities in row-major order
+*    Correlation matrices hold n x n values in row-major order
+*    Pillar times, expiries and strikes are strictly increasing
+*
+*    Every version of a snapshot is its own immutable file, name.v<version>. A new version never overwrites a file that
+*    readers may still have mapped, it is published by switching the store to the new file.
+*/
+
+// Multiple inclusion guards
+#ifndef MARKETDATA_HPP
+#define MARKETDATA_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+
+#ifdef _WIN32
+// Keep the min/max macros and the rarely used APIs of windows.h out of every translation unit that includes this header
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Type of a market data entry
+enum class MarketDataKind : std::uint32_t {
+	Scalar		= 1,	// Spot price, flat rate, flat volatility
+	Curve		= 2,	// Zero rate curve
+	Surface		= 3,	// Volatility surface
+	Correlation	= 4		// Correlation matrix
+};
+
+// On-disk header of a snapshot file
+struct SnapshotHeader {
+	char			magic[8];			// "MCSNAP1"
+	std::uint32_t	format_version;		// Layout version of the file
+	std::uint32_t	entry_count;		// Number of entries in the table
+	std::uint64_t	snapshot_version;	// Monotonic version of the market data
+	std::uint64_t	payload_offset;		// Offset of the first payload double, in bytes
+};
+
+// On-disk table entry of a snapshot file
+struct SnapshotEntry {
+	char			name[48];			// Null-terminated name of the curve/surface/etc
+	MarketDataKind	kind;				// Type of the entry
+	std::uint32_t	rows;				// Rows of the entry
+	std::uint32_t	cols;				// Columns of the entry
+	std::uint32_t	reserved;			// Padding
+	std::uint64_t	offset;				// Offset in doubles from the payload start
+	std::uint64_t	size;				// Number of doubles
+};
+
+// True if the n values are strictly increasing, as the axes of curves and surfaces must be
+inline bool StrictlyIncreasing(const double * x, std::size_t n) {
+	for (std::size_t i = 1; i < n; ++i) {
+		if (!(x[i] > x[i - 1])) return false;
+	}
+	return true;
+}
+
+// Lightweight read-only view into a snapshot entry -- valid as long as its snapshot is alive
+struct MarketHandle {
+	MarketDataKind	kind;
+	std::uint32_t	rows;
+	std::uint32_t	cols;
+	const double *	data;
+
+	// Scalar value
+	inline double Value() const { return data[0]; }
+
+	// Linear interpolation of a curve in time, flat extrapolation
+	inline double Interpolate(double t) const {
+
+		const double * times = data;
+		const double * values = data + cols;
+
+		if (t <= times[0]) return values[0];
+		if (t >= times[cols - 1]) return values[cols - 1];
+
+		std::size_t i = std::upper_bound(times, times + cols, t) - times;
+		double w = (t - times[i - 1]) / (times[i] - times[i - 1]);
+		return (1.0 - w) * values[i - 1] + w * values[i];
+	}
+
+	// Bilinear interpolation of a surface in (expiry, strike), flat extrapolation
+	inline double Interpolate(double t, double k) const {
+
+		const double * expiries = data;
+		const double * strikes = data + rows;
+		const double * vols = data + rows + cols;
+
+		auto bracket = [](const double * x, std::uint32_t n, double v, std::size_t & i, double & w) {
+			if (n == 1 || v <= x[0]) { i = 0; w = 0.0; return; }
+			if (v >= x[n - 1]) { i = n - 2; w = 1.0; return; }
+			i = (std::upper_bound(x, x + n, v) - x) - 1;
+			w = (v - x[i]) / (x[i + 1] - x[i]);
+		};
+
+		std::size_t i, j;
+		double wt, wk;
+		bracket(expiries, rows, t, i, wt);
+		bracket(strikes, cols, k, j, wk);
+
+		std::size_t i1 = (rows == 1) ? i : i + 1;
+		std::size_t j1 = (cols == 1) ? j : j + 1;
+
+		double v0 = (1.0 - wk) * vols[i * cols + j] + wk * vols[i * cols + j1];
+		double v1 = (1.0 - wk) * vols[i1 * cols + j] + wk * vols[i1 * cols + j1];
+		return (1.0 - wt) * v0 + wt * v1;
+	}
+
+	// Element (i, j) of a correlation matrix
+	inline double operator()(std::uint32_t i, std::uint32_t j) const { return data[i * cols + j]; }
+};
+
+// Immutable memory-mapped market data snapshot
+class MarketSnapshot {
+private:
+	std::string file_name;
+	const char * base = nullptr;	// Start of the mapping
+	std::size_t length = 0;			// Length of the mapping in bytes
+	std::uint64_t version = 0;		// Snapshot version from the header
+	std::unordered_map<std::string, MarketHandle> index;	// Name -> handle
+
+#ifdef _WIN32
+	HANDLE file_handle = INVALID_HANDLE_VALUE;
+	HANDLE mapping_handle = NULL;
+#endif
+
+	// Map the file read-only into the address space
+	inline void Map() {
+#ifdef _WIN32
+		file_handle = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file_handle == INVALID_HANDLE_VALUE) throw std::runtime_error("Cannot open market data snapshot: " + file_name);
+
+		LARGE_INTEGER size;
+		GetFileSizeEx(file_handle, &size);
+		length = static_cast<std::size_t>(size.QuadPart);
+
+		mapping_handle = CreateFileMappingA(file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping_handle == NULL) throw std::runtime_error("Cannot map market data snapshot: " + file_name);
+
+		base = static_cast<const char *>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+		if (base == nullptr) throw std::runtime_error("Cannot map market data snapshot: " + file_name);
+#else
+		int fd = open(file_name.c_str(), O_RDONLY);
+		if (fd < 0) throw std::runtime_error("Cannot open market data snapshot: " + file_name);
+
+		struct stat st;
+		if (fstat(fd, &st) != 0) { close(fd); throw std::runtime_error("Cannot stat market data snapshot: " + file_name); }
+		length = static_cast<std::size_t>(st.st_size);
+
+		void * p = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+		if (p == MAP_FAILED) throw std::runtime_error("Cannot map market data snapshot: " + file_name);
+		base = static_cast<const char *>(p);
+#endif
+	}
+
+	inline void Unmap() {
+#ifdef _WIN32
+		if (base != nullptr) UnmapViewOfFile(base);
+		if (mapping_handle != NULL) CloseHandle(mapping_handle);
+		if (file_handle != INVALID_HANDLE_VALUE) CloseHandle(file_handle);
+#else
+		if (base != nullptr) munmap(const_cast<char *>(base), length);
+#endif
+		base = nullptr;
+	}
+
+	// Number of doubles an entry of this kind and shape must hold, 0 if the shape is invalid
+	inline static std::uint64_t ExpectedSize(const SnapshotEntry & e) {
+		std::uint64_t rows = e.rows, cols = e.cols;
+		if (rows == 0 || cols == 0) return 0;
+		switch (e.kind) {
+		case MarketDataKind::Scalar:		return (rows == 1 && cols == 1) ? 1 : 0;
+		case MarketDataKind::Curve:			return (rows == 2) ? 2 * cols : 0;
+		case MarketDataKind::Surface:		return rows + cols + rows * cols;
+		case MarketDataKind::Correlation:	return (rows == cols) ? rows * cols : 0;
+		default:							return 0;
+		}
+	}
+
+	// Validate the header and build the name index
+	inline void BuildIndex() {
+
+		if (length < sizeof(SnapshotHeader)) throw std::runtime_error("Truncated market data snapshot: " + file_name);
+
+		const SnapshotHeader * header = reinterpret_cast<const SnapshotHeader *>(base);
+		if (std::strncmp(header->magic, "MCSNAP1", 8) != 0 || header->format_version != 1) {
+			throw std::runtime_error("Invalid market data snapshot: " + file_name);
+		}
+
+		version = header->snapshot_version;
+
+		// The payload must start on a double boundary, so that every entry is aligned for the typed accessors
+		if (sizeof(SnapshotHeader) + header->entry_count * sizeof(SnapshotEntry) > header->payload_offset
+			|| header->payload_offset > length || header->payload_offset % alignof(double) != 0) {
+			throw std::runtime_error("Corrupted market data snapshot: " + file_name);
+		}
+
+		const SnapshotEntry * entries = reinterpret_cast<const SnapshotEntry *>(base + sizeof(SnapshotHeader));
+		const double * payload = reinterpret_cast<const double *>(base + header->payload_offset);
+		std::size_t payload_size = (length - header->payload_offset) / sizeof(double);
+
+		index.reserve(header->entry_count);
+		for (std::uint32_t i = 0; i < header->entry_count; ++i) {
+			const SnapshotEntry & e = entries[i];
+			if (e.offset > payload_size || e.size > payload_size - e.offset || e.size != ExpectedSize(e)) {
+				throw std::runtime_error("Corrupted market data snapshot: " + file_name);
+			}
+
+			// The interpolation brackets the axes by binary search, so they must be sorted
+			const double * values = payload + e.offset;
+			bool sorted = true;
+			if (e.kind == MarketDataKind::Curve) sorted = StrictlyIncreasing(values, e.cols);
+			if (e.kind == MarketDataKind::Surface) sorted = StrictlyIncreasing(values, e.rows) && StrictlyIncreasing(values + e.rows, e.cols);
+			if (!sorted) throw std::runtime_error("Unsorted axis in market data snapshot: " + file_name);
+
+			std::string name(e.name, strnlen(e.name, sizeof(e.name)));
+			index[name] = MarketHandle{ e.kind, e.rows, e.cols, values };
+		}
+	}
+
+public:
+
+	// Constructors
+	// The snapshot is mapped and indexed once here; afterwards it is read-only and safe to share between threads
+	explicit MarketSnapshot(const std::string & file_name_) : file_name(file_name_) {
+		try {
+			Map();
+			BuildIndex();
+		}
+		catch (...) {
+			Unmap();
+			throw;
+		}
+	}
+
+	// Snapshots own a mapping and cannot be copied -- share them through std::shared_ptr instead
+	MarketSnapshot(const MarketSnapshot &) = delete;
+	MarketSnapshot & operator=(const MarketSnapshot &) = delete;
+
+	// Getters
+	inline std::uint64_t Version() const { return version; }
+	inline const std::string & FileName() const { return file_name; }
+	inline bool Contains(const std::string & name) const { return index.find(name) != index.end(); }
+
+	// Resolve a name to its handle, checking the expected type
+	inline const MarketHandle & Handle(const std::string & name, MarketDataKind kind) const {
+
+		auto it = index.find(name);
+		if (it == index.end()) throw std::out_of_range("Market data not found in snapshot: " + name);
+		if (it->second.kind != kind) throw std::invalid_argument("Market data has a different type: " + name);
+		return it->second;
+	}
+
+	// Convenience getters
+	inline double Spot(const std::string & name) const { return Handle(name, MarketDataKind::Scalar).Value(); }
+	inline const MarketHandle & Curve(const std::string & name) const { return Handle(name, MarketDataKind::Curve); }
+	inline const MarketHandle & Surface(const std::string & name) const { return Handle(name, MarketDataKind::Surface); }
+	inline const MarketHandle & Correlation(const std::string & name) const { return Handle(name, MarketDataKind::Correlation); }
+
+	// Destructor
+	~MarketSnapshot() { Unmap(); }
+};
+
+// Builder of snapshot files -- used by the market data feed, never by the pricing threads
+class MarketSnapshotWriter {
+private:
+	std::vector<SnapshotEntry> entries;
+	std::vector<double> payload;
+
+	inline void Add(const std::string & name, MarketDataKind kind, std::uint32_t rows, std::uint32_t cols, const std::vector<double> & values) {
+
+		if (name.size() >= sizeof(SnapshotEntry::name)) throw std::invalid_argument("Market data name too long: " + name);
+
+		SnapshotEntry e;
+		std::memset(&e, 0, sizeof(e));
+		std::memcpy(e.name, name.c_str(), name.size());
+		e.kind = kind;
+		e.rows = rows;
+		e.cols = cols;
+		e.offset = payload.size();
+		e.size = values.size();
+
+		entries.push_back(e);
+		payload.insert(payload.end(), values.begin(), values.end());
+	}
+
+public:
+
+	// Constructor
+	explicit MarketSnapshotWriter() {}
+
+	// Setters for the different types of market data
+	inline void AddScalar(const std::string & name, double value) {
+		Add(name, MarketDataKind::Scalar, 1, 1, std::vector<double>(1, value));
+	}
+
+	inline void AddCurve(const std::string & name, const std::vector<double> & times, const std::vector<double> & zero_rates) {
+
+		if (times.empty() || times.size() != zero_rates.size() || !StrictlyIncreasing(times.data(), times.size())) {
+			throw std::invalid_argument("Invalid curve: " + name);
+		}
+
+		std::vector<double> values(times);
+		values.insert(values.end(), zero_rates.begin(), zero_rates.end());
+		Add(name, MarketDataKind::Curve, 2, static_cast<std::uint32_t>(times.size()), values);
+	}
+
+	inline void AddSurface(const std::string & name, const std::vector<double> & expiries, const std::vector<double> & strikes,
+		const std::vector<double> & vols) {
+
+		if (expiries.empty() || strikes.empty() || vols.size() != expiries.size() * strikes.size()
+			|| !StrictlyIncreasing(expiries.data(), expiries.size()) || !StrictlyIncreasing(strikes.data(), strikes.size())) {
+			throw std::invalid_argument("Invalid surface: " + name);
+		}
+
+		std::vector<double> values(expiries);
+		values.insert(values.end(), strikes.begin(), strikes.end());
+		values.insert(values.end(), vols.begin(), vols.end());
+		Add(name, MarketDataKind::Surface, static_cast<std::uint32_t>(expiries.size()), static_cast<std::uint32_t>(strikes.size()), values);
+	}
+
+	inline void AddCorrelation(const std::string & name, std::uint32_t n, const std::vector<double> & matrix) {
+
+		if (matrix.size() != static_cast<std::size_t>(n) * n) throw std::invalid_argument("Invalid correlation matrix: " + name);
+		Add(name, MarketDataKind::Correlation, n, n, matrix);
+	}
+
+	// Name of the immutable file that holds one version of a snapshot
+	inline static std::string VersionedName(const std::string & base_name, std::uint64_t snapshot_version) {
+		return base_name + ".v" + std::to_string(snapshot_version);
+	}
+
+	// Write one version of the snapshot to its own file, VersionedName(base_name, snapshot_version), and return its name
+	// The file is written under a temporary name and renamed, so readers never see a half-written snapshot. An existing
+	// version is never replaced: readers may have it mapped, and on Windows a mapped file cannot be replaced at all
+	inline std::string Write(const std::string & base_name, std::uint64_t snapshot_version) const {
+
+		std::string file_name = VersionedName(base_name, snapshot_version);
+
+		SnapshotHeader header;
+		std::memset(&header, 0, sizeof(header));
+		std::memcpy(header.magic, "MCSNAP1", 8);
+		header.format_version = 1;
+		header.entry_count = static_cast<std::uint32_t>(entries.size());
+		header.snapshot_version = snapshot_version;
+
+		// Align the payload to 8 bytes
+		std::uint64_t table_end = sizeof(SnapshotHeader) + entries.size() * sizeof(SnapshotEntry);
+		header.payload_offset = (table_end + 7) & ~std::uint64_t(7);
+
+		std::string tmp_name = file_name + ".tmp";
+		{
+			std::ofstream file(tmp_name, std::ios::binary | std::ios::trunc);
+			if (!file.is_open()) throw std::runtime_error("Cannot write market data snapshot: " + file_name);
+
+			file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+			if (!entries.empty()) file.write(reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(SnapshotEntry));
+
+			const char padding[8] = { 0 };
+			file.write(padding, static_cast<std::streamsize>(header.payload_offset - table_end));
+			if (!payload.empty()) file.write(reinterpret_cast<const char *>(payload.data()), payload.size() * sizeof(double));
+		}
+
+		// Give the complete file its versioned name in one step, failing if that version already exists
+		// (link() never replaces its target, the temporary name is dropped afterwards)
+#ifdef _WIN32
+		bool published = MoveFileExA(tmp_name.c_str(), file_name.c_str(), 0) != 0;
+#else
+		bool published = link(tmp_name.c_str(), file_name.c_str()) == 0;
+#endif
+		std::remove(tmp_name.c_str());
+		if (!published) throw std::runtime_error("Cannot publish market data snapshot: " + file_name);
+		return file_name;
+	}
+
+	// Destructor
+	~MarketSnapshotWriter() {}
+};
+
+// Process-wide store that holds the current snapshot
+// Pricing jobs take a reference with Current() and keep using it for their whole run, even if a new snapshot is
+// published meanwhile; the old mapping is released when the last job that uses it finishes
+class MarketDataStore {
+private:
+	std::shared_ptr<const MarketSnapshot> current;
+
+public:
+
+	// Constructor
+	explicit MarketDataStore() {}
+	explicit MarketDataStore(const std::string & file_name) { Publish(file_name); }
+	explicit MarketDataStore(const std::string & base_name, std::uint64_t snapshot_version) { Publish(base_name, snapshot_version); }
+
+	// Open a new snapshot and switch to it with an atomic pointer swap
+	// The mapping and indexing are done before the swap, so readers never wait for a reload
+	inline void Publish(const std::string & file_name) {
+		std::shared_ptr<const MarketSnapshot> next = std::make_shared<const MarketSnapshot>(file_name);
+		std::atomic_store(&current, next);
+	}
+
+	// Switch to the given version of a snapshot written by MarketSnapshotWriter::Write()
+	// The file of the previous version stays untouched; the feed may delete it once no job holds it any more
+	inline void Publish(const std::string & base_name, std::uint64_t snapshot_version) {
+		Publish(MarketSnapshotWriter::VersionedName(base_name, snapshot_version));
+	}
+
+	// Get the current snapshot
+	inline std::shared_ptr<const MarketSnapshot> Current() const {
+		return std::atomic_load(&current);
+	}
+
+	// Destructor
+	~MarketDataStore() {}
+};
+
+#endif // !MARKETDATA_HPP
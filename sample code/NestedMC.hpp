@@ -0,0 +1,238 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ===================================================================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Nested Monte Carlo for risk on risk with proxies and adaptive inner samples
+*
+*/
+
+/*   Outer scenarios move the underlying to a horizon H under the real-world drift. In each scenario the position is
+*    revalued by an inner simulation to its maturity T under the pricing measure, and the loss is L = V_0 - V_H.
+*    The engine estimates the mean of V_H and the VaR and expected shortfall of L at level alpha.
+*
+*    Three devices cut the outer x inner cost:
+*        - Shared inner random numbers: inner path j uses the same normal in every scenario, so the inner estimate is
+*          a smooth function of the scenario and the ranking of the scenarios is not blurred by independent noise.
+*          The normals come in antithetic pairs, which removes the common error of the linear part of the payoff;
+*          the standard errors are taken over the pair means, which are the independent draws.
+*        - Regression proxy: the pilot inner means are regressed on 1, y, ..., y^4 (y = S_H / S_0), which gives a smooth
+*          value for every scenario and the proxy VaR and ES at no extra inner cost.
+*        - Adaptive allocation: only the scenarios near the VaR threshold change the tail estimates. In each round the
+*          inner sample of the scenarios with the smallest |L - VaR| / SE is doubled, until the budget is spent.
+*
+*    Each round is a flat list of (scenario, chunk of inner paths) tasks on the parallel loop, and the chunk sums are
+*    reduced per scenario in chunk order, so the results do not depend on the number of threads.
+*/
+
+// Multiple inclusion guards
+#ifndef NESTEDMC_HPP
+#define NESTEDMC_HPP
+
+#include <vector>
+#include <random>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+#include "LinearAlgebra.hpp"
+#include "Parallel.hpp"
+
+// Nested simulation output
+struct NestedResults {
+	std::vector<double> spots;			// Outer scenarios, the underlying at the horizon
+	std::vector<double> values;			// Inner estimate of the value in each scenario
+	std::vector<double> proxies;		// Regression proxy of the value in each scenario
+	std::vector<unsigned long> inner;	// Inner paths spent on each scenario
+	double V0 = 0.0;					// Value today
+	double mean = 0.0;					// Mean value at the horizon
+	double VaR = 0.0;					// Value at risk of the loss V0 - V_H
+	double ES = 0.0;					// Expected shortfall of the loss
+	double proxy_VaR = 0.0;				// Same, from the proxy values
+	double proxy_ES = 0.0;
+	unsigned long inner_total = 0;		// Inner paths spent in total
+};
+
+// Nested Monte Carlo engine for a position paying payoff(S_T) at T on a GBM underlying
+class NestedEngine {
+private:
+	double r;		// Interest rate, drift of the inner simulation
+	double vol;		// Volatility
+	double q;		// Dividend yield
+	double mu;		// Real-world drift of the outer simulation
+
+	static constexpr std::size_t basis = 5;
+	static constexpr std::size_t chunk = 1024;	// Inner paths per task
+
+	// VaR and ES of the losses V0 - values at level alpha
+	inline static void TailMeasures(double V0, const std::vector<double> & values, double alpha, double & VaR, double & ES) {
+		std::vector<double> loss(values.size());
+		for (std::size_t i = 0; i < values.size(); ++i) loss[i] = V0 - values[i];
+		std::sort(loss.begin(), loss.end());
+		std::size_t k = std::min(static_cast<std::size_t>(alpha * static_cast<double>(loss.size())), loss.size() - 1);
+		VaR = loss[k];
+		ES = std::accumulate(loss.begin() + k, loss.end(), 0.0) / static_cast<double>(loss.size() - k);
+	}
+
+public:
+
+	// Constructor
+	explicit NestedEngine(double r_, double vol_, double q_ = 0.0, double mu_ = 0.0) : r(r_), vol(vol_), q(q_), mu(mu_) {}
+
+	// n_outer scenarios at the horizon H, pilot inner paths per scenario, then up to budget more inner paths in total,
+	// spent in rounds on the scenarios closest to the VaR, with at most max_inner paths per scenario
+	inline NestedResults Run(const std::function<double(double)> & payoff, double S, double H, double T, unsigned long n_outer,
+		unsigned long pilot = 256, unsigned long budget = 0, unsigned long max_inner = 1 << 16, double alpha = 0.99,
+		unsigned rounds = 8, unsigned long seed = 5489u, unsigned threads = 0) const {
+
+		// Inner counts stay even, so every task covers whole antithetic pairs
+		if (H <= 0.0 || T <= H || n_outer < basis * 4 || pilot < 2 || pilot % 2 || max_inner < pilot || max_inner % 2
+			|| alpha <= 0.0 || alpha >= 1.0) {
+			throw std::invalid_argument("Invalid nested simulation parameters");
+		}
+
+		// Outer scenarios
+		NestedResults res;
+		std::mt19937_64 eng(seed);
+		std::normal_distribution<double> nd(0.0, 1.0);
+		res.spots.resize(n_outer);
+		for (auto & s : res.spots) s = S * exp((mu - q - 0.5 * vol * vol) * H + vol * sqrt(H) * nd(eng));
+
+		// Shared inner normals, one per inner path, the same for every scenario
+		// in antithetic pairs, so that every even prefix of the stream has mean exactly zero
+		std::vector<double> z(max_inner);
+		for (unsigned long j = 0; j < max_inner; j += 2) {
+			z[j] = nd(eng);
+			z[j + 1] = -z[j];
+		}
+
+		const double tau = T - H, df = exp(-r * tau);
+		const double drift = (r - q - 0.5 * vol * vol) * tau, diffusion = vol * sqrt(tau);
+
+		// Inner sums of each scenario: payoff and squared antithetic pair mean over the inner paths spent so far
+		// The pair means are the independent draws, so the standard error is taken over them
+		std::vector<double> sum(n_outer, 0.0), sum_sq(n_outer, 0.0);
+		res.inner.assign(n_outer, 0);
+
+		// Extend scenario i from its current inner count to target, as a flat list of tasks
+		auto Extend = [&](const std::vector<std::size_t> & scenarios, const std::vector<unsigned long> & target) {
+
+			std::vector<std::size_t> task_scenario, task_first;
+			std::vector<unsigned long> task_last;
+			for (std::size_t m = 0; m < scenarios.size(); ++m) {
+				std::size_t i = scenarios[m];
+				for (unsigned long j = res.inner[i]; j < target[m]; j += chunk) {
+					task_scenario.push_back(i);
+					task_first.push_back(j);
+					task_last.push_back(std::min<unsigned long>(j + chunk, target[m]));
+				}
+			}
+
+			std::vector<double> task_sum(task_scenario.size()), task_sum_sq(task_scenario.size());
+			ParallelFor(0, task_scenario.size(), [&](std::size_t t, unsigned) {
+				const double s = res.spots[task_scenario[t]];
+				double s1 = 0.0, s2 = 0.0;
+				for (unsigned long j = task_first[t]; j < task_last[t]; j += 2) {
+					double v = payoff(s * exp(drift + diffusion * z[j])) + payoff(s * exp(drift + diffusion * z[j + 1]));
+					s1 += v;
+					s2 += 0.25 * v * v;
+				}
+				task_sum[t] = s1;
+				task_sum_sq[t] = s2;
+			}, threads);
+
+			// Reduce in task order, which is chunk order within a scenario
+			for (std::size_t t = 0; t < task_scenario.size(); ++t) {
+				sum[task_scenario[t]] += task_sum[t];
+				sum_sq[task_scenario[t]] += task_sum_sq[t];
+			}
+			for (std::size_t m = 0; m < scenarios.size(); ++m) {
+				res.inner_total += target[m] - res.inner[scenarios[m]];
+				res.inner[scenarios[m]] = target[m];
+			}
+		};
+
+		// Pilot inner sample for every scenario
+		std::vector<std::size_t> all(n_outer);
+		std::iota(all.begin(), all.end(), 0);
+		Extend(all, std::vector<unsigned long>(n_outer, pilot));
+
+		// Value today with all the inner paths, on the same shared normals
+		double v0 = 0.0;
+		const double drift0 = (r - q - 0.5 * vol * vol) * T, diffusion0 = vol * sqrt(T);
+		for (unsigned long j = 0; j < max_inner; ++j) v0 += payoff(S * exp(drift0 + diffusion0 * z[j]));
+		res.V0 = exp(-r * T) * v0 / static_cast<double>(max_inner);
+
+		// Regression proxy on the pilot means
+		std::vector<double> A(basis * basis, 0.0), b(basis, 0.0);
+		for (unsigned long i = 0; i < n_outer; ++i) {
+			double y = res.spots[i] / S, f[basis] = { 1.0, y, y * y, y * y * y, y * y * y * y };
+			double v = df * sum[i] / static_cast<double>(pilot);
+			for (std::size_t a = 0; a < basis; ++a) {
+				b[a] += f[a] * v;
+				for (std::size_t c = 0; c < basis; ++c) A[a * basis + c] += f[a] * f[c];
+			}
+		}
+		if (!LinearAlgebra::Solve(A, b, basis)) throw std::runtime_error("Nested proxy regression is singular");
+		res.proxies.resize(n_outer);
+		for (unsigned long i = 0; i < n_outer; ++i) {
+			double y = res.spots[i] / S;
+			res.proxies[i] = b[0] + y * (b[1] + y * (b[2] + y * (b[3] + y * b[4])));
+		}
+		TailMeasures(res.V0, res.proxies, alpha, res.proxy_VaR, res.proxy_ES);
+
+		// Adaptive rounds: double the inner sample of the scenarios whose side of the VaR is the least certain
+		res.values.resize(n_outer);
+		unsigned long spent = 0;
+		for (unsigned round = 0; round <= rounds; ++round) {
+
+			std::vector<double> se(n_outer);
+			for (unsigned long i = 0; i < n_outer; ++i) {
+				double n = static_cast<double>(res.inner[i]), m = sum[i] / n, pairs = 0.5 * n;
+				res.values[i] = df * m;
+				se[i] = df * sqrt(std::max(sum_sq[i] / pairs - m * m, 0.0) / pairs);
+			}
+			if (round == rounds || spent >= budget) break;
+
+			double VaR, ES;
+			TailMeasures(res.V0, res.values, alpha, VaR, ES);
+
+			std::vector<double> score(n_outer);
+			for (unsigned long i = 0; i < n_outer; ++i) {
+				double distance = std::abs(res.V0 - res.values[i] - VaR);
+				score[i] = (res.inner[i] >= max_inner) ? 1e300 : distance / std::max(se[i], 1e-12);
+			}
+			std::vector<std::size_t> order(all);
+			std::stable_sort(order.begin(), order.end(), [&](std::size_t x, std::size_t y) { return score[x] < score[y]; });
+
+			// This round's share of the remaining budget
+			unsigned long round_budget = (budget - spent) / (rounds - round);
+			std::vector<std::size_t> chosen;
+			std::vector<unsigned long> target;
+			unsigned long planned = 0;
+			for (std::size_t i : order) {
+				if (score[i] >= 1e300) break;
+				unsigned long next = std::min<unsigned long>(2 * res.inner[i], max_inner);
+				if (planned + (next - res.inner[i]) > round_budget) break;
+				planned += next - res.inner[i];
+				chosen.push_back(i);
+				target.push_back(next);
+			}
+			if (chosen.empty()) break;
+			Extend(chosen, target);
+			spent += planned;
+		}
+
+		res.mean = std::accumulate(res.values.begin(), res.values.end(), 0.0) / static_cast<double>(n_outer);
+		TailMeasures(res.V0, res.values, alpha, res.VaR, res.ES);
+		return res;
+	}
+
+	// Destructor
+	~NestedEngine() {}
+};
+
+#endif // !NESTEDMC_HPP
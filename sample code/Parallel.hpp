@@ -0,0 +1,255 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ==============================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Parallel loop helpers on top of std::thread, a persistent thread pool for
+*	solvers that run many short loops, and the per-block seeds and sums of the path engines
+*
+*/
+
+// Multiple inclusion guards
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <algorithm>
+#include <cmath>
+
+// Number of worker threads to use: the hardware concurrency, or 1 if it is unknown
+inline unsigned ThreadCount() {
+	unsigned n = std::thread::hardware_concurrency();
+	return (n == 0) ? 1 : n;
+}
+
+// Indices of [begin, end) handed out dynamically in chunks through an atomic counter, so uneven tasks balance themselves
+// Each worker calls Work() with its thread_id; the first exception thrown by a task stops the loop and is kept for Rethrow()
+class ChunkQueue {
+private:
+	std::atomic<std::size_t> next;
+	std::size_t end, chunk;
+	std::exception_ptr error;
+	std::mutex error_mutex;
+
+public:
+
+	// Constructor
+	explicit ChunkQueue(std::size_t begin, std::size_t end_, std::size_t chunk_) : next(begin), end(end_), chunk(chunk_) {}
+
+	// Run fn(i, thread_id) on the chunks left
+	template <class Function>
+	inline void Work(Function & fn, unsigned thread_id) {
+		try {
+			for (;;) {
+				std::size_t first = next.fetch_add(chunk);
+				if (first >= end) break;
+				std::size_t last = std::min(first + chunk, end);
+				for (std::size_t i = first; i < last; ++i) fn(i, thread_id);
+			}
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> lock(error_mutex);
+			if (!error) error = std::current_exception();
+			next.store(end);
+		}
+	}
+
+	// Rethrow the first exception of the tasks, if any, once all workers have stopped
+	inline void Rethrow() {
+		if (error) std::rethrow_exception(error);
+	}
+
+	// Destructor
+	~ChunkQueue() {}
+};
+
+// Run fn(i, thread_id) for every i in [begin, end) on a set of worker threads
+// Indices are handed out dynamically in chunks through an atomic counter, so uneven tasks balance themselves.
+// thread_id is in [0, threads) and can be used to index per-thread buffers.
+// The first exception thrown by a task is rethrown in the calling thread once all workers have stopped.
+template <class Function>
+inline void ParallelFor(std::size_t begin, std::size_t end, Function fn, unsigned threads = 0, std::size_t chunk = 1) {
+
+	if (end <= begin) return;
+	if (threads == 0) threads = ThreadCount();
+	if (chunk == 0) chunk = 1;
+
+	// No need for threads in case of a single worker or a single chunk
+	std::size_t chunks = (end - begin + chunk - 1) / chunk;
+	threads = static_cast<unsigned>(std::min<std::size_t>(threads, chunks));
+	if (threads <= 1) {
+		for (std::size_t i = begin; i < end; ++i) fn(i, 0u);
+		return;
+	}
+
+	ChunkQueue queue(begin, end, chunk);
+	std::vector<std::thread> pool;
+	pool.reserve(threads - 1);
+	for (unsigned t = 1; t < threads; ++t) pool.emplace_back([&queue, &fn, t]() { queue.Work(fn, t); });
+	queue.Work(fn, 0);
+	for (auto & th : pool) th.join();
+
+	queue.Rethrow();
+}
+
+// Worker threads started once and reused by every For(), for solvers that run many short parallel loops, where starting
+// threads on each loop costs more than the loop itself. The calling thread takes part as thread 0 and For() returns
+// once every worker is done with the loop, so the pool is not reentrant and is meant to be owned by one solver run.
+class ThreadPool {
+private:
+	std::vector<std::thread> workers;
+	std::function<void(unsigned)> job;	// Loop of the current generation, run once by each worker
+	std::size_t generation = 0;			// Number of loops started
+	unsigned busy = 0;					// Workers still on the current loop
+	bool stop = false;
+	std::mutex mutex;
+	std::condition_variable start, done;
+
+	inline void Worker(unsigned thread_id) {
+		std::size_t seen = 0;
+		for (;;) {
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				start.wait(lock, [&] { return stop || generation != seen; });
+				if (stop) return;
+				seen = generation;
+			}
+			job(thread_id);
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--busy == 0) done.notify_one();
+		}
+	}
+
+public:
+
+	// Constructor: threads in total, including the calling thread; 0 for the hardware concurrency
+	explicit ThreadPool(unsigned threads = 0) {
+		if (threads == 0) threads = ThreadCount();
+		for (unsigned t = 1; t < threads; ++t) workers.emplace_back(&ThreadPool::Worker, this, t);
+	}
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool & operator = (const ThreadPool &) = delete;
+
+	// Number of threads, including the calling thread
+	inline unsigned Size() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+	// Same contract as ParallelFor(), on the threads of the pool
+	template <class Function>
+	inline void For(std::size_t begin, std::size_t end, Function fn, std::size_t chunk = 1) {
+
+		if (end <= begin) return;
+		if (chunk == 0) chunk = 1;
+
+		// No need to wake the workers in case of a single worker or a single chunk
+		if (workers.empty() || end - begin <= chunk) {
+			for (std::size_t i = begin; i < end; ++i) fn(i, 0u);
+			return;
+		}
+
+		ChunkQueue queue(begin, end, chunk);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			job = [&queue, &fn](unsigned thread_id) { queue.Work(fn, thread_id); };
+			busy = static_cast<unsigned>(workers.size());
+			++generation;
+		}
+		start.notify_all();
+		queue.Work(fn, 0);
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			done.wait(lock, [&] { return busy == 0; });
+		}
+
+		queue.Rethrow();
+	}
+
+	// Destructor
+	~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stop = true;
+		}
+		start.notify_all();
+		for (auto & th : workers) th.join();
+	}
+};
+
+// Path engines split the simulations into blocks of a fixed size that run on any thread. Each block draws from its own
+// engine seeded by BlockSeed() and writes its own slots of BlockSums, and the slots are reduced in block order, so the
+// results depend on the seed and the block size only, not on the number of threads nor the scheduling.
+
+// Number of blocks of block_size paths covering NSIM paths
+inline std::size_t BlockCount(unsigned long NSIM, std::size_t block_size) {
+	return static_cast<std::size_t>((NSIM + block_size - 1) / block_size);
+}
+
+// Seed of the random engine of block b, spread over the seed space by the golden ratio increment
+inline unsigned long long BlockSeed(unsigned long long seed, std::size_t b) {
+	return seed + 0x9E3779B97F4A7C15ULL * (b + 1);
+}
+
+// Per block and per strike (or date, or any other output) sums of moments, by default a value and its square
+class BlockSums {
+private:
+	std::size_t nblocks;		// Number of blocks
+	std::size_t outputs;		// Number of outputs per block
+	std::size_t moments;		// Number of sums per output
+	std::vector<double> sums;	// Sums, block-major
+
+public:
+
+	// Constructor
+	explicit BlockSums(std::size_t nblocks_, std::size_t outputs_, std::size_t moments_ = 2)
+		: nblocks(nblocks_), outputs(outputs_), moments(moments_), sums(nblocks_ * outputs_ * moments_, 0.0) {}
+
+	// Sums of block b and output k, written by the block only
+	inline double * Slots(std::size_t b, std::size_t k) {
+		return sums.data() + (b * outputs + k) * moments;
+	}
+
+	// Add a value and its square to the slots of a two-moment output
+	inline static void Add(double * slots, double value) {
+		slots[0] += value;
+		slots[1] += value * value;
+	}
+
+	// Totals of output k over the blocks, added in block order
+	inline std::vector<double> Total(std::size_t k) const {
+		std::vector<double> total(moments, 0.0);
+		for (std::size_t b = 0; b < nblocks; ++b) {
+			const double * s = sums.data() + (b * outputs + k) * moments;
+			for (std::size_t m = 0; m < moments; ++m) total[m] += s[m];
+		}
+		return total;
+	}
+
+	// Discounted mean and standard error of every output of a two-moment table over N paths
+	inline void Estimate(double df, unsigned long N, std::vector<double> & means, std::vector<double> & errors) const {
+		const double n = static_cast<double>(N);
+		means.resize(outputs);
+		errors.resize(outputs);
+		for (std::size_t k = 0; k < outputs; ++k) {
+			std::vector<double> t = Total(k);
+			double mean = t[0] / n;
+			means[k] = df * mean;
+			errors[k] = df * sqrt(std::max(t[1] / n - mean * mean, 0.0) / (n - 1.0));
+		}
+	}
+
+	// Getters
+	inline std::size_t Blocks() const { return nblocks; }
+	inline std::size_t Outputs() const { return outputs; }
+
+	// Destructor
+	~BlockSums() {}
+};
+
+#endif // !PARALLEL_HPP
@@ -0,0 +1,246 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ==============================================================================================================
+*
+*	Monte Carlo Option Pricing Application - PCA path construction over time and assets for quasi-Monte Carlo
+*
+*/
+
+/*   For d correlated Brownian motions observed on n dates, the joint covariance of W_i(t_a) is the Kronecker product
+*        Cov(W_i(t_a), W_j(t_b)) = min(t_a, t_b) C_ij
+*    so its eigenvalues are the products of the eigenvalues of the time covariance min(t_a, t_b) and of the asset
+*    correlation C, and its eigenvectors the products of their eigenvectors. Sorting the n d products in decreasing
+*    order, the r-th input normal drives the r-th largest principal component: the leading dimensions of a low
+*    discrepancy point set carry most of the variance, which is where their uniformity is best.
+*
+*    The Kronecker structure is never formed. For a block of paths the normals are scattered to an n x d matrix Y per
+*    path, scaled by the square roots of the eigenvalues, and the increments are dW = (D V_t) Y V_c^T, where D takes
+*    differences in time: one (count n) x d by d x d product and count n x n by n x d products, O(n d (n + d)) per
+*    path instead of O(n^2 d^2) for the dense joint factor.
+*
+*    The eigendecompositions depend only on the grid and the correlation, so they are built once and shared through
+*    a cache keyed by their contents.
+*/
+
+// Multiple inclusion guards
+#ifndef PATHCONSTRUCTION_HPP
+#define PATHCONSTRUCTION_HPP
+
+#include <vector>
+#include <functional>
+#include <tuple>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include <cmath>
+
+#include "LinearAlgebra.hpp"
+#include "TimeGrid.hpp"
+
+// Alias for a generator of standard normals: fills z (count x dimension, row-major) with the points of the paths
+// first, ..., first + count - 1, so that point sets indexed by path (lattice, Sobol) can be split in blocks
+using NormalBlockGenerator = std::function<void(unsigned long first, std::size_t count, std::size_t dimension, double * z)>;
+
+// Alias for a randomized QMC estimate: mean over the replicates, standard error across them, number of replicates
+using QMCResults = std::tuple<double, double, unsigned>;
+
+// Randomized QMC estimate from independent replicates: estimator(replicate) returns the estimate of one randomization
+template <class Estimator>
+inline QMCResults RandomizedEstimate(unsigned replicates, Estimator estimator) {
+
+	if (replicates < 2) throw std::invalid_argument("Randomized QMC needs at least two replicates");
+
+	double sum = 0.0, sum_sq = 0.0;
+	for (unsigned q = 0; q < replicates; ++q) {
+		double e = estimator(q);
+		sum += e;
+		sum_sq += e * e;
+	}
+
+	double R = static_cast<double>(replicates);
+	double mean = sum / R;
+	double SE = sqrt(std::max(sum_sq / R - mean * mean, 0.0) / (R - 1.0));
+	return std::make_tuple(mean, SE, replicates);
+}
+
+// PCA path construction class
+class PCAPathConstruction {
+private:
+	std::size_t n = 0;						// Number of time steps
+	std::size_t d = 0;						// Number of assets
+	std::vector<double> increment_vectors;	// D V_t, n x n: increments of the time eigenvectors
+	std::vector<double> asset_vectors_T;	// V_c^T, d x d
+	std::vector<std::size_t> position;		// Input dimension r -> position a * d + b in Y
+	std::vector<double> scale;				// Input dimension r -> sqrt(lambda_t(a) lambda_c(b))
+	std::vector<double> cumulative;			// Fraction of the variance in the leading r + 1 dimensions
+
+public:
+
+	// Constructor
+	// correlation is d x d row-major
+	explicit PCAPathConstruction(const TimeGrid & grid, const std::vector<double> & correlation, std::size_t d_) : n(grid.Steps()), d(d_) {
+
+		if (n == 0 || d == 0 || correlation.size() != d * d) throw std::invalid_argument("PCA construction needs a grid and a square correlation");
+
+		// Time covariance min(t_a, t_b) on the grid dates t_1, ..., t_n
+		std::vector<double> time_cov(n * n), time_values, time_vectors;
+		for (std::size_t a = 0; a < n; ++a) {
+			for (std::size_t b = 0; b < n; ++b) time_cov[a * n + b] = grid.Time(std::min(a, b) + 1);
+		}
+		LinearAlgebra::SymmetricEigen(time_cov, n, time_values, time_vectors);
+
+		std::vector<double> asset_values, asset_vectors;
+		LinearAlgebra::SymmetricEigen(correlation, d, asset_values, asset_vectors);
+
+		// Increments in time of the time eigenvectors
+		increment_vectors.resize(n * n);
+		for (std::size_t j = 0; j < n; ++j) {
+			for (std::size_t a = 0; a < n; ++a) {
+				increment_vectors[j * n + a] = time_vectors[j * n + a] - (j > 0 ? time_vectors[(j - 1) * n + a] : 0.0);
+			}
+		}
+
+		asset_vectors_T.resize(d * d);
+		for (std::size_t i = 0; i < d; ++i) {
+			for (std::size_t b = 0; b < d; ++b) asset_vectors_T[b * d + i] = asset_vectors[i * d + b];
+		}
+
+		// Joint eigenvalues in decreasing order
+		std::size_t m = n * d;
+		std::vector<double> joint(m);
+		for (std::size_t a = 0; a < n; ++a) {
+			for (std::size_t b = 0; b < d; ++b) joint[a * d + b] = std::max(time_values[a], 0.0) * std::max(asset_values[b], 0.0);
+		}
+		position.resize(m);
+		std::iota(position.begin(), position.end(), 0);
+		std::stable_sort(position.begin(), position.end(), [&](std::size_t x, std::size_t y) { return joint[x] > joint[y]; });
+
+		scale.resize(m);
+		cumulative.resize(m);
+		double total = std::accumulate(joint.begin(), joint.end(), 0.0), running = 0.0;
+		for (std::size_t r = 0; r < m; ++r) {
+			scale[r] = sqrt(joint[position[r]]);
+			running += joint[position[r]];
+			cumulative[r] = (total > 0.0) ? running / total : 1.0;
+		}
+	}
+
+	// Getters
+	inline std::size_t Steps() const { return n; }
+	inline std::size_t Assets() const { return d; }
+	inline std::size_t Dimension() const { return n * d; }
+
+	// Fraction of the total variance carried by the leading dims input dimensions
+	inline double ExplainedVariance(std::size_t dims) const {
+		return (dims == 0) ? 0.0 : cumulative[std::min(dims, cumulative.size()) - 1];
+	}
+
+	// Build the Brownian increments of a block of count paths
+	// z is count x (n d), the input normals in order of importance; dW is count x (n d), row p holding the n x d
+	// increments of path p (step-major), with Cov(dW_i(t_j), dW_k(t_j)) = C_ik dt_j
+	inline void Build(const double * z, double * dW, std::size_t count) const {
+
+		const std::size_t m = n * d;
+		std::vector<double> Y(count * m, 0.0), YV(count * m, 0.0);
+
+		for (std::size_t p = 0; p < count; ++p) {
+			const double * zp = z + p * m;
+			double * yp = Y.data() + p * m;
+			for (std::size_t r = 0; r < m; ++r) yp[position[r]] = zp[r] * scale[r];
+		}
+
+		// Asset rotation for all the paths at once, then the time rotation path by path
+		LinearAlgebra::Gemm(Y.data(), d, asset_vectors_T.data(), d, YV.data(), d, count * n, d, d);
+
+		std::fill(dW, dW + count * m, 0.0);
+		for (std::size_t p = 0; p < count; ++p) {
+			LinearAlgebra::Gemm(increment_vectors.data(), n, YV.data() + p * m, d, dW + p * m, d, n, d, n);
+		}
+	}
+
+	// Destructor
+	~PCAPathConstruction() {}
+};
+
+// Cache of PCA constructions keyed by the grid and the correlation, shared between pricings
+class PCAConstructionCache {
+private:
+	// A construction with the inputs it was built from, compared on every hit so that a hash collision cannot
+	// return the factors of another problem
+	struct Entry {
+		std::vector<double> times;
+		std::vector<double> correlation;
+		std::size_t d;
+		std::shared_ptr<const PCAPathConstruction> pca;
+
+		inline bool Matches(const TimeGrid & grid, const std::vector<double> & c, std::size_t d_) const {
+			return d == d_ && times == grid.Times() && correlation == c;
+		}
+	};
+
+	mutable std::mutex m;
+	std::unordered_map<std::uint64_t, std::vector<Entry>> constructions;
+	std::size_t count = 0;
+
+	// FNV-1a hashing of the grid dates and the correlation entries
+	inline static std::uint64_t Key(const TimeGrid & grid, const std::vector<double> & correlation, std::size_t d) {
+		std::uint64_t h = 14695981039346656037ULL;
+		auto add = [&h](const void * data, std::size_t size) {
+			const unsigned char * c = static_cast<const unsigned char *>(data);
+			for (std::size_t i = 0; i < size; ++i) {
+				h ^= c[i];
+				h *= 1099511628211ULL;
+			}
+		};
+		add(&d, sizeof(d));
+		add(grid.Times().data(), grid.Times().size() * sizeof(double));
+		add(correlation.data(), correlation.size() * sizeof(double));
+		return h;
+	}
+
+public:
+
+	// Constructor
+	explicit PCAConstructionCache() {}
+
+	// Get the construction for the grid and the correlation, building it only the first time it is requested
+	inline std::shared_ptr<const PCAPathConstruction> Get(const TimeGrid & grid, const std::vector<double> & correlation, std::size_t d) {
+
+		std::uint64_t key = Key(grid, correlation, d);
+		{
+			std::lock_guard<std::mutex> lock(m);
+			auto it = constructions.find(key);
+			if (it != constructions.end()) {
+				for (auto & e : it->second) if (e.Matches(grid, correlation, d)) return e.pca;
+			}
+		}
+
+		// Build outside the lock, the decomposition is O((n + d)^3)
+		std::shared_ptr<const PCAPathConstruction> pca = std::make_shared<const PCAPathConstruction>(grid, correlation, d);
+
+		// Another thread may have built the same construction meanwhile
+		std::lock_guard<std::mutex> lock(m);
+		std::vector<Entry> & bucket = constructions[key];
+		for (auto & e : bucket) if (e.Matches(grid, correlation, d)) return e.pca;
+		bucket.push_back(Entry{ grid.Times(), correlation, d, pca });
+		count++;
+		return pca;
+	}
+
+	// Number of constructions in the cache
+	inline std::size_t Size() const {
+		std::lock_guard<std::mutex> lock(m);
+		return count;
+	}
+
+	// Destructor
+	~PCAConstructionCache() {}
+};
+
+#endif // !PATHCONSTRUCTION_HPP
@@ -0,0 +1,69 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ==============================================================================================================
+*
+*	Monte Carlo Option Pricing Application - One-step conditional expectations for payoff smoothing
+*
+*/
+
+/*   Digital and barrier payoffs are indicators, so the sampled payoff jumps when a path crosses the strike or the
+*    barrier: the variance is high and pathwise Greeks are zero almost everywhere. Over one lognormal step these
+*    indicators have closed-form conditional expectations:
+*
+*    - the last step of a European or digital payoff is replaced by its Black-Scholes value over that step
+*    - the survival indicator of a barrier over a step is replaced by the Brownian bridge probability of not crossing
+*          P(no crossing | S_i, S_(i+1)) = 1 - exp(-2 ln(B / S_i) ln(B / S_(i+1)) / (vol^2 dt))
+*
+*    The estimators become smooth functions of the path, at the cost of a few exp/log per step.
+*/
+
+// Multiple inclusion guards
+#ifndef PAYOFFSMOOTHING_HPP
+#define PAYOFFSMOOTHING_HPP
+
+#include <algorithm>
+#include <cmath>
+
+#include "BlackScholes.hpp"
+
+// Payoff smoothing class with static conditional expectations
+class PayoffSmoothing {
+public:
+
+	// Barrier caps of the payoffs: a side without a barrier has the cap NoBarrier, any positive cap is a barrier level
+	static constexpr double NoBarrier = 0.0;
+	inline static bool HasBarrier(double cap) { return cap > NoBarrier; }
+
+	// Expected vanilla payoff at the end of a step of length dt, starting from S, undiscounted
+	inline static double Vanilla(bool call, double S, double K, double dt, double growth, double vol) {
+		return BlackScholes::Black(call, S * exp(growth * dt), K, dt, 1.0, vol);
+	}
+
+	// Probability of finishing in the money at the end of a step of length dt, starting from S (cash-or-nothing digital)
+	inline static double Digital(bool call, double S, double K, double dt, double growth, double vol) {
+
+		double sd = vol * sqrt(dt);
+		double F = S * exp(growth * dt);
+		if (sd < 1e-12) return call ? double(F > K) : double(F < K);
+
+		double d2 = (log(F / K) - 0.5 * sd * sd) / sd;
+		return BlackScholes::N(call ? d2 : -d2);
+	}
+
+	// Probability that a step from S0 to S1 of length dt stays strictly below the up barrier B
+	// A non-positive end point, which Euler steps can produce, is outside the lognormal bridge and counts as knocked out
+	inline static double SurvivalUp(double S0, double S1, double B, double dt, double vol) {
+		if (S0 <= 0.0 || S1 <= 0.0 || S0 >= B || S1 >= B) return 0.0;
+		return 1.0 - exp(-2.0 * log(B / S0) * log(B / S1) / (vol * vol * dt));
+	}
+
+	// Probability that a step from S0 to S1 of length dt stays strictly above the down barrier B
+	inline static double SurvivalDown(double S0, double S1, double B, double dt, double vol) {
+		if (S0 <= 0.0 || S1 <= 0.0 || S0 <= B || S1 <= B) return 0.0;
+		return 1.0 - exp(-2.0 * log(S0 / B) * log(S1 / B) / (vol * vol * dt));
+	}
+};
+
+#endif // !PAYOFFSMOOTHING_HPP
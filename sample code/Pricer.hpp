@@ -16,10 +16,16 @@
 #include <vector>
 #include <string>
 #include <tuple>
+#include <stdexcept>
 
 #include "Payoff.hpp"
 #include "FDM_SDE.hpp"
 #include "RNG.hpp"
+#include "DiscountCurve.hpp"
+#include "TimeGrid.hpp"
+#include "Dividends.hpp"
+#include "PayoffSmoothing.hpp"
+#include "SABR.hpp"
 
 // Alias for Option Data tuple
 // i.e Volatility, Rate, Time, Stock, Strike, NSIM, NT (optional)
@@ -36,6 +42,9 @@ using PricerResults = std::tuple< double,			// Option price
 				  double,			// In case of barrier option: upper cap
 				  double >;			// In case of barrier option: lower cap
 								   									  																	
+// Alias for the knock-out / knock-in / vanilla triple of BarrierParityPricer: the three prices, then their standard errors
+using BarrierParityResults = std::tuple<double, double, double, double, double, double>;
+
 // Alias for a tuple that holds all the model information
 using ModelParameterTuple = std::tuple<RNGFunctionType, int, PayoffFunctionType>;
 
@@ -59,11 +68,59 @@ private:
 
 	// Optionally
 	bool explicit_euler = false;	// Indicator in case of Explicit Euler approach
+	std::shared_ptr<const DiscountCurve> discount_curve;	// Term structure of rates, otherwise the scalar rate is used
+	SABRParameters sabr = { 0.0, 1.0, 0.0, 0.0 };			// SABR beta, rho, nu; alpha is the volatility of OptionData
+	ObservationSchedule observation_schedule;	// Dates the payoff looks at, empty for the uniform grid
+	double monitoring_dt = 0;					// Largest step between barrier checks, 0 if the payoff has no barrier
+	DividendSchedule dividends;					// Continuous yield and discrete dividends, none by default
 	
 	// Output
 	std::vector<double> stock_flunct;	// To hold the stock flunctuations
 	std::vector<double>	option_prices;	// To hold the option prices in each simulation
 	double m_price;						// To hold the option price
+
+	// Simulation time grid: the uniform dt = T / NSteps grid, unless the payoff declared an observation schedule
+	// With a schedule, GBM steps exactly from one date to the next and the FDM schemes are refined to at most T / NSteps
+	// Ex-dividend dates are always added to the grid, so that the stock can jump on them
+	// For GBM without schedule or dividends the grid is empty (single step to expiry), unless single_step_grid is set
+	inline TimeGrid BuildTimeGrid(double T, int fdm_model_choice, bool single_step_grid = false) const {
+
+		if (!observation_schedule.empty() || dividends.HasDiscrete() || (single_step_grid && fdm_model_choice == 1)) {
+			ObservationSchedule schedule = observation_schedule;
+			double max_dt = monitoring_dt;
+			if (fdm_model_choice != 1) {
+				if (schedule.empty()) schedule = TimeGrid::Periodic(T, NSteps);
+				max_dt = (max_dt > 0) ? std::min(max_dt, T / NSteps) : T / NSteps;
+			}
+			return TimeGrid::FromSchedule(T, schedule, max_dt, dividends.ExDates(T));
+		}
+		if (fdm_model_choice != 1) {
+			return TimeGrid::Uniform(T, NSteps);
+		}
+		return TimeGrid();
+	}
+
+	// Dividend jump on each date of the grid: S -> S * jump_factor - jump_cash
+	inline void DividendJumps(const TimeGrid & grid, std::vector<double> & jump_factor, std::vector<double> & jump_cash, std::vector<char> & jump) const {
+		jump_factor.assign(grid.Steps() + 1, 1.0);
+		jump_cash.assign(grid.Steps() + 1, 0.0);
+		jump.assign(grid.Steps() + 1, 0);
+		for (std::size_t j = 1; j <= grid.Steps(); j++) {
+			jump[j] = dividends.Jump(grid.Time(j), jump_factor[j], jump_cash[j]);
+		}
+	}
+
+	// Growth rate of the stock on each step of the grid, net of the continuous dividend yield
+	// With a discount curve the stock drifts at the forward rate of the curve over the step, so that the paths and the
+	// discount factor use the same rates; otherwise at the scalar rate
+	inline std::vector<double> StepGrowth(const TimeGrid & grid, double r) const {
+		std::vector<double> growth(grid.Steps());
+		for (std::size_t j = 0; j < grid.Steps(); j++) {
+			double rate = discount_curve ? discount_curve->Forward(grid.Time(j), grid.Time(j + 1)) : r;
+			growth[j] = rate - dividends.Yield();
+		}
+		return growth;
+	}
 public:
 
 	// Constructors
@@ -85,6 +142,35 @@ public:
 	void setOptData(const OptionData & optd);
 	void setNSteps(const unsigned long steps);
 
+	// Observation schedule declared by the payoff, i.e. TimeGrid::Periodic(T, 12) for a monthly Asian
+	// The simulation then steps only between these dates, refined to monitoring_dt_ for barriers and to T / NSteps for the FDM schemes
+	inline void setObservationSchedule(const ObservationSchedule & schedule, double monitoring_dt_ = 0) {
+		observation_schedule = schedule;
+		monitoring_dt = monitoring_dt_;
+	}
+	inline const ObservationSchedule & getObservationSchedule() const { return observation_schedule; }
+	inline double getMonitoringDt() const { return monitoring_dt; }
+
+	// Dividends of the underlying: the ex-dates are added to the time grid and the stock jumps on them
+	inline void setDividends(const DividendSchedule & dividends_) {
+		dividends = dividends_;
+	}
+	inline const DividendSchedule & getDividends() const { return dividends; }
+
+	// Discount with a term structure instead of the scalar rate of OptionData
+	// The stock then drifts at the forward rates of the curve
+	inline void setDiscountCurve(const std::shared_ptr<const DiscountCurve> & curve) {
+		discount_curve = curve;
+	}
+	inline const std::shared_ptr<const DiscountCurve> & getDiscountCurve() const { return discount_curve; }
+
+	// SABR parameters for the SABR scheme; the alpha is taken from the volatility of OptionData
+	inline void setSABR(const SABRParameters & sabr_) {
+		SABREngine::Validate(sabr_, false);
+		sabr = sabr_;
+	}
+	inline const SABRParameters & getSABR() const { return sabr; }
+
 	// Getters
 	const std::vector<std::string>	getParameterNames()		const;
 	const ModelParameterTuple		getModelParameters()	const;
@@ -156,12 +242,25 @@ public:
 		bool asian = false;
 		std::regex reg("(Asian)(.*)");
 		if (std::regex_match(parameter_names[2], reg)) {
-			bool asian = true;
+			asian = true;
 		}
 		
+		// Discount factor to expiry: a table read when a discount curve is set
+		double discount = discount_curve ? discount_curve->Discount(T) : exp(-r * T);
+
+		// Simulation time grid and dividend jumps on its dates
+		TimeGrid grid = BuildTimeGrid(T, fdm_model_choice);
+		std::vector<double> jump_factor, jump_cash;
+		std::vector<char> jump;
+		DividendJumps(grid, jump_factor, jump_cash, jump);
+
+		// Growth rate of the stock, net of the continuous dividend yield: the zero rate to expiry for a single step,
+		// the forward rate of each step on a grid
+		double growth = -log(discount) / T - dividends.Yield();
+		std::vector<double> step_growth = StepGrowth(grid, r);
+
 		// For time sub-intervals and the Weiner process
-		double dt = T / static_cast<double>(NSteps);
-		double dt_sq = sqrt(dt);
+		double dt, dt_sq;
 		
 		// Normal Random generation
 		std::normal_distribution<double> n(0, 1);
@@ -176,8 +275,58 @@ public:
 
 			case 1:	
 			{	// General Geometric Brownian Motion
+
+				// In case of an observation schedule, step exactly from one date to the next
+				if (grid.Steps() > 0) {
+
+					// Per-step drift factors and volatilities of the exact transition
+					std::vector<double> drift_factor(grid.Steps()), vol_step(grid.Steps());
+					for (std::size_t j = 0; j < grid.Steps(); j++) {
+						dt = grid.Dt(j);
+						double unit = 1.0;
+						drift_factor[j] = ISDE::GBM(unit, dt, vol, step_growth[j]);
+						vol_step[j] = vol * grid.SqrtDt(j);
+					}
+
+					// Simulation begins
+					for (unsigned i = 0; i < NSIM; i++) {
+
+						VOld = S;
+						average_price = 0;
+
+						for (std::size_t j = 0; j < grid.Steps(); j++) {
+							VOld *= drift_factor[j] * exp(vol_step[j] * n(eng));
+							if (jump[j + 1]) DividendSchedule::ApplyJump(jump_factor[j + 1], jump_cash[j + 1], &VOld, 1);
+							if (asian && grid.IsObservation(j + 1)) average_price += VOld;
+						}
+						VNew = VOld;
+
+						// Store the stock flunctuation
+						stock_flunct.push_back(VNew);
+
+						if ((i / 10000) * 10000 == i) {
+							// Give status after each 1000th iteration
+							std::cout << i << std::endl;
+						}
+
+						// Update the payoff sum
+						double tmp = 0;
+						if (asian) tmp = option_payoff(K, average_price / grid.Observations());
+						else tmp = option_payoff(K, VNew);
+
+						// Get the current option price
+						option_prices.push_back(tmp);
+
+						// Update the payoff sum
+						price += tmp / static_cast<double>(NSIM);
+					}
+					// Get the average discounted price of the simulation
+					m_price = price * discount;
+					break;
+				}
+
 				// Stock update given GBM
-				VOld = ISDE::GBM(S, T, vol, r);
+				VOld = ISDE::GBM(S, T, vol, growth);
 
 				// Simulation begins 
 				for (unsigned i = 0; i < NSIM; i++) {
@@ -205,7 +354,7 @@ public:
 					price += tmp / static_cast<double>(NSIM);
 				}
 				// Get the average discounted price of the simulation
-				m_price = price * exp(-r*T);
+				m_price = price * discount;
 				break;
 			}
 			case 2: 
@@ -217,6 +366,7 @@ public:
 
 					// Update to the initial stock price
 					VOld = S;
+					average_price = 0;
 
 					if ((i / 10000) * 10000 == i) {
 						// Give status after each 1000th iteration
@@ -224,18 +374,21 @@ public:
 						std::cout << i << std::endl;
 					}
 
-					// Discretize the time into N steps
-					for (unsigned j = 0; j <= NSteps; j++) {
+					// Discretize the time into the steps of the grid
+					for (std::size_t j = 0; j < grid.Steps(); j++) {
 
+						dt = grid.Dt(j);
+						dt_sq = grid.SqrtDt(j);
 						Normal = n(eng);
 
 						// Update in every step according to the Euler method
-						VNew = VOld + dt * ISDE::drift(r, VOld) + (dt_sq * ISDE::diffusion(vol, VOld) * Normal);
+						VNew = VOld + dt * ISDE::drift(step_growth[j], VOld) + (dt_sq * ISDE::diffusion(vol, VOld) * Normal);
+						if (jump[j + 1]) DividendSchedule::ApplyJump(jump_factor[j + 1], jump_cash[j + 1], &VNew, 1);
 
 						// Update the price
 						VOld = VNew;
 
-						if (asian) average_price += VNew;
+						if (asian && grid.IsObservation(j + 1)) average_price += VNew;
 					}
 
 					// Store the update into the stock flunctuation vector
@@ -244,7 +397,7 @@ public:
 					// Update the payoff sum
 					// Use a temporary variable tmp to avoid multiple function calls of payoff()
 					double tmp = 0;
-					if (asian) tmp = option_payoff(K, average_price/NSteps);
+					if (asian) tmp = option_payoff(K, average_price / grid.Observations());
 					else tmp = option_payoff(K, VNew);
 
 					// Get the current option price
@@ -255,7 +408,7 @@ public:
 				}
 
 				// Discount and average the price
-				m_price = (price / static_cast<double>(NSIM)) * exp(-r * T);
+				m_price = (price / static_cast<double>(NSIM)) * discount;
 				break;
 			}
 			case 3:	
@@ -269,6 +422,7 @@ public:
 
 					// Update to the initial stock price
 					VOld = S;
+					average_price = 0;
 
 					if ((i / 10000) * 10000 == i) {
 						// Give status after each 1000th iteration
@@ -276,19 +430,22 @@ public:
 						std::cout << i << std::endl;
 					}
 
-					// Discretize the time into N steps
-					for (unsigned j = 0; j <= NSteps; j++) {
+					// Discretize the time into the steps of the grid
+					for (std::size_t j = 0; j < grid.Steps(); j++) {
 
+						dt = grid.Dt(j);
+						dt_sq = grid.SqrtDt(j);
 						Normal = n(eng);
 
 						// Update in every step according to the Milstein method
-						VNew = VOld + (dt * ISDE::drift(r, VOld)) + (dt_sq * ISDE::diffusion(vol, VOld) * Normal)
+						VNew = VOld + (dt * ISDE::drift(step_growth[j], VOld)) + (dt_sq * ISDE::diffusion(vol, VOld) * Normal)
 							+ 0.5 * ISDE::diffusion(vol, VOld) * ISDE::diffusion_derivative(vol, VOld) * (pow(dt_sq * Normal, 2) - dt);
+						if (jump[j + 1]) DividendSchedule::ApplyJump(jump_factor[j + 1], jump_cash[j + 1], &VNew, 1);
 
 						// Update the price
 						VOld = VNew;
 					
-						if (asian) average_price += VNew;
+						if (asian && grid.IsObservation(j + 1)) average_price += VNew;
 					}
 
 					// Store the update into the stock flunctuation vector
@@ -296,7 +453,7 @@ public:
 
 					// Update the payoff sum
 					double tmp = 0;
-					if (asian) tmp = option_payoff(K, average_price / NSteps);
+					if (asian) tmp = option_payoff(K, average_price / grid.Observations());
 					else tmp = option_payoff(K, VNew);
 
 					// Get the current option price
@@ -307,7 +464,79 @@ public:
 				}
 
 				// Discount and average the price
-				m_price = (price / static_cast<double>(NSIM))* exp(-r * T);
+				m_price = (price / static_cast<double>(NSIM)) * discount;
+				break;
+			}
+			case 4:
+			{	// SABR model on the forward to expiry
+
+				// Indicator that we are using a model with time discretization
+				explicit_euler = true;
+
+				// The forward to expiry is a martingale, the spot at t is F_t P(t, T) / exp(-q (T - t))
+				// Discrete dividends enter the forward through the escrowed spot; the spot at an intermediate date would
+				// need the dividends still to come, so Asian payoffs with discrete dividends are not supported
+				if (asian && dividends.HasDiscrete()) {
+					throw std::invalid_argument("The SABR scheme does not price Asian payoffs with discrete dividends");
+				}
+				double S0 = dividends.HasDiscrete()
+					? dividends.EscrowedSpot(S, T, [&](double t) { return discount_curve ? discount_curve->Discount(t) : exp(-r * t); })
+					: S;
+				double F0 = S0 * exp(-dividends.Yield() * T) / discount;
+				auto SpotFromForward = [&](double F, double t) {
+					double df_t = discount_curve ? discount_curve->Discount(t) : exp(-r * t);
+					return F * discount / df_t * exp(dividends.Yield() * (T - t));
+				};
+
+				// Simulation begins
+				for (unsigned i = 1; i <= NSIM; ++i) {
+
+					// Update to the initial forward and volatility
+					VOld = F0;
+					double alpha = vol;
+					average_price = 0;
+
+					if ((i / 10000) * 10000 == i) {
+						// Give status after each 1000th iteration
+
+						std::cout << i << std::endl;
+					}
+
+					// Discretize the time into the steps of the grid
+					for (std::size_t j = 0; j < grid.Steps(); j++) {
+
+						dt = grid.Dt(j);
+						Normal = n(eng);
+						double NormalOrth = n(eng);
+
+						// Exact volatility step, then the conditional log step of the forward
+						double alpha_next = ISDE::SABRVolatility(alpha, sabr.nu, dt, Normal);
+						VNew = ISDE::SABRForward(VOld, alpha, alpha_next, sabr.beta, sabr.rho, sabr.nu, dt, Normal, NormalOrth);
+
+						// Update the forward and the volatility
+						VOld = VNew;
+						alpha = alpha_next;
+
+						if (asian && grid.IsObservation(j + 1)) average_price += SpotFromForward(VNew, grid.Time(j + 1));
+					}
+
+					// At expiry the forward is the spot
+					stock_flunct.push_back(VNew);
+
+					// Update the payoff sum
+					double tmp = 0;
+					if (asian) tmp = option_payoff(K, average_price / grid.Observations());
+					else tmp = option_payoff(K, VNew);
+
+					// Get the current option price
+					option_prices.push_back(tmp);
+
+					// Update the average payoff sum
+					price += tmp;
+				}
+
+				// Discount and average the price
+				m_price = (price / static_cast<double>(NSIM)) * discount;
 				break;
 			}
 			default:
@@ -321,6 +550,299 @@ public:
 		return m_price;
 	}
 
+	// SmoothedPricer() pricing algorithm
+	// Same dynamics as GeneralPricer(), but the discontinuous parts of the payoff are replaced by their one-step conditional expectations:
+	// - Knock-out/Knock-in: the survival indicator is replaced by the product of the Brownian bridge survival probabilities of the steps;
+	//   with an observation schedule the barrier is checked on the observation dates only, as in BarrierParityPricer()
+	// - European and digital: the last step is not sampled, the payoff is its closed form over that step
+	// Asian payoffs have nothing to smooth and are priced as in GeneralPricer()
+	inline double SmoothedPricer() {
+
+		// Get the option data values
+		double vol			= std::get<0>(option_data);		// Volatility
+		double r			= std::get<1>(option_data);		// Rate
+		double T			= std::get<2>(option_data);		// Expiry
+		double S			= std::get<3>(option_data);		// Stock price
+		double K			= std::get<4>(option_data);		// Strike price
+		unsigned long NSIM	= std::get<5>(option_data);		// Number of simulations
+
+		// Get the model function wrapper Payoff and FDM
+		int fdm_model_choice	= std::get<1>(model_parameters);
+		auto option_payoff		= std::get<2>(model_parameters);
+
+		if (fdm_model_choice < 1 || fdm_model_choice > 3) {
+			std::cout << "Error: No Deterministic Request for Pricing\n";
+			m_price = 0;
+			return m_price;
+		}
+		explicit_euler = (fdm_model_choice != 1);
+
+		// Discriminate the payoff by its name
+		bool call		= std::regex_match(parameter_names[2], std::regex("(.*)(Call)(.*)"));
+		bool asian		= std::regex_match(parameter_names[2], std::regex("(Asian)(.*)"));
+		bool digital	= std::regex_match(parameter_names[2], std::regex("(.*)(Digital)(.*)"));
+		bool knock_out	= std::regex_match(parameter_names[2], std::regex("(.*)([Kk]nock-?[Oo]ut)(.*)"));
+		bool knock_in	= std::regex_match(parameter_names[2], std::regex("(.*)([Kk]nock-?[Ii]n)(.*)"));
+
+		// Barrier levels from the payoff caps
+		double upper = IPayoff::GetUpperCap();
+		double lower = IPayoff::GetLowerCap();
+		bool has_upper = (knock_out || knock_in) && PayoffSmoothing::HasBarrier(upper);
+		bool has_lower = (knock_out || knock_in) && PayoffSmoothing::HasBarrier(lower);
+		bool barrier = has_upper || has_lower;
+		bool discrete = !observation_schedule.empty();
+
+		double discount = discount_curve ? discount_curve->Discount(T) : exp(-r * T);
+
+		// Always step on a grid, even a single step to expiry for GBM: with the bridge probabilities a single exact
+		// GBM step already prices a continuously monitored barrier
+		TimeGrid grid = BuildTimeGrid(T, fdm_model_choice, true);
+		std::vector<double> jump_factor, jump_cash;
+		std::vector<char> jump;
+		DividendJumps(grid, jump_factor, jump_cash, jump);
+		std::vector<double> growth = StepGrowth(grid, r);
+
+		// Digital payout, read from the payoff just in the money
+		double payout = digital ? option_payoff(K, call ? K * (1.0 + 1e-8) : K * (1.0 - 1e-8)) : 0.0;
+
+		// The last step is integrated analytically for European and digital payoffs, unless the stock jumps at expiry
+		std::size_t steps = grid.Steps();
+		bool smooth_last = !barrier && !asian && !jump[steps];
+		std::size_t sampled = smooth_last ? steps - 1 : steps;
+
+		std::normal_distribution<double> n(0, 1);
+		std::default_random_engine eng;
+
+		double price = 0;
+
+		// Simulation begins
+		for (unsigned i = 0; i < NSIM; i++) {
+
+			double V = S, average_price = 0, survival = 1.0;
+
+			for (std::size_t j = 0; j < sampled; j++) {
+
+				double dt = grid.Dt(j);
+				double dt_sq = grid.SqrtDt(j);
+				double Normal = n(eng);
+				double VPrev = V;
+
+				// Step according to the selected scheme
+				switch (fdm_model_choice) {
+				case 1:
+					V *= exp((growth[j] - 0.5 * vol * vol) * dt + vol * dt_sq * Normal);
+					break;
+				case 2:
+					V = V + dt * ISDE::drift(growth[j], V) + (dt_sq * ISDE::diffusion(vol, V) * Normal);
+					break;
+				default:
+					V = V + (dt * ISDE::drift(growth[j], V)) + (dt_sq * ISDE::diffusion(vol, V) * Normal)
+						+ 0.5 * ISDE::diffusion(vol, V) * ISDE::diffusion_derivative(vol, V) * (pow(dt_sq * Normal, 2) - dt);
+					break;
+				}
+
+				// Survival over the step instead of checking the barrier at the grid dates only
+				if (has_upper && !discrete) survival *= PayoffSmoothing::SurvivalUp(VPrev, V, upper, dt, vol);
+				if (has_lower && !discrete) survival *= PayoffSmoothing::SurvivalDown(VPrev, V, lower, dt, vol);
+
+				if (jump[j + 1]) DividendSchedule::ApplyJump(jump_factor[j + 1], jump_cash[j + 1], &V, 1);
+				if (asian && grid.IsObservation(j + 1)) average_price += V;
+
+				// A discretely monitored barrier is only checked on the observation dates, there is nothing to smooth
+				if (discrete && grid.IsObservation(j + 1) && ((has_upper && V >= upper) || (has_lower && V <= lower))) survival = 0.0;
+			}
+
+			// Store the stock flunctuation (the stock one step before expiry when the last step is smoothed)
+			stock_flunct.push_back(V);
+
+			double tmp = 0;
+			if (smooth_last) {
+				double dt = grid.Dt(steps - 1);
+				tmp = digital ? payout * PayoffSmoothing::Digital(call, V, K, dt, growth[steps - 1], vol)
+					: PayoffSmoothing::Vanilla(call, V, K, dt, growth[steps - 1], vol);
+			}
+			else if (barrier) {
+				double vanilla = call ? std::max(V - K, 0.0) : std::max(K - V, 0.0);
+				tmp = knock_in ? (1.0 - survival) * vanilla : survival * vanilla;
+			}
+			else if (asian) {
+				tmp = option_payoff(K, average_price / grid.Observations());
+			}
+			else {
+				tmp = option_payoff(K, V);
+			}
+
+			// Get the current option price
+			option_prices.push_back(tmp);
+
+			// Update the payoff sum
+			price += tmp;
+		}
+
+		// Discount and average the price
+		m_price = (price / static_cast<double>(NSIM)) * discount;
+		return m_price;
+	}
+
+	// BarrierParityPricer() pricing algorithm
+	// Prices the knock-out, the knock-in and the vanilla of the same strike and barrier from one set of paths, with the
+	// knock-in taken by in-out parity as vanilla - knock-out on each path, so that the three prices are consistent
+	// - with an observation schedule the barrier is checked on the observation dates only, otherwise it is monitored
+	//   continuously with the Brownian bridge survival probabilities of the steps, as in SmoothedPricer()
+	// - for a discretely monitored single barrier with exact GBM stepping, the continuously monitored knock-out of the same
+	//   path is a control variate whose mean is the Reiner-Rubinstein price; it controls all three prices, so parity holds
+	// - a continuously monitored barrier has no control: the knock-out would be its own control, with a zero error
+	// The option price and the path payoffs kept for MIS are those of the payoff named in parameter_names[2], controlled
+	// path by path when the control variate is used, so that the MIS statistics agree with the price
+	inline BarrierParityResults BarrierParityPricer(bool control_variate = true) {
+
+		// Get the option data values
+		double vol			= std::get<0>(option_data);		// Volatility
+		double r			= std::get<1>(option_data);		// Rate
+		double T			= std::get<2>(option_data);		// Expiry
+		double S			= std::get<3>(option_data);		// Stock price
+		double K			= std::get<4>(option_data);		// Strike price
+		unsigned long NSIM	= std::get<5>(option_data);		// Number of simulations
+
+		int fdm_model_choice = std::get<1>(model_parameters);
+		if (fdm_model_choice < 1 || fdm_model_choice > 3) {
+			throw std::invalid_argument("Barrier parity pricing needs GBM, Euler or Milstein dynamics");
+		}
+		explicit_euler = (fdm_model_choice != 1);
+
+		// Discriminate the payoff by its name
+		bool call		= std::regex_match(parameter_names[2], std::regex("(.*)(Call)(.*)"));
+		bool knock_in	= std::regex_match(parameter_names[2], std::regex("(.*)([Kk]nock-?[Ii]n)(.*)"));
+
+		// Barrier levels from the payoff caps
+		double upper = IPayoff::GetUpperCap();
+		double lower = IPayoff::GetLowerCap();
+		bool has_upper = PayoffSmoothing::HasBarrier(upper);
+		bool has_lower = PayoffSmoothing::HasBarrier(lower);
+		if (!has_upper && !has_lower) throw std::invalid_argument("Barrier parity pricing needs an upper or a lower barrier");
+
+		double discount = discount_curve ? discount_curve->Discount(T) : exp(-r * T);
+		double q = dividends.Yield();
+
+		TimeGrid grid = BuildTimeGrid(T, fdm_model_choice, true);
+		std::vector<double> jump_factor, jump_cash;
+		std::vector<char> jump;
+		DividendJumps(grid, jump_factor, jump_cash, jump);
+		std::vector<double> growth = StepGrowth(grid, r);
+		bool discrete = !observation_schedule.empty();
+
+		// The closed form holds for exact GBM steps of a single barrier at a constant rate without discrete dividends
+		// Undiscounted mean of the control, at the growth rate the paths are simulated with
+		bool cv = control_variate && discrete && fdm_model_choice == 1 && has_upper != has_lower && !dividends.HasDiscrete() && !discount_curve;
+		double mean_out = 0;
+		if (cv) {
+			mean_out = exp(r * T) * BlackScholes::Barrier(call, has_upper, false, S, K, has_upper ? upper : lower, T, r, q, vol);
+		}
+
+		std::normal_distribution<double> n(0, 1);
+		std::default_random_engine eng;
+
+		// Sums of the knock-out Y, the vanilla X and the control W, with their squares and cross products
+		double sY = 0, sX = 0, sW = 0, sYY = 0, sXX = 0, sWW = 0, sXY = 0, sYW = 0, sXW = 0;
+
+		// Payoff of each path and its control, adjusted for MIS once the regression coefficient is known
+		std::vector<double> payoffs, controls;
+		payoffs.reserve(NSIM);
+		if (cv) controls.reserve(NSIM);
+
+		// Simulation begins
+		for (unsigned i = 0; i < NSIM; i++) {
+
+			double V = S, survival = 1.0, bridge = 1.0;
+
+			for (std::size_t j = 0; j < grid.Steps(); j++) {
+
+				double dt = grid.Dt(j);
+				double dt_sq = grid.SqrtDt(j);
+				double Normal = n(eng);
+				double VPrev = V;
+
+				// Step according to the selected scheme
+				switch (fdm_model_choice) {
+				case 1:
+					V *= exp((growth[j] - 0.5 * vol * vol) * dt + vol * dt_sq * Normal);
+					break;
+				case 2:
+					V = V + dt * ISDE::drift(growth[j], V) + (dt_sq * ISDE::diffusion(vol, V) * Normal);
+					break;
+				default:
+					V = V + (dt * ISDE::drift(growth[j], V)) + (dt_sq * ISDE::diffusion(vol, V) * Normal)
+						+ 0.5 * ISDE::diffusion(vol, V) * ISDE::diffusion_derivative(vol, V) * (pow(dt_sq * Normal, 2) - dt);
+					break;
+				}
+
+				// Continuous monitoring with the bridge, which is also the control
+				if (has_upper) bridge *= PayoffSmoothing::SurvivalUp(VPrev, V, upper, dt, vol);
+				if (has_lower) bridge *= PayoffSmoothing::SurvivalDown(VPrev, V, lower, dt, vol);
+
+				if (jump[j + 1]) DividendSchedule::ApplyJump(jump_factor[j + 1], jump_cash[j + 1], &V, 1);
+
+				// Discrete monitoring on the observation dates
+				if (discrete && grid.IsObservation(j + 1) && ((has_upper && V >= upper) || (has_lower && V <= lower))) survival = 0.0;
+			}
+			if (!discrete) survival = bridge;
+
+			double X = call ? std::max(V - K, 0.0) : std::max(K - V, 0.0);
+			double Y = survival * X;
+			double W = bridge * X;
+
+			stock_flunct.push_back(V);
+			payoffs.push_back(knock_in ? X - Y : Y);
+			if (cv) controls.push_back(W);
+
+			sY += Y; sX += X; sW += W;
+			sYY += Y * Y; sXX += X * X; sWW += W * W;
+			sXY += X * Y; sYW += Y * W; sXW += X * W;
+		}
+
+		// Mean and standard error of a combination u of Y, X, W, optionally controlled by the combination w with known mean
+		const double N = static_cast<double>(NSIM);
+		const double mean[3] = { sY / N, sX / N, sW / N };
+		const double second[3][3] = { { sYY, sXY, sYW }, { sXY, sXX, sXW }, { sYW, sXW, sWW } };
+		auto Covariance = [&](const double * u, const double * v) {
+			double c = 0;
+			for (int a = 0; a < 3; a++) for (int b = 0; b < 3; b++) c += u[a] * v[b] * (second[a][b] / N - mean[a] * mean[b]);
+			return c;
+		};
+		const double control[3] = { 0, 0, 1 };
+		auto Estimate = [&](const double * u, double & price, double & se, double & beta) {
+			double m = u[0] * mean[0] + u[1] * mean[1] + u[2] * mean[2];
+			double var = Covariance(u, u);
+			beta = 0.0;
+			if (cv) {
+				double ww = Covariance(control, control);
+				beta = (ww > 1e-300) ? Covariance(u, control) / ww : 0.0;
+				m -= beta * (mean[2] - mean_out);
+				var -= beta * Covariance(u, control);
+			}
+			price = discount * m;
+			se = discount * sqrt(std::max(var, 0.0) / (N - 1.0));
+		};
+
+		// Knock-out = Y, vanilla = X and knock-in = X - Y, each with its own regression on the same control
+		// The estimates are linear in the payoff, so the knock-in is vanilla - knock-out and in-out parity holds exactly
+		const double out[3] = { 1, 0, 0 }, vanilla[3] = { 0, 1, 0 }, in[3] = { -1, 1, 0 };
+		double p_out, p_in, p_vanilla, se_out, se_in, se_vanilla, beta_out, beta_in, beta_vanilla;
+		Estimate(out, p_out, se_out, beta_out);
+		Estimate(vanilla, p_vanilla, se_vanilla, beta_vanilla);
+		Estimate(in, p_in, se_in, beta_in);
+		p_in = p_vanilla - p_out;
+
+		// Path payoffs for MIS, with the control applied path by path
+		double beta = knock_in ? beta_in : beta_out;
+		for (std::size_t i = 0; i < payoffs.size(); i++) {
+			option_prices.push_back(cv ? payoffs[i] - beta * (controls[i] - mean_out) : payoffs[i]);
+		}
+
+		m_price = knock_in ? p_in : p_out;
+		return std::make_tuple(p_out, p_in, p_vanilla, se_out, se_in, se_vanilla);
+	}
+
 	// Inline setter for Payoff parameters
 	// Will be used in the Builder class in case of multi-pricing so that the user can update the options parameters to be prices
 	// in real time
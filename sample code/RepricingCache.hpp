@@ -0,0 +1,302 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ===================================================================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Incremental repricing cache with input fingerprints and dirty tracking
+*
+*/
+
+/*   Between two runs of the same book only a few of the option inputs change. The cache keeps the results of the
+*    previous run together with a fingerprint of the inputs that produced them. Before pricing an option the Builder
+*    asks the cache if the option is dirty, i.e. its contract terms, its market data or its model changed, and only
+*    then it runs the simulation. Clean options carry their previous result forward, and only the delta is printed.
+*/
+
+// Multiple inclusion guards
+#ifndef REPRICINGCACHE_HPP
+#define REPRICINGCACHE_HPP
+
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <cstdint>
+#include <cstring>
+
+#include "Pricer.hpp"
+#include "MIS.hpp"
+
+// Alias for the input fingerprint of an option: hash of contract terms, hash of market data, hash of model choice
+using InputFingerprint	= std::tuple<std::uint64_t, std::uint64_t, std::uint64_t>;
+
+// Alias for a cached pricing result: the fingerprint of its inputs, the Pricer output and the MIS statistics
+using CachedResult		= std::tuple<InputFingerprint, PricerResults, Statistics>;
+
+// Alias for the list of results that is passed to the Output class (same layout as MultiOutputList)
+using CachedOutputList	= std::vector< std::tuple<PricerResults, Statistics> >;
+
+// Dirty flags that explain why an option has to be repriced
+enum DirtyFlag : unsigned {
+	Clean			= 0,
+	DirtyTerms		= 1,	// Strike, expiry, payoff, barrier caps or observation schedule changed
+	DirtyMarket		= 2,	// Stock price, volatility, interest rate, discount curve or dividends changed
+	DirtyModel		= 4,	// Random engine, FDM scheme, NSteps, NSIM or SABR parameters changed
+	DirtyNew		= 8		// The option was not priced in the previous run
+};
+
+// Repricing cache class that keeps the previous run's results and tracks the dirty options of the current run
+class RepricingCache {
+private:
+	std::map<std::string, CachedResult> previous_run;	// Results loaded from the previous run
+	std::map<std::string, CachedResult> current_run;	// Results of the current run, clean and dirty
+	std::vector<std::string>			dirty_ids;		// Options repriced in the current run, in pricing order
+
+	// FNV-1a hashing of raw bytes, used to fingerprint the option inputs
+	inline static std::uint64_t Hash(std::uint64_t h, const void * data, std::size_t size) {
+		const unsigned char * bytes = static_cast<const unsigned char *>(data);
+		for (std::size_t i = 0; i < size; ++i) {
+			h ^= bytes[i];
+			h *= 1099511628211ULL;
+		}
+		return h;
+	}
+
+	inline static std::uint64_t Hash(std::uint64_t h, double x) {
+		return Hash(h, &x, sizeof(x));
+	}
+
+	inline static std::uint64_t Hash(std::uint64_t h, const std::string & s) {
+		// Hash the length as well so that "ab" + "c" and "a" + "bc" differ
+		std::uint64_t n = s.size();
+		return Hash(Hash(h, &n, sizeof(n)), s.data(), s.size());
+	}
+
+	// Serialization helpers for the cache file -- one result per line, tab separated
+	inline static void WriteResult(std::ostream & os, const std::string & id, const CachedResult & res) {
+
+		const InputFingerprint & fp		= std::get<0>(res);
+		const PricerResults & pr		= std::get<1>(res);
+		const Statistics & st			= std::get<2>(res);
+		const OptionData & od			= std::get<1>(pr);
+		const std::vector<std::string> & names = std::get<3>(pr);
+
+		os.precision(17);
+		os << id << "\t" << std::get<0>(fp) << "\t" << std::get<1>(fp) << "\t" << std::get<2>(fp) << "\t";
+		os << std::get<0>(pr) << "\t"
+			<< std::get<0>(od) << "\t" << std::get<1>(od) << "\t" << std::get<2>(od) << "\t"
+			<< std::get<3>(od) << "\t" << std::get<4>(od) << "\t" << std::get<5>(od) << "\t"
+			<< std::get<2>(pr) << "\t" << std::get<4>(pr) << "\t" << std::get<5>(pr) << "\t";
+		os << names.size();
+		for (auto & n : names) os << "\t" << n;
+		os << "\t" << std::get<0>(st) << "\t" << std::get<1>(st) << "\t" << std::get<2>(st) << "\t" << std::get<3>(st)
+			<< "\t" << std::get<4>(st) << "\t" << std::get<5>(st) << "\t" << std::get<6>(st) << "\t" << std::get<7>(st) << "\n";
+	}
+
+	inline static bool ReadResult(const std::string & line, std::string & id, CachedResult & res) {
+
+		std::vector<std::string> fields;
+		std::istringstream ls(line);
+		std::string field;
+		while (std::getline(ls, field, '\t')) fields.push_back(field);
+
+		// id, 3 hashes, price, 6 option data, NSteps, 2 caps, name count
+		if (fields.size() < 15) return false;
+		std::size_t nnames = std::stoul(fields[14]);
+		if (fields.size() != 15 + nnames + 8) return false;
+
+		id = fields[0];
+		InputFingerprint fp = std::make_tuple(std::stoull(fields[1]), std::stoull(fields[2]), std::stoull(fields[3]));
+		OptionData od = std::make_tuple(std::stod(fields[5]), std::stod(fields[6]), std::stod(fields[7]),
+			std::stod(fields[8]), std::stod(fields[9]), std::stoul(fields[10]));
+		std::vector<std::string> names(fields.begin() + 15, fields.begin() + 15 + nnames);
+		PricerResults pr = std::make_tuple(std::stod(fields[4]), od, std::stoul(fields[11]), names,
+			std::stod(fields[12]), std::stod(fields[13]));
+
+		std::size_t s = 15 + nnames;
+		Statistics st = std::make_tuple(std::stod(fields[s]), std::stod(fields[s + 1]), std::stod(fields[s + 2]),
+			std::stod(fields[s + 3]), std::stod(fields[s + 4]), std::stod(fields[s + 5]),
+			std::stoi(fields[s + 6]) != 0, std::stod(fields[s + 7]));
+
+		res = std::make_tuple(fp, pr, st);
+		return true;
+	}
+
+public:
+
+	// Constructors
+	explicit RepricingCache() {}
+	explicit RepricingCache(const std::string & file_name) { Load(file_name); }
+
+	// Fingerprint the inputs of an option before it is priced
+	// NSteps only matters for the schemes that discretize time, so it is ignored for the GBM model
+	// The discount curve, if any, is fingerprinted by its tabulated log-discount factors
+	inline static InputFingerprint Fingerprint(const OptionData & od, const std::vector<std::string> & names,
+		unsigned long NSteps, double upper_cap, double lower_cap, const DiscountCurve * curve = nullptr,
+		const DividendSchedule * dividends = nullptr, const ObservationSchedule * schedule = nullptr, double monitoring_dt = 0.0,
+		const SABRParameters * sabr = nullptr) {
+
+		const std::uint64_t seed = 14695981039346656037ULL;
+
+		// Contract terms: strike, expiry, payoff name, barrier caps and observation dates
+		std::uint64_t terms = seed;
+		terms = Hash(terms, std::get<4>(od));
+		terms = Hash(terms, std::get<2>(od));
+		terms = Hash(terms, names.size() > 2 ? names[2] : std::string());
+		terms = Hash(terms, upper_cap);
+		terms = Hash(terms, lower_cap);
+		if (schedule && !schedule->empty()) {
+			terms = Hash(terms, schedule->data(), schedule->size() * sizeof(double));
+			terms = Hash(terms, monitoring_dt);
+		}
+
+		// Market data: stock price, volatility and interest rate
+		std::uint64_t market = seed;
+		market = Hash(market, std::get<3>(od));
+		market = Hash(market, std::get<0>(od));
+		market = Hash(market, std::get<1>(od));
+		if (curve) {
+			const std::vector<double> & table = curve->LogDiscountTable();
+			market = Hash(market, curve->MaxTime());
+			market = Hash(market, table.data(), table.size() * sizeof(double));
+		}
+		if (dividends) {
+			market = Hash(market, dividends->Yield());
+			for (auto & d : dividends->Discrete()) {
+				market = Hash(market, d.t);
+				market = Hash(market, d.cash);
+				market = Hash(market, d.proportional);
+			}
+		}
+
+		// Model: random engine, FDM scheme, time steps, number of simulations and SABR parameters (alpha is the volatility)
+		std::uint64_t model = seed;
+		std::uint64_t nsim = std::get<5>(od);
+		std::uint64_t nsteps = (names.size() > 1 && names[1] == "GBM") ? 0 : NSteps;
+		model = Hash(model, names.size() > 0 ? names[0] : std::string());
+		model = Hash(model, names.size() > 1 ? names[1] : std::string());
+		model = Hash(model, &nsteps, sizeof(nsteps));
+		model = Hash(model, &nsim, sizeof(nsim));
+		if (sabr) {
+			model = Hash(model, sabr->beta);
+			model = Hash(model, sabr->rho);
+			model = Hash(model, sabr->nu);
+		}
+
+		return std::make_tuple(terms, market, model);
+	}
+
+	// Stable identifier of an option across runs, derived from its contract terms fingerprint: inserting, removing or
+	// reordering options in the book does not carry a result forward to a different contract
+	// A change of terms gives a new identifier, so such an option is reported as DirtyNew rather than DirtyTerms
+	inline static std::string TradeId(const InputFingerprint & fp) {
+		std::ostringstream os;
+		os << "Trade " << std::hex << std::get<0>(fp);
+		return os.str();
+	}
+
+	// Compare the fingerprint of an option with the previous run and report what changed
+	inline unsigned DirtyFlags(const std::string & id, const InputFingerprint & fp) const {
+
+		auto it = previous_run.find(id);
+		if (it == previous_run.end()) return DirtyNew;
+
+		const InputFingerprint & old_fp = std::get<0>(it->second);
+		unsigned flags = Clean;
+		if (std::get<0>(old_fp) != std::get<0>(fp)) flags |= DirtyTerms;
+		if (std::get<1>(old_fp) != std::get<1>(fp)) flags |= DirtyMarket;
+		if (std::get<2>(old_fp) != std::get<2>(fp)) flags |= DirtyModel;
+		return flags;
+	}
+
+	// If the option is clean, carry its previous result forward into the current run and return true
+	// Otherwise return false and the caller has to price it and Store() the result
+	inline bool CarryForward(const std::string & id, const InputFingerprint & fp) {
+
+		if (DirtyFlags(id, fp) != Clean) return false;
+
+		current_run[id] = previous_run[id];
+		return true;
+	}
+
+	// Store the result of a repriced option and mark it as part of the delta
+	inline void Store(const std::string & id, const InputFingerprint & fp, const PricerResults & pr, const Statistics & st) {
+
+		current_run[id] = std::make_tuple(fp, pr, st);
+		dirty_ids.push_back(id);
+	}
+
+	// The repriced options only, in pricing order -- this is what has to be written out
+	inline CachedOutputList Delta() const {
+
+		CachedOutputList delta;
+		for (auto & id : dirty_ids) {
+			auto & res = current_run.at(id);
+			delta.push_back(std::make_tuple(std::get<1>(res), std::get<2>(res)));
+		}
+		return delta;
+	}
+
+	// The full book of the current run, clean and dirty options
+	inline CachedOutputList Full() const {
+
+		CachedOutputList full;
+		for (auto & e : current_run) {
+			full.push_back(std::make_tuple(std::get<1>(e.second), std::get<2>(e.second)));
+		}
+		return full;
+	}
+
+	// Getters
+	inline const std::vector<std::string> & DirtyIds() const { return dirty_ids; }
+	inline std::size_t CarriedForward() const { return current_run.size() - dirty_ids.size(); }
+
+	// Load the previous run's results from a cache file and start a new run
+	// A missing or corrupted file simply means that every option is dirty
+	inline bool Load(const std::string & file_name) {
+
+		previous_run.clear();
+		current_run.clear();
+		dirty_ids.clear();
+
+		std::ifstream file(file_name);
+		if (!file.is_open()) return false;
+
+		std::string line;
+		while (std::getline(file, line)) {
+			std::string id;
+			CachedResult res;
+			try {
+				if (ReadResult(line, id, res)) previous_run[id] = res;
+			}
+			catch (std::exception &) {
+				// Skip the corrupted line, the option will be repriced
+			}
+		}
+		return true;
+	}
+
+	// Save the current run's results so that the next run can reuse them
+	// Options of the previous run that were not priced this time are kept as well
+	inline bool Save(const std::string & file_name) const {
+
+		std::ofstream file(file_name);
+		if (!file.is_open()) return false;
+
+		for (auto & e : previous_run) {
+			if (current_run.find(e.first) == current_run.end()) WriteResult(file, e.first, e.second);
+		}
+		for (auto & e : current_run) {
+			WriteResult(file, e.first, e.second);
+		}
+		return true;
+	}
+
+	// Destructor
+	~RepricingCache() {}
+};
+
+#endif // !REPRICINGCACHE_HPP
@@ -0,0 +1,161 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ===================================================================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Rough Bergomi engine with the hybrid scheme and FFT convolution
+*
+*/
+
+/*   Rough Bergomi dynamics, with alpha = H - 1/2 and a flat forward variance xi_0:
+*        V_t = xi_0 exp(eta Y_t - eta^2 t^(2H) / 2),    Y_t = sqrt(2H) int_0^t (t - s)^alpha dW_s
+*        d ln S = (r - q - V / 2) dt + sqrt(V) (rho dW + sqrt(1 - rho^2) dW_perp)
+*
+*    Hybrid scheme (Bennedsen, Lunde, Pakkanen) with kappa = 1 on the grid t_i = i dt: the kernel is exact over the
+*    last step and evaluated at the optimal points b_k dt over the older ones,
+*        Y_(t_i) / sqrt(2H) = W~_i + sum_(k = 2)^i (b_k dt)^alpha dW_(i - k + 1),    b_k = ((k^(alpha+1) - (k-1)^(alpha+1)) / (alpha+1))^(1/alpha)
+*    where (dW_i, W~_i = int_(t_(i-1))^(t_i) (t_i - s)^alpha dW_s) is a Gaussian pair drawn exactly.
+*
+*    The sum is a convolution of the Brownian increments with a fixed kernel, O(N^2) per path done directly. It is
+*    done here with the FFT, O(N log N): the kernel spectrum is computed once per run, each thread has its own plan
+*    and work buffer, and the paths of a block are convolved two at a time with one complex transform pair.
+*/
+
+// Multiple inclusion guards
+#ifndef ROUGHBERGOMI_HPP
+#define ROUGHBERGOMI_HPP
+
+#include <vector>
+#include <tuple>
+#include <random>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+#include "FFT.hpp"
+#include "Parallel.hpp"
+
+// Rough Bergomi parameters
+struct RoughBergomiParameters {
+	double H;		// Hurst exponent, in (0, 1/2)
+	double eta;		// Volatility of volatility
+	double rho;		// Correlation between the stock and the volatility
+	double xi0;		// Flat forward variance
+};
+
+// Alias for the rough Bergomi output: price per strike, standard error per strike, number of paths
+using RoughBergomiResults = std::tuple<std::vector<double>, std::vector<double>, unsigned long>;
+
+// Rough Bergomi pricing engine
+class RoughBergomiEngine {
+private:
+	RoughBergomiParameters p;
+	double r;	// Interest rate
+	double q;	// Dividend yield
+
+public:
+
+	// Constructor
+	explicit RoughBergomiEngine(const RoughBergomiParameters & p_, double r_, double q_ = 0.0) : p(p_), r(r_), q(q_) {
+		if (p.H <= 0.0 || p.H >= 0.5 || p.eta < 0.0 || p.rho < -1.0 || p.rho > 1.0 || p.xi0 <= 0.0) {
+			throw std::invalid_argument("Invalid rough Bergomi parameters");
+		}
+	}
+
+	// Hybrid scheme kernel on a grid of step dt: 0 for the last step (drawn exactly), (b_k dt)^alpha for the step k - 1 before
+	inline std::vector<double> Kernel(std::size_t NSteps, double dt) const {
+		const double alpha = p.H - 0.5;
+		std::vector<double> kernel(NSteps, 0.0);
+		for (std::size_t m = 1; m < NSteps; ++m) {
+			double k = static_cast<double>(m + 1);
+			double b = pow((pow(k, alpha + 1.0) - pow(k - 1.0, alpha + 1.0)) / (alpha + 1.0), 1.0 / alpha);
+			kernel[m] = pow(b * dt, alpha);
+		}
+		return kernel;
+	}
+
+	// Price calls or puts for all the strikes with NSIM paths of NSteps steps
+	inline RoughBergomiResults Price(bool call, double S, const std::vector<double> & strikes, double T, unsigned long NSIM, unsigned long NSteps,
+		unsigned long seed = 5489u, std::size_t block_size = 1024, unsigned threads = 0) const {
+
+		if (NSIM < 2 || NSteps == 0 || T <= 0.0 || block_size == 0 || strikes.empty()) {
+			throw std::invalid_argument("Invalid rough Bergomi parameters");
+		}
+
+		const std::size_t N = static_cast<std::size_t>(NSteps), n_strikes = strikes.size();
+		const double dt = T / static_cast<double>(N), dt_sq = sqrt(dt);
+		const double alpha = p.H - 0.5, scale = sqrt(2.0 * p.H), orth = sqrt(1.0 - p.rho * p.rho);
+
+		// Exact covariance of (dW_i, W~_i): dt, dt^(alpha+1) / (alpha+1), dt^(2 alpha+1) / (2 alpha+1)
+		const double c1 = pow(dt, alpha + 1.0) / (alpha + 1.0) / dt_sq;
+		const double c2 = sqrt(std::max(pow(dt, 2.0 * alpha + 1.0) / (2.0 * alpha + 1.0) - c1 * c1, 0.0));
+
+		// Variance compensator eta^2 t_i^(2H) / 2 on the grid
+		std::vector<double> compensator(N);
+		for (std::size_t i = 0; i < N; ++i) compensator[i] = 0.5 * p.eta * p.eta * pow(static_cast<double>(i + 1) * dt, 2.0 * p.H);
+
+		// One convolution object per thread, sharing the same kernel spectrum values
+		if (threads == 0) threads = ThreadCount();
+		const RealConvolution prototype(Kernel(N, dt));
+		std::vector<RealConvolution> convolutions(threads, prototype);
+
+		BlockSums sums(BlockCount(NSIM, block_size), n_strikes);
+
+		ParallelFor(0, sums.Blocks(), [&](std::size_t b, unsigned thread_id) {
+
+			std::size_t count = std::min<std::size_t>(block_size, NSIM - b * block_size);
+			std::mt19937_64 eng(BlockSeed(seed, b));
+			std::normal_distribution<double> nd(0.0, 1.0);
+			RealConvolution & convolution = convolutions[thread_id];
+
+			// Two paths at a time: Brownian increments, exact last-step integrals, convolved history
+			std::vector<double> dW(2 * N), W_last(2 * N), history(2 * N);
+			std::vector<double> log_S(count, log(S));
+
+			for (std::size_t i = 0; i < count; i += 2) {
+
+				std::size_t pair = std::min<std::size_t>(2, count - i);
+				for (std::size_t j = 0; j < 2 * N; ++j) {
+					double z1 = nd(eng), z2 = nd(eng);
+					dW[j] = dt_sq * z1;
+					W_last[j] = c1 * z1 + c2 * z2;
+				}
+				convolution.ConvolvePair(dW.data(), dW.data() + N, history.data(), history.data() + N);
+
+				for (std::size_t path = 0; path < pair; ++path) {
+					const double * dW_p = dW.data() + path * N;
+					const double * W_p = W_last.data() + path * N;
+					const double * h_p = history.data() + path * N;
+
+					// Left-point variance: V_0 = xi_0, then V_(t_(j+1)) from the Volterra process
+					double x = log_S[i + path], V = p.xi0;
+					for (std::size_t j = 0; j < N; ++j) {
+						x += (r - q - 0.5 * V) * dt + sqrt(V) * (p.rho * dW_p[j] + orth * dt_sq * nd(eng));
+						V = p.xi0 * exp(p.eta * scale * (W_p[j] + h_p[j]) - compensator[j]);
+					}
+					log_S[i + path] = x;
+				}
+			}
+
+			for (std::size_t k = 0; k < n_strikes; ++k) {
+				double * s = sums.Slots(b, k);
+				const double K = strikes[k];
+				for (std::size_t i = 0; i < count; ++i) {
+					double ST = exp(log_S[i]);
+					BlockSums::Add(s, call ? std::max(ST - K, 0.0) : std::max(K - ST, 0.0));
+				}
+			}
+		}, threads);
+
+		std::vector<double> prices, errors;
+		sums.Estimate(exp(-r * T), NSIM, prices, errors);
+
+		return std::make_tuple(prices, errors, NSIM);
+	}
+
+	// Destructor
+	~RoughBergomiEngine() {}
+};
+
+#endif // !ROUGHBERGOMI_HPP
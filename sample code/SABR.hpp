@@ -0,0 +1,173 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ===================================================================================================================================================
+*
+*	Monte Carlo Option Pricing Application - SABR engine with large steps and a Hagan-formula control variate
+*
+*/
+
+/*   SABR dynamics of the forward to expiry:
+*        dF = alpha F^beta dW_F,    d alpha = nu alpha dW_alpha,    d<W_F, W_alpha> = rho dt
+*    The volatility is stepped exactly (it is lognormal) and the forward with the conditional log step of FDM_SDE,
+*    so a handful of steps per year is enough where Euler needs hundreds.
+*
+*    Control variate: each path also carries the lognormal proxy G_T = F_0 exp(sigma_H W_F(T) - sigma_H^2 T / 2) built
+*    on the same Brownian motion W_F, with sigma_H the Hagan implied volatility of the strike. The proxy is close to
+*    the SABR forward near the strike, and its expected payoff is the Black price at sigma_H, computed for all the
+*    strikes at once with the batch Black kernel. The optimal coefficient is estimated from the same paths.
+*/
+
+// Multiple inclusion guards
+#ifndef SABR_HPP
+#define SABR_HPP
+
+#include <vector>
+#include <tuple>
+#include <random>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+#include "FDM_SDE.hpp"
+#include "BlackScholes.hpp"
+#include "TimeGrid.hpp"
+#include "Parallel.hpp"
+
+// SABR parameters
+struct SABRParameters {
+	double alpha;	// Initial volatility
+	double beta;	// CEV exponent, in [0, 1]
+	double rho;		// Correlation between the forward and the volatility
+	double nu;		// Volatility of volatility
+};
+
+// Alias for the SABR output: price per strike, standard error per strike, number of paths
+using SABRResults = std::tuple<std::vector<double>, std::vector<double>, unsigned long>;
+
+// SABR pricing engine
+class SABREngine {
+private:
+	SABRParameters p;
+
+public:
+
+	// Constructor
+	explicit SABREngine(const SABRParameters & p_) : p(p_) {
+		Validate(p);
+	}
+
+	// Throws unless alpha > 0 (when with_alpha is set), 0 <= beta <= 1, |rho| < 1 and nu >= 0
+	inline static void Validate(const SABRParameters & p, bool with_alpha = true) {
+		if ((with_alpha && p.alpha <= 0.0) || p.beta < 0.0 || p.beta > 1.0 || p.rho <= -1.0 || p.rho >= 1.0 || p.nu < 0.0) {
+			throw std::invalid_argument("Invalid SABR parameters");
+		}
+	}
+
+	// Hagan et al. (2002) lognormal implied volatility approximation
+	inline static double HaganVol(const SABRParameters & p, double F, double K, double T) {
+
+		const double b1 = 1.0 - p.beta;
+		double FK = F * K;
+		double FK_b = pow(FK, 0.5 * b1);
+		double log_FK = log(F / K);
+
+		double correction = 1.0 + (b1 * b1 / 24.0 * p.alpha * p.alpha / (FK_b * FK_b) + 0.25 * p.rho * p.beta * p.nu * p.alpha / FK_b
+			+ (2.0 - 3.0 * p.rho * p.rho) / 24.0 * p.nu * p.nu) * T;
+		double denominator = FK_b * (1.0 + b1 * b1 / 24.0 * log_FK * log_FK + pow(b1, 4) / 1920.0 * pow(log_FK, 4));
+
+		// z / x(z), which tends to 1 at the money
+		double z = p.nu / p.alpha * FK_b * log_FK;
+		double ratio = 1.0;
+		if (std::abs(z) > 1e-7) {
+			double x = log((sqrt(1.0 - 2.0 * p.rho * z + z * z) + z - p.rho) / (1.0 - p.rho));
+			ratio = z / x;
+		}
+		return p.alpha / denominator * ratio * correction;
+	}
+
+	// Price calls or puts on the forward F0 for all the strikes, NSIM paths of NSteps steps, discounted with df
+	inline SABRResults Price(bool call, double F0, const std::vector<double> & strikes, double T, double df, unsigned long NSIM,
+		unsigned long NSteps, bool control_variate = true, unsigned long seed = 5489u, std::size_t block_size = 4096, unsigned threads = 0) const {
+
+		if (NSIM < 2 || block_size == 0 || strikes.empty()) throw std::invalid_argument("SABR engine needs paths and strikes");
+
+		const std::size_t n_strikes = strikes.size();
+		const TimeGrid grid = TimeGrid::Uniform(T, NSteps);
+		const double orth = sqrt(1.0 - p.rho * p.rho);
+
+		// Proxy volatility of each strike, and the expectation of the proxy payoffs with the batch Black kernel
+		std::vector<double> hagan(n_strikes), forward(n_strikes, F0), proxy_mean(n_strikes);
+		for (std::size_t k = 0; k < n_strikes; ++k) hagan[k] = HaganVol(p, F0, strikes[k], T);
+		BlackScholes::BlackBatch(call, forward.data(), strikes.data(), hagan.data(), T, 1.0, proxy_mean.data(), n_strikes);
+
+		// Per block and strike: sums of X, Y, X^2, Y^2, XY (X the SABR payoff, Y the proxy payoff)
+		std::size_t nblocks = BlockCount(NSIM, block_size);
+		BlockSums sums(nblocks, n_strikes, 5);
+
+		ParallelFor(0, nblocks, [&](std::size_t b, unsigned) {
+
+			std::size_t count = std::min<std::size_t>(block_size, NSIM - b * block_size);
+			std::mt19937_64 eng(BlockSeed(seed, b));
+			std::normal_distribution<double> nd(0.0, 1.0);
+
+			// Structure of arrays: forward, volatility, Brownian motion of the forward
+			std::vector<double> F(count, F0), alpha(count, p.alpha), W(count, 0.0);
+
+			for (std::size_t j = 0; j < grid.Steps(); ++j) {
+				const double dt = grid.Dt(j), dt_sq = grid.SqrtDt(j);
+				for (std::size_t i = 0; i < count; ++i) {
+					double z_vol = nd(eng), z_orth = nd(eng);
+					double alpha_next = FDM_SDE::SABRVolatility(alpha[i], p.nu, dt, z_vol);
+					F[i] = FDM_SDE::SABRForward(F[i], alpha[i], alpha_next, p.beta, p.rho, p.nu, dt, z_vol, z_orth);
+					alpha[i] = alpha_next;
+					W[i] += dt_sq * (p.rho * z_vol + orth * z_orth);
+				}
+			}
+
+			for (std::size_t k = 0; k < n_strikes; ++k) {
+				double * s = sums.Slots(b, k);
+				const double K = strikes[k], vol = hagan[k];
+				for (std::size_t i = 0; i < count; ++i) {
+					double G = F0 * exp(vol * W[i] - 0.5 * vol * vol * T);
+					double X = call ? std::max(F[i] - K, 0.0) : std::max(K - F[i], 0.0);
+					double Y = call ? std::max(G - K, 0.0) : std::max(K - G, 0.0);
+					s[0] += X;
+					s[1] += Y;
+					s[2] += X * X;
+					s[3] += Y * Y;
+					s[4] += X * Y;
+				}
+			}
+		}, threads);
+
+		// Apply the control variate per strike
+		std::vector<double> prices(n_strikes), errors(n_strikes);
+		const double N = static_cast<double>(NSIM);
+		for (std::size_t k = 0; k < n_strikes; ++k) {
+
+			std::vector<double> t = sums.Total(k);
+			double mean_X = t[0] / N, mean_Y = t[1] / N;
+			double var_X = std::max(t[2] / N - mean_X * mean_X, 0.0);
+			double var_Y = std::max(t[3] / N - mean_Y * mean_Y, 0.0);
+			double cov = t[4] / N - mean_X * mean_Y;
+
+			double price = mean_X, variance = var_X;
+			if (control_variate && var_Y > 0.0) {
+				double beta = cov / var_Y;
+				price = mean_X - beta * (mean_Y - proxy_mean[k]);
+				variance = std::max(var_X - cov * cov / var_Y, 0.0);
+			}
+			prices[k] = df * price;
+			errors[k] = df * sqrt(variance / (N - 1.0));
+		}
+
+		return std::make_tuple(prices, errors, NSIM);
+	}
+
+	// Destructor
+	~SABREngine() {}
+};
+
+#endif // !SABR_HPP
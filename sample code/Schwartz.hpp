@@ -0,0 +1,283 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ===================================================================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Schwartz-Smith mean-reverting commodity model with exact OU steps
+*
+*/
+
+/*   Two-factor Schwartz-Smith model of the log-spot, under the pricing measure:
+*        ln S_t = phi(t) + chi_t + xi_t
+*        d chi = -kappa chi dt + sigma_chi dW_chi        (short-term deviations, Ornstein-Uhlenbeck)
+*        d xi  = mu dt + sigma_xi dW_xi                   (long-term level, Brownian motion with drift)
+*        d<W_chi, W_xi> = rho dt
+*    The one-factor Schwartz model is the case sigma_xi = mu = 0: the log-spot reverts to a constant level.
+*
+*    The futures price is F(t, T) = exp(phi(T) + chi_t e^(-kappa h) + xi_t + mu h + V(h) / 2), h = T - t, with
+*        V(h) = sigma_chi^2 (1 - e^(-2 kappa h)) / (2 kappa) + sigma_xi^2 h + 2 rho sigma_chi sigma_xi (1 - e^(-kappa h)) / kappa
+*    The shift phi is zero, or fitted to a market futures curve so that F(0, T) matches it for every T.
+*    A European option on F(., T_f) expiring at T is a Black option with the variance of ln F(T, T_f).
+*
+*    Over a step of length h the pair (chi, xi) has the exact Gaussian transition
+*        chi' = chi e^(-kappa h) + e_chi,    xi' = xi + mu h + e_xi
+*    and the Cholesky factor of Cov(e_chi, e_xi) is computed once per step, so the path kernels are a few
+*    multiply-adds over the arrays of a block and any step size is exact.
+*/
+
+// Multiple inclusion guards
+#ifndef SCHWARTZ_HPP
+#define SCHWARTZ_HPP
+
+#include <vector>
+#include <tuple>
+#include <random>
+#include <utility>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+#include "BlackScholes.hpp"
+#include "TimeGrid.hpp"
+#include "Parallel.hpp"
+
+// Schwartz-Smith parameters
+struct SchwartzSmithParameters {
+	double kappa;		// Mean reversion speed of the short-term factor
+	double sigma_chi;	// Volatility of the short-term factor
+	double mu;			// Drift of the long-term factor
+	double sigma_xi;	// Volatility of the long-term factor
+	double rho;			// Correlation between the factors
+	double chi0;		// Initial short-term factor
+	double xi0;			// Initial long-term factor
+};
+
+// Market futures curve, log-linear between the quoted maturities and flat outside
+class FuturesCurve {
+private:
+	std::vector<double> maturities;
+	std::vector<double> log_prices;
+
+public:
+
+	// Constructors
+	explicit FuturesCurve() {}
+	explicit FuturesCurve(const std::vector<std::pair<double, double>> & quotes) {
+		std::vector<std::pair<double, double>> sorted(quotes);
+		std::sort(sorted.begin(), sorted.end());
+		for (auto & quote : sorted) {
+			if (quote.first <= 0.0 || quote.second <= 0.0) throw std::invalid_argument("Invalid futures quote");
+			maturities.push_back(quote.first);
+			log_prices.push_back(log(quote.second));
+		}
+	}
+
+	inline bool Empty() const { return maturities.empty(); }
+
+	// Log futures price of maturity T
+	inline double LogPrice(double T) const {
+		if (T <= maturities.front()) return log_prices.front();
+		if (T >= maturities.back()) return log_prices.back();
+		std::size_t i = std::upper_bound(maturities.begin(), maturities.end(), T) - maturities.begin() - 1;
+		double w = (T - maturities[i]) / (maturities[i + 1] - maturities[i]);
+		return log_prices[i] + w * (log_prices[i + 1] - log_prices[i]);
+	}
+
+	// Destructor
+	~FuturesCurve() {}
+};
+
+// Schwartz-Smith model, optionally fitted to a futures curve
+class SchwartzSmith {
+private:
+	SchwartzSmithParameters p;
+	FuturesCurve curve;
+
+	// ln F(t, T) without the shift phi(T), given the factors at t
+	inline double LogFuturesFactors(double h, double chi, double xi) const {
+		return chi * exp(-p.kappa * h) + xi + p.mu * h + 0.5 * Variance(h);
+	}
+
+public:
+
+	// Constructors
+	explicit SchwartzSmith(const SchwartzSmithParameters & p_, const FuturesCurve & curve_ = FuturesCurve()) : p(p_), curve(curve_) {
+		if (p.kappa <= 0.0 || p.sigma_chi < 0.0 || p.sigma_xi < 0.0 || p.rho < -1.0 || p.rho > 1.0) {
+			throw std::invalid_argument("Invalid Schwartz-Smith parameters");
+		}
+	}
+
+	// One-factor Schwartz: ln S reverts at speed kappa to the level log_level, from ln S_0 = log_spot
+	inline static SchwartzSmithParameters OneFactor(double kappa, double sigma, double log_level, double log_spot) {
+		return { kappa, sigma, 0.0, 0.0, 0.0, log_spot - log_level, log_level };
+	}
+
+	// Getter
+	inline const SchwartzSmithParameters & Parameters() const { return p; }
+
+	// Conditional variance of chi + xi over a horizon h, V(h) of the model
+	inline double Variance(double h) const {
+		const double k = p.kappa;
+		return p.sigma_chi * p.sigma_chi * (1.0 - exp(-2.0 * k * h)) / (2.0 * k) + p.sigma_xi * p.sigma_xi * h
+			+ 2.0 * p.rho * p.sigma_chi * p.sigma_xi * (1.0 - exp(-k * h)) / k;
+	}
+
+	// Shift phi(T): zero, or the one that reprices the futures curve
+	inline double Shift(double T) const {
+		return curve.Empty() ? 0.0 : curve.LogPrice(T) - LogFuturesFactors(T, p.chi0, p.xi0);
+	}
+
+	// Futures price F(t, T) given the factors at t
+	inline double Futures(double t, double T, double chi, double xi) const {
+		return exp(Shift(T) + LogFuturesFactors(T - t, chi, xi));
+	}
+
+	// Futures price F(0, T) of the model
+	inline double Futures(double T) const { return Futures(0.0, T, p.chi0, p.xi0); }
+
+	// Variance of ln F(T, T_f), T <= T_f
+	inline double FuturesVariance(double T, double T_f) const {
+		const double k = p.kappa, e = exp(-k * (T_f - T));
+		return p.sigma_chi * p.sigma_chi * e * e * (1.0 - exp(-2.0 * k * T)) / (2.0 * k) + p.sigma_xi * p.sigma_xi * T
+			+ 2.0 * p.rho * p.sigma_chi * p.sigma_xi * e * (1.0 - exp(-k * T)) / k;
+	}
+
+	// Closed form of a European call or put expiring at T on the futures of maturity T_f (on the spot if T_f = T)
+	inline double FuturesOption(bool call, double K, double T, double T_f, double r) const {
+		return BlackScholes::Black(call, Futures(T_f), K, T, exp(-r * T), sqrt(FuturesVariance(T, T_f) / T));
+	}
+
+	// Destructor
+	~SchwartzSmith() {}
+};
+
+// Alias for the commodity output: price per strike, standard error per strike, number of paths
+using CommodityResults = std::tuple<std::vector<double>, std::vector<double>, unsigned long>;
+
+// Monte Carlo engine for the Schwartz-Smith model
+class SchwartzSmithEngine {
+private:
+	SchwartzSmith model;
+	double r;	// Interest rate
+
+	// Exact transition constants of one step
+	struct Transition {
+		double e;		// e^(-kappa h)
+		double drift;	// mu h
+		double L[3];	// Lower Cholesky factor of Cov(e_chi, e_xi): L00, L10, L11
+	};
+
+	inline std::vector<Transition> Transitions(const TimeGrid & grid) const {
+
+		const SchwartzSmithParameters & p = model.Parameters();
+		std::vector<Transition> steps(grid.Steps());
+
+		for (std::size_t j = 0; j < grid.Steps(); ++j) {
+			double h = grid.Dt(j);
+			Transition & s = steps[j];
+			s.e = exp(-p.kappa * h);
+			s.drift = p.mu * h;
+
+			double cxx = p.sigma_chi * p.sigma_chi * (1.0 - s.e * s.e) / (2.0 * p.kappa);
+			double cyy = p.sigma_xi * p.sigma_xi * h;
+			double cxy = p.rho * p.sigma_chi * p.sigma_xi * (1.0 - s.e) / p.kappa;
+
+			s.L[0] = sqrt(cxx);
+			s.L[1] = (s.L[0] > 0.0) ? cxy / s.L[0] : 0.0;
+			s.L[2] = sqrt(std::max(cyy - s.L[1] * s.L[1], 0.0));
+		}
+		return steps;
+	}
+
+	// Simulate the factors on the grid; at every observed date call observe(j, chi, xi, count) on the block arrays
+	// then add payoff(i) over the block for every strike into the block sums
+	template <class Observe, class Payoff>
+	inline CommodityResults Simulate(const TimeGrid & grid, std::size_t n_strikes, double T_pay, unsigned long NSIM, Observe observe,
+		Payoff payoff, unsigned long seed, std::size_t block_size, unsigned threads) const {
+
+		if (NSIM < 2 || block_size == 0 || n_strikes == 0) throw std::invalid_argument("Invalid Schwartz-Smith engine parameters");
+
+		const SchwartzSmithParameters & p = model.Parameters();
+		const std::vector<Transition> steps = Transitions(grid);
+
+		BlockSums sums(BlockCount(NSIM, block_size), n_strikes);
+
+		ParallelFor(0, sums.Blocks(), [&](std::size_t b, unsigned) {
+
+			std::size_t count = std::min<std::size_t>(block_size, NSIM - b * block_size);
+			std::mt19937_64 eng(BlockSeed(seed, b));
+			std::normal_distribution<double> nd(0.0, 1.0);
+
+			// Structure of arrays: both factors, and the per-path state kept by the payoff
+			std::vector<double> chi(count, p.chi0), xi(count, p.xi0), state(count, 0.0);
+
+			for (std::size_t j = 0; j < steps.size(); ++j) {
+				const Transition & s = steps[j];
+				for (std::size_t i = 0; i < count; ++i) {
+					double z0 = nd(eng), z1 = nd(eng);
+					chi[i] = chi[i] * s.e + s.L[0] * z0;
+					xi[i] += s.drift + s.L[1] * z0 + s.L[2] * z1;
+				}
+				if (grid.IsObservation(j + 1)) observe(j + 1, chi.data(), xi.data(), state.data(), count);
+			}
+
+			for (std::size_t k = 0; k < n_strikes; ++k) {
+				double * out = sums.Slots(b, k);
+				for (std::size_t i = 0; i < count; ++i) BlockSums::Add(out, payoff(k, state[i]));
+			}
+		}, threads);
+
+		std::vector<double> prices, errors;
+		sums.Estimate(exp(-r * T_pay), NSIM, prices, errors);
+		return std::make_tuple(prices, errors, NSIM);
+	}
+
+public:
+
+	// Constructor
+	explicit SchwartzSmithEngine(const SchwartzSmith & model_, double r_) : model(model_), r(r_) {}
+
+	// European calls or puts expiring at T on the futures of maturity T_f (on the spot if T_f = 0), one exact step
+	inline CommodityResults Price(bool call, const std::vector<double> & strikes, double T, unsigned long NSIM, double T_f = 0.0,
+		unsigned long seed = 5489u, std::size_t block_size = 4096, unsigned threads = 0) const {
+
+		if (T_f == 0.0) T_f = T;
+		if (T <= 0.0 || T_f < T) throw std::invalid_argument("Option expiry must be before the futures maturity");
+
+		// ln F(T, T_f) = shift + e chi_T + xi_T
+		const double h = T_f - T, e = exp(-model.Parameters().kappa * h);
+		const double shift = model.Shift(T_f) + model.Parameters().mu * h + 0.5 * model.Variance(h);
+		return Simulate(TimeGrid::Uniform(T, 1), strikes.size(), T, NSIM,
+			[&](std::size_t, const double * chi, const double * xi, double * F, std::size_t count) {
+				for (std::size_t i = 0; i < count; ++i) F[i] = exp(shift + e * chi[i] + xi[i]);
+			},
+			[&](std::size_t k, double F) { return call ? std::max(F - strikes[k], 0.0) : std::max(strikes[k] - F, 0.0); },
+			seed, block_size, threads);
+	}
+
+	// Asian calls or puts on the average spot over the observation dates, paid at the last date
+	// The factors step exactly from one date to the next, so the schedule is the whole grid
+	inline CommodityResults PriceAsian(bool call, const std::vector<double> & strikes, const ObservationSchedule & schedule, unsigned long NSIM,
+		unsigned long seed = 5489u, std::size_t block_size = 4096, unsigned threads = 0) const {
+
+		if (schedule.empty()) throw std::invalid_argument("Asian option needs observation dates");
+
+		const double T = *std::max_element(schedule.begin(), schedule.end());
+		const TimeGrid grid = TimeGrid::FromSchedule(T, schedule);
+		const double inv_n = 1.0 / static_cast<double>(grid.Observations());
+
+		return Simulate(grid, strikes.size(), T, NSIM,
+			[&](std::size_t j, const double * chi, const double * xi, double * average, std::size_t count) {
+				const double shift = model.Shift(grid.Time(j));
+				for (std::size_t i = 0; i < count; ++i) average[i] += inv_n * exp(shift + chi[i] + xi[i]);
+			},
+			[&](std::size_t k, double A) { return call ? std::max(A - strikes[k], 0.0) : std::max(strikes[k] - A, 0.0); },
+			seed, block_size, threads);
+	}
+
+	// Destructor
+	~SchwartzSmithEngine() {}
+};
+
+#endif // !SCHWARTZ_HPP
@@ -0,0 +1,232 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ==============================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Sobol sequence with Gray-code skip-ahead and parallel partitioning
+*
+*/
+
+/*   Coordinate j of Sobol point i is the XOR of the direction numbers v_j,k over the bits k set in the Gray code
+*    g(i) = i ^ (i >> 1). Consecutive Gray codes differ in one bit, the lowest zero bit of i, so
+*        x_(i+1) = x_i ^ v_(ctz(i+1))
+*    costs one XOR per coordinate, while jumping to any index costs one XOR per set bit, O(log n).
+*
+*    A run is split in contiguous ranges of indices. Each worker (thread or process) jumps to the start of its range
+*    and continues with the recurrence, so the point set of a parallel run is bitwise the one of the serial run,
+*    whatever the number of workers. A random digital shift (XOR with a random word per coordinate) keeps the
+*    structure of the point set and gives independent replicates for error estimates.
+*
+*    Direction numbers are those of Joe and Kuo (new-joe-kuo-6.21201) for the first 21 dimensions; more dimensions are
+*    loaded from a file in the same format.
+*/
+
+// Multiple inclusion guards
+#ifndef SOBOL_HPP
+#define SOBOL_HPP
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <utility>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+
+#include "BlackScholes.hpp"
+#include "PathConstruction.hpp"
+#include "Parallel.hpp"
+
+// One line of a direction number table: degree s, coefficients a of the primitive polynomial, initial numbers m_1..m_s
+struct SobolPolynomial {
+	unsigned s;
+	std::uint32_t a;
+	std::vector<std::uint32_t> m;
+};
+
+// Sobol sequence class
+class Sobol {
+private:
+	static constexpr unsigned bits = 32;
+	std::size_t dims = 0;
+	std::vector<std::uint32_t> v;		// Direction numbers, dims x bits, row j holding v_j,0 ... v_j,31
+
+	// Embedded direction numbers for dimensions 2 to 21
+	inline static std::vector<SobolPolynomial> Embedded() {
+		return {
+			{ 1, 0, { 1 } },
+			{ 2, 1, { 1, 3 } },
+			{ 3, 1, { 1, 3, 1 } },
+			{ 3, 2, { 1, 1, 1 } },
+			{ 4, 1, { 1, 1, 3, 3 } },
+			{ 4, 4, { 1, 3, 5, 13 } },
+			{ 5, 2, { 1, 1, 5, 5, 17 } },
+			{ 5, 4, { 1, 1, 5, 5, 5 } },
+			{ 5, 7, { 1, 1, 7, 11, 19 } },
+			{ 5, 11, { 1, 1, 5, 1, 1 } },
+			{ 5, 13, { 1, 1, 1, 3, 11 } },
+			{ 5, 14, { 1, 3, 5, 5, 31 } },
+			{ 6, 1, { 1, 3, 3, 9, 7, 49 } },
+			{ 6, 13, { 1, 1, 1, 15, 21, 21 } },
+			{ 6, 16, { 1, 3, 1, 13, 27, 49 } },
+			{ 6, 19, { 1, 1, 1, 15, 7, 5 } },
+			{ 6, 22, { 1, 3, 1, 15, 13, 25 } },
+			{ 6, 25, { 1, 1, 5, 5, 19, 61 } },
+			{ 7, 1, { 1, 3, 7, 11, 23, 15, 103 } },
+			{ 7, 4, { 1, 3, 7, 13, 13, 15, 69 } }
+		};
+	}
+
+	// Direction numbers of the first dimension and of the dimensions given by the polynomials
+	inline void Initialize(const std::vector<SobolPolynomial> & polynomials) {
+
+		v.assign(dims * bits, 0);
+		for (unsigned k = 0; k < bits; ++k) v[k] = std::uint32_t(1) << (bits - 1 - k);
+
+		for (std::size_t j = 1; j < dims; ++j) {
+
+			const SobolPolynomial & p = polynomials[j - 1];
+			if (p.s == 0 || p.m.size() != p.s) throw std::invalid_argument("Invalid Sobol direction numbers");
+
+			std::uint32_t * vj = v.data() + j * bits;
+			for (unsigned k = 0; k < p.s && k < bits; ++k) {
+				if ((p.m[k] & 1) == 0 || p.m[k] >= (std::uint32_t(1) << (k + 1))) throw std::invalid_argument("Invalid Sobol direction numbers");
+				vj[k] = p.m[k] << (bits - 1 - k);
+			}
+			for (unsigned k = p.s; k < bits; ++k) {
+				vj[k] = vj[k - p.s] ^ (vj[k - p.s] >> p.s);
+				for (unsigned l = 1; l < p.s; ++l) {
+					if ((p.a >> (p.s - 1 - l)) & 1) vj[k] ^= vj[k - l];
+				}
+			}
+		}
+	}
+
+	// Index of the lowest zero bit of i
+	inline static unsigned LowestZeroBit(std::uint64_t i) {
+		unsigned c = 0;
+		while (i & 1) {
+			i >>= 1;
+			c++;
+		}
+		return c;
+	}
+
+public:
+
+	// Constructors
+	// Embedded direction numbers, up to 21 dimensions
+	explicit Sobol(std::size_t dims_) : dims(dims_) {
+		std::vector<SobolPolynomial> polynomials = Embedded();
+		if (dims == 0 || dims > polynomials.size() + 1) {
+			throw std::invalid_argument("The embedded Sobol direction numbers have 21 dimensions, load a table for more");
+		}
+		Initialize(polynomials);
+	}
+
+	// Direction numbers from a table
+	explicit Sobol(std::size_t dims_, const std::vector<SobolPolynomial> & polynomials) : dims(dims_) {
+		if (dims == 0 || dims > polynomials.size() + 1) throw std::invalid_argument("Not enough Sobol direction numbers");
+		Initialize(polynomials);
+	}
+
+	// Read a table in the format of Joe and Kuo: a header line, then "d s a m_1 ... m_s" per line from d = 2
+	inline static std::vector<SobolPolynomial> Load(const std::string & file_name) {
+
+		std::ifstream file(file_name);
+		if (!file) throw std::runtime_error("Cannot open Sobol direction numbers file " + file_name);
+
+		std::vector<SobolPolynomial> polynomials;
+		std::string line;
+		while (std::getline(file, line)) {
+			std::istringstream ss(line);
+			unsigned d;
+			SobolPolynomial p;
+			if (!(ss >> d >> p.s >> p.a)) continue;
+			p.m.resize(p.s);
+			for (auto & m : p.m) ss >> m;
+			if (!ss) throw std::runtime_error("Invalid line in Sobol direction numbers file " + file_name);
+			polynomials.push_back(p);
+		}
+		return polynomials;
+	}
+
+	// Getter
+	inline std::size_t Dimension() const { return dims; }
+
+	// Contiguous range [begin, end) of the points of worker w among workers for a run of total points
+	// The ranges are multiples of block points, except the last one, so the workers can step in whole blocks
+	inline static std::pair<std::uint64_t, std::uint64_t> Partition(std::uint64_t total, unsigned workers, unsigned w, std::uint64_t block = 1) {
+
+		if (workers == 0 || w >= workers || block == 0) throw std::invalid_argument("Invalid Sobol partition");
+
+		std::uint64_t blocks = (total + block - 1) / block;
+		std::uint64_t begin = (blocks * w / workers) * block;
+		std::uint64_t end = (blocks * (w + 1) / workers) * block;
+		return std::make_pair(std::min(begin, total), std::min(end, total));
+	}
+
+	// Random digital shift of replicate q, one word per dimension
+	inline std::vector<std::uint32_t> DigitalShift(unsigned q, unsigned long seed = 5489u) const {
+		std::mt19937_64 eng(BlockSeed(seed, q));
+		std::vector<std::uint32_t> shift(dims);
+		for (auto & s : shift) s = static_cast<std::uint32_t>(eng() >> 32);
+		return shift;
+	}
+
+	// Points first, ..., first + count - 1 in the first d dimensions, count x d row-major, XORed with shift (or not, if null)
+	// The integer points are centred in their cell of width 2^-32, so no coordinate is exactly 0 or 1
+	inline void Uniforms(std::uint64_t first, std::size_t count, std::size_t d, const std::uint32_t * shift, double * u) const {
+
+		if (d > dims) throw std::invalid_argument("Sobol sequence has fewer dimensions than requested");
+		if (first + count > (std::uint64_t(1) << bits)) throw std::invalid_argument("Sobol sequence has 2^32 points");
+
+		// Skip ahead: XOR the direction numbers of the bits of the Gray code of first
+		std::vector<std::uint32_t> x(d, 0);
+		std::uint64_t gray = first ^ (first >> 1);
+		for (unsigned k = 0; gray != 0; ++k, gray >>= 1) {
+			if (gray & 1) {
+				for (std::size_t j = 0; j < d; ++j) x[j] ^= v[j * bits + k];
+			}
+		}
+
+		const double scale = 1.0 / 4294967296.0;
+		for (std::size_t p = 0; p < count; ++p) {
+			double * up = u + p * d;
+			for (std::size_t j = 0; j < d; ++j) {
+				std::uint32_t y = shift ? (x[j] ^ shift[j]) : x[j];
+				up[j] = (static_cast<double>(y) + 0.5) * scale;
+			}
+
+			// Gray-code recurrence to the next point
+			unsigned c = LowestZeroBit(first + p);
+			if (c < bits) {
+				for (std::size_t j = 0; j < d; ++j) x[j] ^= v[j * bits + c];
+			}
+		}
+	}
+
+	// Normal generator for the engines, digitally shifted for replicate q, or unshifted if randomize is false
+	inline NormalBlockGenerator Generator(std::size_t d, unsigned q = 0, bool randomize = true, unsigned long seed = 5489u) const {
+
+		if (d > dims) throw std::invalid_argument("Sobol sequence has fewer dimensions than requested");
+
+		Sobol sequence(*this);
+		std::vector<std::uint32_t> shift = DigitalShift(q, seed);
+		shift.resize(d);
+		return [sequence, shift, randomize](unsigned long first, std::size_t count, std::size_t dimension, double * out) {
+			if (dimension != shift.size()) throw std::invalid_argument("Sobol generator used with a different dimension");
+			sequence.Uniforms(first, count, dimension, randomize ? shift.data() : nullptr, out);
+			for (std::size_t i = 0; i < count * dimension; ++i) out[i] = BlackScholes::InverseN(out[i]);
+		};
+	}
+
+	// Destructor
+	~Sobol() {}
+};
+
+#endif // !SOBOL_HPP
@@ -0,0 +1,163 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ===================================================================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Heston variance scheme and conditional Monte Carlo for stochastic volatility vanillas
+*
+*/
+
+/*   Heston dynamics:
+*        dS = (r - q) S dt + sqrt(v) S dW1
+*        dv = kappa (theta - v) dt + xi sqrt(v) dW2,        d<W1, W2> = rho dt
+*
+*    Conditional Monte Carlo (Romano-Touzi): given the variance path, ln S_T is Gaussian. With
+*        I = int v dt,    J = int sqrt(v) dW2 = (v_T - v_0 - kappa theta T + kappa I) / xi
+*    the terminal stock is lognormal with
+*        S_eff = S_0 exp(rho J - rho^2 I / 2),    vol_eff = sqrt((1 - rho^2) I / T)
+*    so each path contributes a Black-Scholes price instead of a sampled payoff. Only the variance factor is simulated,
+*    with the QE scheme of Andersen, and the spot noise disappears from the estimator.
+*/
+
+// Multiple inclusion guards
+#ifndef STOCHASTICVOL_HPP
+#define STOCHASTICVOL_HPP
+
+#include <vector>
+#include <tuple>
+#include <random>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+#include "BlackScholes.hpp"
+#include "Parallel.hpp"
+
+// Heston model parameters
+struct HestonParameters {
+	double v0;		// Initial variance
+	double kappa;	// Mean reversion speed
+	double theta;	// Long-run variance
+	double xi;		// Volatility of variance
+	double rho;		// Correlation between the stock and the variance
+};
+
+// Quadratic-Exponential step of the Heston variance (Andersen), with the constants of a fixed dt precomputed
+class HestonQE {
+private:
+	double theta;
+	double e;		// exp(-kappa dt)
+	double c1;		// Conditional variance = v c1 + c2
+	double c2;
+	double psi_c;	// Switching level between the quadratic and the exponential branches
+
+public:
+
+	// Constructor
+	explicit HestonQE(const HestonParameters & p, double dt, double psi_c_ = 1.5) : theta(p.theta), psi_c(psi_c_) {
+		e = exp(-p.kappa * dt);
+		c1 = p.xi * p.xi * e * (1.0 - e) / p.kappa;
+		c2 = p.theta * p.xi * p.xi * (1.0 - e) * (1.0 - e) / (2.0 * p.kappa);
+	}
+
+	// Next variance from the current one, a standard normal z and an independent uniform u
+	inline double Step(double v, double z, double u) const {
+
+		double m = theta + (v - theta) * e;
+		double s2 = v * c1 + c2;
+		double psi = s2 / (m * m);
+
+		if (psi <= psi_c) {
+			double inv_psi = 2.0 / psi;
+			double b2 = inv_psi - 1.0 + sqrt(inv_psi) * sqrt(inv_psi - 1.0);
+			double a = m / (1.0 + b2);
+			double x = sqrt(b2) + z;
+			return a * x * x;
+		}
+
+		double p = (psi - 1.0) / (psi + 1.0);
+		double beta = (1.0 - p) / m;
+		return (u <= p) ? 0.0 : log((1.0 - p) / (1.0 - u)) / beta;
+	}
+
+	// Conditional mean of the next variance
+	inline double ExpectedNext(double v) const { return theta + (v - theta) * e; }
+};
+
+// Alias for the conditional Monte Carlo output: price, standard error, number of paths
+using ConditionalMCResults = std::tuple<double, double, unsigned long>;
+
+// Conditional Monte Carlo pricer for Heston vanillas
+class HestonConditionalMC {
+private:
+	HestonParameters p;
+	double r;	// Interest rate
+	double q;	// Dividend yield
+
+public:
+
+	// Constructor
+	explicit HestonConditionalMC(const HestonParameters & p_, double r_, double q_ = 0.0) : p(p_), r(r_), q(q_) {
+		if (p.xi <= 0.0 || p.kappa <= 0.0) throw std::invalid_argument("Heston conditional MC needs kappa > 0 and xi > 0");
+	}
+
+	// Price a call or put with NSIM variance paths of NSteps steps
+	// The paths are split in blocks, each one with its own seed, and the blocks run in parallel;
+	// the result does not depend on the number of threads
+	inline ConditionalMCResults Price(bool call, double S, double K, double T, unsigned long NSIM, unsigned long NSteps,
+		unsigned long seed = 5489u, std::size_t block_size = 4096, unsigned threads = 0) const {
+
+		if (NSIM < 2 || NSteps == 0 || T <= 0.0) throw std::invalid_argument("Invalid conditional MC parameters");
+
+		const double dt = T / static_cast<double>(NSteps);
+		const HestonQE qe(p, dt);
+		const double rho2 = p.rho * p.rho;
+		const double inv_xi = 1.0 / p.xi;
+
+		BlockSums sums(BlockCount(NSIM, block_size), 1);
+
+		ParallelFor(0, sums.Blocks(), [&](std::size_t b, unsigned) {
+
+			std::size_t first = b * block_size;
+			std::size_t count = std::min<std::size_t>(block_size, NSIM - first);
+
+			std::mt19937_64 eng(BlockSeed(seed, b));
+			std::normal_distribution<double> nd(0.0, 1.0);
+			std::uniform_real_distribution<double> ud(0.0, 1.0);
+
+			// Structure of arrays for the block: variance, integrated variance, then spot and vol for the BS kernel
+			std::vector<double> v(count, p.v0), I(count, 0.0), S_eff(count), vol_eff(count), price(count);
+
+			for (unsigned long j = 0; j < NSteps; ++j) {
+				for (std::size_t i = 0; i < count; ++i) {
+					double v_next = qe.Step(v[i], nd(eng), ud(eng));
+					I[i] += 0.5 * (v[i] + v_next) * dt;
+					v[i] = v_next;
+				}
+			}
+
+			// Conditional lognormal parameters of each path
+			for (std::size_t i = 0; i < count; ++i) {
+				double J = (v[i] - p.v0 - p.kappa * p.theta * T + p.kappa * I[i]) * inv_xi;
+				S_eff[i] = S * exp(p.rho * J - 0.5 * rho2 * I[i]);
+				vol_eff[i] = sqrt(std::max((1.0 - rho2) * I[i] / T, 0.0));
+			}
+
+			BlackScholes::PriceBatch(call, S_eff.data(), vol_eff.data(), K, T, r, q, price.data(), count);
+
+			double * s = sums.Slots(b, 0);
+			for (std::size_t i = 0; i < count; ++i) BlockSums::Add(s, price[i]);
+		}, threads);
+
+		// The blocks are reduced in order, so the result is reproducible
+		std::vector<double> mean, SE;
+		sums.Estimate(1.0, NSIM, mean, SE);
+		return std::make_tuple(mean[0], SE[0], NSIM);
+	}
+
+	// Destructor
+	~HestonConditionalMC() {}
+};
+
+#endif // !STOCHASTICVOL_HPP
@@ -0,0 +1,120 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ==================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Test code for the barrier parity pricer against Reiner-Rubinstein
+*
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include "Input.hpp"
+#include "Pricer.hpp"
+#include "BlackScholes.hpp"
+
+// Payoff caps of a single barrier option, as the Pricer reads them from its payoff class
+template <int Upper, int Lower>
+struct BarrierCaps {
+	static double GetUpperCap() { return Upper; }
+	static double GetLowerCap() { return Lower; }
+};
+
+// Market and simulation data shared by the cases
+const double vol	= 0.25;		// Volatility
+const double r		= 0.05;		// Rate
+const double q		= 0.02;		// Dividend yield
+const double T		= 1.0;		// Expiry
+const double S		= 100;		// Stock price
+const unsigned long NSIM = 100000, NSteps = 50;
+
+// Price one barrier option with BarrierParityPricer(), monitored continuously and then on 12 monthly dates
+template <int Upper, int Lower>
+bool TestCase(bool call, bool knock_in, double K) {
+
+	const bool up = Upper > 0;
+	const double H = up ? Upper : Lower;
+	const std::string name = std::string(up ? "Up " : "Down ") + (knock_in ? "Knock-In " : "Knock-Out ") + (call ? "Call" : "Put");
+
+	PayoffFunctionType payoff = [call](double k, double s) { return call ? std::max(s - k, 0.0) : std::max(k - s, 0.0); };
+	Pricer<FDM_SDE, RNG, BarrierCaps<Upper, Lower>, Input> pricer(ModelParameterTuple(RNGFunctionType(), 1, payoff),
+		{ "Default Random Engine", "GBM", name }, OptionData(vol, r, T, S, K, NSIM));
+	pricer.setNSteps(NSteps);
+	pricer.setDividends(DividendSchedule(q));
+
+	double vanilla	= BlackScholes::Price(call, S, K, T, r, q, vol);
+	double in		= BlackScholes::Barrier(call, up, true, S, K, H, T, r, q, vol);
+	double out		= BlackScholes::Barrier(call, up, false, S, K, H, T, r, q, vol);
+
+	// With the strike beyond an up barrier for a call (below a down barrier for a put) the knock-out is worthless on every path
+	bool worthless = out < 1e-8;
+
+	// Continuous monitoring: no control variate, the three prices within 4 of their (non-zero) standard errors
+	BarrierParityResults c = pricer.BarrierParityPricer();
+	bool parity_ok = std::abs(std::get<1>(c) + std::get<0>(c) - std::get<2>(c)) < 1e-10;
+	bool se_ok = (worthless || std::get<3>(c) > 0.0) && std::get<4>(c) > 0.0 && std::get<5>(c) > 0.0;
+	bool mc_ok = std::abs(std::get<0>(c) - out) <= 4.0 * std::get<3>(c) + 1e-12 && std::abs(std::get<1>(c) - in) < 4.0 * std::get<4>(c)
+		&& std::abs(std::get<2>(c) - vanilla) < 4.0 * std::get<5>(c);
+
+	// Discrete monitoring on the same paths, without and with the continuous knock-out as control variate
+	pricer.setObservationSchedule(TimeGrid::Periodic(T, 12));
+	pricer.ClearStockFlunctuationsVector();
+	pricer.ClearTempOptionPriceVector();
+	BarrierParityResults d = pricer.BarrierParityPricer(false);
+	pricer.ClearStockFlunctuationsVector();
+	pricer.ClearTempOptionPriceVector();
+	BarrierParityResults e = pricer.BarrierParityPricer(true);
+
+	// The controlled prices agree with the plain ones and keep exact parity; the error of the priced payoff is smaller,
+	// unless the knock-out is worthless and the control is zero
+	double se_cv = knock_in ? std::get<4>(e) : std::get<3>(e), se_plain = knock_in ? std::get<4>(d) : std::get<3>(d);
+	bool cv_ok = std::abs(std::get<1>(e) + std::get<0>(e) - std::get<2>(e)) < 1e-10
+		&& std::abs(std::get<0>(e) - std::get<0>(d)) <= 4.0 * std::get<3>(d) && std::abs(std::get<1>(e) - std::get<1>(d)) <= 4.0 * std::get<4>(d)
+		&& (worthless ? se_cv <= se_plain : se_cv < se_plain);
+
+	// The path payoffs handed to MIS average to the option price
+	PricerOutputMIS mis = pricer.MIS_output();
+	const std::vector<double> & paths = std::get<3>(mis);
+	double mean = 0;
+	for (double p : paths) mean += p;
+	mean *= exp(-r * T) / static_cast<double>(paths.size());
+	bool mis_ok = paths.size() == NSIM && std::abs(mean - std::get<0>(mis)) < 1e-10 * std::max(1.0, std::abs(mean));
+
+	std::cout << name << " K=" << K << " H=" << H << ": continuous out " << std::get<0>(c) << " (RR " << out << ", SE " << std::get<3>(c)
+		<< ") in " << std::get<1>(c) << " (RR " << in << ")" << (parity_ok && se_ok && mc_ok ? "  PASS" : "  FAIL")
+		<< " | monthly " << (knock_in ? std::get<1>(e) : std::get<0>(e)) << " (SE " << se_cv << " vs " << se_plain << ")"
+		<< (cv_ok && mis_ok ? "  PASS" : "  FAIL") << "\n";
+
+	return parity_ok && se_ok && mc_ok && cv_ok && mis_ok;
+}
+
+int main() {
+
+	// For each single barrier option, with the strike on either side of the barrier:
+	//  - continuously monitored, the knock-out, knock-in and vanilla of BarrierParityPricer() must satisfy in-out parity,
+	//    have non-zero standard errors (but for a worthless knock-out), and match Reiner-Rubinstein and Black-Scholes within
+	//    4 standard errors
+	//  - monitored monthly, the control variate must agree with the plain estimate, reduce the error of the priced payoff,
+	//    and keep parity; the path payoffs kept for MIS must average to the price
+
+	std::cout << "Barrier Test: BarrierParityPricer against Reiner-Rubinstein\n\n";
+	std::cout << std::setprecision(6);
+
+	bool ok = true;
+	ok = TestCase<130, 0>(true, false, 100) && ok;
+	ok = TestCase<0, 80>(true, true, 100) && ok;
+	ok = TestCase<120, 0>(false, false, 100) && ok;
+	ok = TestCase<0, 85>(false, true, 100) && ok;
+	ok = TestCase<110, 0>(true, true, 120) && ok;
+	ok = TestCase<0, 95>(true, false, 90) && ok;
+	ok = TestCase<110, 0>(false, true, 105) && ok;
+	ok = TestCase<0, 90>(false, false, 80) && ok;
+
+	return ok ? 0 : 1;
+}
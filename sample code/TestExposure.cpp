@@ -0,0 +1,63 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ==================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Test code for the exposure profile of a forward
+*
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cmath>
+
+#include "Exposure.hpp"
+#include "BlackScholes.hpp"
+
+int main() {
+
+	// A forward struck at K and maturing at T is worth V_t = S_t e^(-q tau) - K e^(-r tau) at t, tau = T - t, so its
+	// exposures are options on the stock to t, undiscounted:
+	//     EE(t)  = E[max(V_t, 0)] =  e^(r t) e^(-q tau) Call(S0, K e^(-(r - q) tau), t)
+	//     ENE(t) = E[min(V_t, 0)] = -e^(r t) e^(-q tau) Put(S0, K e^(-(r - q) tau), t)
+	// Both must match the profile within 4 standard errors; the positive and negative parts are 1-Lipschitz in V, so their
+	// standard errors are bounded by the one of V_t, which is known in closed form
+
+	std::cout << "Exposure Test: EE and ENE of a forward against the closed form\n\n";
+
+	double r		= 0.03;		// Rate
+	double q		= 0.01;		// Dividend yield
+	double vol		= 0.25;		// Volatility
+	double T		= 2.0;		// Maturity of the forward
+	double S		= 100;		// Stock price
+	double K		= 105;		// Forward price agreed
+
+	const unsigned long NSIM = 200000;
+	const std::vector<double> dates = { 0.25, 0.5, 1.0, 1.5, 1.75 };
+
+	ExposureEngine engine(r, vol, q);
+	ExposureProfile profile = engine.Profile({ ExposureTrade::Forward(K, T) }, S, dates, NSIM);
+
+	bool ok = true;
+	std::cout << std::setprecision(6);
+
+	for (std::size_t i = 0; i < dates.size(); ++i) {
+		double t = dates[i], tau = T - t;
+		double scale = exp(r * t - q * tau), K_t = K * exp(-(r - q) * tau);
+		double EE = scale * BlackScholes::Price(true, S, K_t, t, r, q, vol);
+		double ENE = -scale * BlackScholes::Price(false, S, K_t, t, r, q, vol);
+
+		// Standard deviation of V_t = e^(-q tau) S_t - K e^(-r tau)
+		double sd_V = exp(-q * tau) * S * exp((r - q) * t) * sqrt(exp(vol * vol * t) - 1.0);
+		double tol = 4.0 * sd_V / sqrt(static_cast<double>(NSIM));
+
+		bool pass = std::abs(profile.EE[i] - EE) < tol && std::abs(profile.ENE[i] - ENE) < tol;
+		std::cout << "t=" << t << ": EE " << profile.EE[i] << " (closed form " << EE << "), ENE " << profile.ENE[i]
+			<< " (closed form " << ENE << "), tolerance " << tol << (pass ? "  PASS" : "  FAIL") << "\n";
+		ok = ok && pass;
+	}
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,60 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ==================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Test code for the Heston ADI engine
+*
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+
+#include "ADI.hpp"
+
+int main() {
+
+	// European call in case 1 of In 't Hout and Foulon (2010), whose reference price at S = 100, v = 0.04 is 8.8948693600360
+	//  - Craig-Sneyd within 1e-2 on the default 100 x 50 grid with 50 steps, 2.5e-3 on 200 x 100 with 100 steps
+	//  - Douglas at theta = 1/2 within 2e-2 with 100 steps
+	//  - the price must not depend on the number of threads
+
+	std::cout << "ADI Test: Heston call against the In 't Hout-Foulon reference\n\n";
+
+	HestonParameters p;
+	p.v0	= 0.04;		// Initial variance
+	p.kappa	= 1.5;		// Mean reversion speed
+	p.theta	= 0.04;		// Long-run variance
+	p.xi	= 0.3;		// Volatility of variance
+	p.rho	= -0.9;		// Correlation
+
+	double r		= 0.025;	// Rate
+	double T		= 1.0;		// Expiry
+	double S		= 100;		// Stock price
+	double K		= 100;		// Strike
+
+	const double reference = 8.8948693600360;
+
+	HestonADI adi(p, r);
+
+	double craig_sneyd = adi.Price(true, S, K, T, 100, 50, 50, ADIScheme::CraigSneyd, 1).price;
+	double craig_sneyd_fine = adi.Price(true, S, K, T, 200, 100, 100, ADIScheme::CraigSneyd).price;
+	double douglas = adi.Price(true, S, K, T, 100, 50, 100, ADIScheme::Douglas).price;
+	double craig_sneyd_threads = adi.Price(true, S, K, T, 100, 50, 50, ADIScheme::CraigSneyd, 4).price;
+
+	bool craig_sneyd_ok = std::abs(craig_sneyd - reference) < 1e-2;
+	bool fine_ok = std::abs(craig_sneyd_fine - reference) < 2.5e-3;
+	bool douglas_ok = std::abs(douglas - reference) < 2e-2;
+	bool threads_ok = craig_sneyd_threads == craig_sneyd;
+
+	std::cout << std::setprecision(8);
+	std::cout << "Reference price: " << reference << "\n";
+	std::cout << "ADI Craig-Sneyd, 100 x 50, 50 steps: " << craig_sneyd << (craig_sneyd_ok ? "  PASS" : "  FAIL") << "\n";
+	std::cout << "ADI Craig-Sneyd, 200 x 100, 100 steps: " << craig_sneyd_fine << (fine_ok ? "  PASS" : "  FAIL") << "\n";
+	std::cout << "ADI Douglas, 100 x 50, 100 steps: " << douglas << (douglas_ok ? "  PASS" : "  FAIL") << "\n";
+	std::cout << "ADI Craig-Sneyd, 4 threads: " << craig_sneyd_threads << (threads_ok ? "  PASS" : "  FAIL") << "\n";
+
+	return (craig_sneyd_ok && fine_ok && douglas_ok && threads_ok) ? 0 : 1;
+}
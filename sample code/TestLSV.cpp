@@ -0,0 +1,59 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ==================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Test code for the LSV calibration against its own volatility surface
+*
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cmath>
+
+#include "LSV.hpp"
+#include "BlackScholes.hpp"
+
+int main() {
+
+	// The leverage is calibrated so that the LSV model reproduces the vanillas of the surface it was built from: the
+	// out-of-the-money calls and puts of the particles must price within half a volatility point of the surface, widened
+	// by 4 standard errors. The remaining gap is the bias of the binned conditional expectation and of the time steps
+
+	std::cout << "LSV Test: calibrated particles against the vanillas of the surface\n\n";
+
+	double r		= 0.02;		// Rate
+	double q		= 0.01;		// Dividend yield
+	double T		= 1.0;		// Expiry
+	double S		= 100;		// Stock price
+	double band		= 0.005;	// Implied volatility tolerance
+
+	VolSurface surface({ SVISlice::FromSSVI(0.5, 0.02, -0.5, 1.0, 0.5), SVISlice::FromSSVI(1.0, 0.04, -0.5, 1.0, 0.5) });
+	LSVEngine engine(surface, HestonParameters{ 0.04, 1.5, 0.04, 0.5, -0.7 }, r, q);
+
+	const double F = S * exp((r - q) * T);
+	const std::vector<double> puts = { 70, 80, 90, 100 }, calls = { 100, 110, 120, 130 };
+
+	bool ok = true;
+	std::cout << std::setprecision(6);
+
+	for (bool call : { false, true }) {
+		const std::vector<double> & strikes = call ? calls : puts;
+		LSVResults res = engine.Price(call, S, strikes, T, 200000, 100);
+		for (std::size_t k = 0; k < strikes.size(); ++k) {
+			double vol = surface.ImpliedVol(T, log(strikes[k] / F));
+			double exact = BlackScholes::Price(call, S, strikes[k], T, r, q, vol);
+			double lo = BlackScholes::Price(call, S, strikes[k], T, r, q, vol - band);
+			double hi = BlackScholes::Price(call, S, strikes[k], T, r, q, vol + band);
+			double mc = std::get<0>(res)[k], se = std::get<1>(res)[k];
+			bool pass = mc > lo - 4.0 * se && mc < hi + 4.0 * se;
+			std::cout << (call ? "Call" : "Put") << " K=" << strikes[k] << ": surface " << exact << " (vol " << vol << "), LSV "
+				<< mc << " (SE " << se << ")" << (pass ? "  PASS" : "  FAIL") << "\n";
+			ok = ok && pass;
+		}
+	}
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,59 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ==================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Test code for the value today of the nested simulation
+*
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "NestedMC.hpp"
+#include "BlackScholes.hpp"
+
+int main() {
+
+	// The value today V0 is a plain Monte Carlo price over the shared inner normals, so for a call it must match
+	// Black-Scholes within 4 standard errors. The normals come in antithetic pairs, whose means are the independent draws
+	// and have a variance no larger than one payoff; the call payoff is 1-Lipschitz in S_T, so that variance is bounded by
+	// the one of S_T, which is known in closed form
+
+	std::cout << "Nested MC Test: value today against Black-Scholes\n\n";
+
+	double r		= 0.03;		// Rate
+	double q		= 0.01;		// Dividend yield
+	double vol		= 0.2;		// Volatility
+	double H		= 0.25;		// Risk horizon
+	double T		= 1.0;		// Maturity
+	double S		= 100;		// Stock price
+
+	const unsigned long n_outer = 2000, max_inner = 1 << 18;
+	const std::vector<double> strikes = { 80, 100, 120 };
+
+	NestedEngine engine(r, vol, q);
+
+	bool ok = true;
+	std::cout << std::setprecision(6);
+
+	// Standard deviation of S_T, and the bound on the standard error over the antithetic pairs
+	double sd_S = S * exp((r - q) * T) * sqrt(exp(vol * vol * T) - 1.0);
+	double tol = 4.0 * exp(-r * T) * sd_S / sqrt(0.5 * static_cast<double>(max_inner));
+
+	for (double K : strikes) {
+		NestedResults res = engine.Run([K](double s) { return std::max(s - K, 0.0); }, S, H, T, n_outer, 256, 0, max_inner);
+		double bs = BlackScholes::Price(true, S, K, T, r, q, vol);
+
+		bool pass = std::abs(res.V0 - bs) < tol;
+		std::cout << "K=" << K << ": V0 " << res.V0 << " (Black-Scholes " << bs << "), tolerance " << tol
+			<< (pass ? "  PASS" : "  FAIL") << "\n";
+		ok = ok && pass;
+	}
+
+	return ok ? 0 : 1;
+}
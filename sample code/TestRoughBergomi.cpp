@@ -0,0 +1,54 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ==================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Test code for the rough Bergomi engine in the Black-Scholes limit
+*
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cmath>
+
+#include "RoughBergomi.hpp"
+#include "BlackScholes.hpp"
+
+int main() {
+
+	// With no volatility of volatility the variance is the flat forward variance xi0 on every path, so rough Bergomi
+	// prices must match Black-Scholes at the volatility sqrt(xi0) within 4 standard errors, for any Hurst exponent and
+	// correlation; a small eta must stay within the same tolerance
+
+	std::cout << "Rough Bergomi Test: eta -> 0 against Black-Scholes at sqrt(xi0)\n\n";
+
+	double xi0		= 0.04;		// Flat forward variance
+	double r		= 0.03;		// Rate
+	double q		= 0.01;		// Dividend yield
+	double T		= 1.0;		// Expiry
+	double S		= 100;		// Stock price
+
+	const std::vector<double> strikes = { 80, 90, 100, 110, 120 };
+
+	bool ok = true;
+	std::cout << std::setprecision(6);
+
+	for (double eta : { 0.0, 1e-3 }) {
+		RoughBergomiEngine engine(RoughBergomiParameters{ 0.1, eta, -0.9, xi0 }, r, q);
+		for (bool call : { true, false }) {
+			RoughBergomiResults res = engine.Price(call, S, strikes, T, 100000, 32);
+			for (std::size_t k = 0; k < strikes.size(); ++k) {
+				double exact = BlackScholes::Price(call, S, strikes[k], T, r, q, sqrt(xi0));
+				double mc = std::get<0>(res)[k], se = std::get<1>(res)[k];
+				bool pass = std::abs(mc - exact) < 4.0 * se;
+				std::cout << (call ? "Call" : "Put") << " eta=" << eta << " K=" << strikes[k] << ": Black-Scholes " << exact
+					<< ", MC " << mc << " (SE " << se << ")" << (pass ? "  PASS" : "  FAIL") << "\n";
+				ok = ok && pass;
+			}
+		}
+	}
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,62 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ==================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Test code for the Schwartz-Smith commodity engine
+*
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <utility>
+#include <cmath>
+
+#include "Schwartz.hpp"
+
+int main() {
+
+	// Schwartz-Smith model fitted to a futures curve with backwardation and contango
+	//  - the model futures prices F(0, T) must reprice the quotes
+	//  - the simulated spot at each quoted maturity must have the quote as its mean (a call struck at zero, undiscounted)
+	//  - an option on the futures simulated with one exact step must match the Black closed form
+	// The Monte Carlo checks must hold within 4 standard errors
+
+	std::cout << "Schwartz-Smith Test: futures curve repricing\n\n";
+
+	double r = 0.03;	// Rate
+	SchwartzSmithParameters p = { 1.5, 0.3, -0.02, 0.15, 0.3, 0.1, log(60.0) };
+	const std::vector<std::pair<double, double>> quotes = { { 0.25, 64.0 }, { 0.5, 62.5 }, { 1.0, 60.0 }, { 2.0, 61.0 }, { 3.0, 63.0 } };
+
+	SchwartzSmith model(p, FuturesCurve(quotes));
+	SchwartzSmithEngine engine(model, r);
+
+	bool ok = true;
+	std::cout << std::setprecision(8);
+
+	for (auto & quote : quotes) {
+		double T = quote.first, F = quote.second;
+		double model_F = model.Futures(T);
+		CommodityResults mc = engine.Price(true, { 0.0 }, T, 200000);
+		double mc_F = std::get<0>(mc)[0] * exp(r * T), mc_error = std::get<1>(mc)[0] * exp(r * T);
+
+		bool curve_ok = std::abs(model_F - F) < 1e-10 * F;
+		bool mc_ok = std::abs(mc_F - F) < 4.0 * mc_error;
+		std::cout << "T=" << T << ": quote " << F << ", model " << model_F << (curve_ok ? "  PASS" : "  FAIL")
+			<< ", MC " << mc_F << " (SE " << mc_error << ")" << (mc_ok ? "  PASS" : "  FAIL") << "\n";
+		ok = ok && curve_ok && mc_ok;
+	}
+
+	// Call and put expiring at 0.5 on the futures of maturity 2
+	for (bool call : { true, false }) {
+		double exact = model.FuturesOption(call, 60.0, 0.5, 2.0, r);
+		CommodityResults mc = engine.Price(call, { 60.0 }, 0.5, 200000, 2.0);
+		bool pass = std::abs(std::get<0>(mc)[0] - exact) < 4.0 * std::get<1>(mc)[0];
+		std::cout << (call ? "Call" : "Put") << " on the futures: closed form " << exact << ", MC " << std::get<0>(mc)[0]
+			<< " (SE " << std::get<1>(mc)[0] << ")" << (pass ? "  PASS" : "  FAIL") << "\n";
+		ok = ok && pass;
+	}
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ==================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Test code for the thread-count invariance of the parallel engines
+*
+*/
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+
+#include "Levy.hpp"
+#include "SABR.hpp"
+#include "RoughBergomi.hpp"
+#include "LSV.hpp"
+#include "Schwartz.hpp"
+#include "Exposure.hpp"
+#include "NestedMC.hpp"
+#include "HullWhite.hpp"
+#include "ADI.hpp"
+
+int main() {
+
+	// The parallel engines split their work in blocks with their own seeds and reduce the blocks in order, so the same
+	// seed and block size must give bit-identical results with 1, 2, 3 and 8 threads
+
+	std::cout << "Parallel Test: results do not depend on the number of threads\n\n";
+
+	const std::vector<double> strikes = { 90, 100, 110 };
+	const unsigned thread_counts[] = { 1, 2, 3, 8 };
+
+	// Each engine, as a function of the number of threads returning all its outputs
+	std::vector<std::pair<std::string, std::function<std::vector<double>(unsigned)>>> engines;
+
+	auto Join = [](const std::vector<double> & x, const std::vector<double> & y) {
+		std::vector<double> out(x);
+		out.insert(out.end(), y.begin(), y.end());
+		return out;
+	};
+
+	engines.emplace_back("Variance-Gamma", [&](unsigned threads) {
+		LevyEngine<VarianceGamma> engine(VarianceGamma(0.12, 0.2, -0.14), 0.05);
+		LevyResults res = engine.Price(true, 100, strikes, 1.0, 20000, 7, 1000, threads);
+		return Join(std::get<0>(res), std::get<1>(res));
+	});
+
+	engines.emplace_back("SABR", [&](unsigned threads) {
+		SABREngine engine(SABRParameters{ 0.3, 0.7, -0.3, 0.5 });
+		SABRResults res = engine.Price(true, 100, strikes, 1.0, 0.97, 20000, 8, true, 7, 1000, threads);
+		return Join(std::get<0>(res), std::get<1>(res));
+	});
+
+	engines.emplace_back("Rough Bergomi", [&](unsigned threads) {
+		RoughBergomiEngine engine(RoughBergomiParameters{ 0.1, 1.9, -0.9, 0.04 }, 0.02);
+		RoughBergomiResults res = engine.Price(true, 100, strikes, 1.0, 2000, 32, 7, 256, threads);
+		return Join(std::get<0>(res), std::get<1>(res));
+	});
+
+	engines.emplace_back("LSV", [&](unsigned threads) {
+		VolSurface surface({ SVISlice::FromSSVI(0.5, 0.02, -0.5, 1.0, 0.5), SVISlice::FromSSVI(1.0, 0.04, -0.5, 1.0, 0.5) });
+		LSVEngine engine(surface, HestonParameters{ 0.04, 1.5, 0.04, 0.5, -0.7 }, 0.02);
+		LSVResults res = engine.Price(true, 100, strikes, 1.0, 20000, 10, 7, 2048, threads);
+		return Join(std::get<0>(res), std::get<1>(res));
+	});
+
+	engines.emplace_back("Schwartz-Smith", [&](unsigned threads) {
+		SchwartzSmithEngine engine(SchwartzSmith(SchwartzSmithParameters{ 1.5, 0.3, 0.0, 0.15, 0.3, 0.0, log(50.0) }), 0.03);
+		CommodityResults res = engine.PriceAsian(true, { 45, 50 }, { 0.25, 0.5, 0.75, 1.0 }, 20000, 7, 1000, threads);
+		return Join(std::get<0>(res), std::get<1>(res));
+	});
+
+	engines.emplace_back("Exposure", [&](unsigned threads) {
+		ExposureEngine engine(0.02, 0.2);
+		ExposureProfile profile = engine.Profile({ ExposureTrade::Forward(100, 1.0), ExposureTrade::Call(110, 1.0) }, 100,
+			{ 0.25, 0.5, 0.75 }, 20000, 0.975, 5000, 7, 1000, threads);
+		return Join(Join(profile.EE, profile.ENE), profile.PFE);
+	});
+
+	engines.emplace_back("Nested", [&](unsigned threads) {
+		NestedEngine engine(0.03, 0.2);
+		NestedResults res = engine.Run([](double s) { return std::max(s - 100.0, 0.0); }, 100, 0.25, 1.0, 500, 256, 50000,
+			1 << 14, 0.99, 4, 7, threads);
+		return Join(res.values, { res.VaR, res.ES });
+	});
+
+	engines.emplace_back("Hull-White", [&](unsigned threads) {
+		HullWhite model(HullWhiteParameters{ 0.1, 0.015 }, std::make_shared<const DiscountCurve>(0.02));
+		HybridResults res = HullWhiteEquityEngine(model, 0.2, 0.3).Price(true, 100, 100, 1.0, 20000, 4, 7, 1000, threads);
+		return std::vector<double>{ std::get<0>(res), std::get<1>(res) };
+	});
+
+	engines.emplace_back("Heston ADI", [&](unsigned threads) {
+		ADIResults res = HestonADI(HestonParameters{ 0.04, 1.5, 0.04, 0.3, -0.9 }, 0.025).Price(true, 100, 100, 1.0, 60, 30, 20,
+			ADIScheme::CraigSneyd, threads);
+		return std::vector<double>{ res.price, res.delta_x, res.delta_y, res.gamma_xx, res.gamma_yy, res.gamma_xy };
+	});
+
+	bool ok = true;
+	for (auto & engine : engines) {
+		std::vector<double> reference = engine.second(thread_counts[0]);
+		bool pass = true;
+		for (unsigned threads : thread_counts) pass = pass && (engine.second(threads) == reference);
+		std::cout << engine.first << ": " << (pass ? "PASS" : "FAIL") << "\n";
+		ok = ok && pass;
+	}
+
+	return ok ? 0 : 1;
+}
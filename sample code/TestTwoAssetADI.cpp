@@ -0,0 +1,65 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ==================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Test code for the two-dimensional ADI engine
+*
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+
+#include "ADI.hpp"
+#include "BlackScholes.hpp"
+
+int main() {
+
+	// Exchange option max(S1 - S2, 0) on two correlated GBM assets against the Margrabe formula
+	//     S1 e^(-q1 T) N(d1) - S2 e^(-q2 T) N(d2),    sigma^2 = vol1^2 + vol2^2 - 2 rho vol1 vol2
+	//  - Craig-Sneyd is second order: within 2.5e-3 on the default 100 x 100 grid with 50 steps, 5e-4 on 200 x 200 with 100
+	//  - Douglas at theta = 1/2 is first order in time through the explicit mixed term: within 1.5e-2 with 100 steps
+	//  - the price must not depend on the number of threads
+
+	std::cout << "ADI Test: Margrabe exchange option with TwoAssetADI\n\n";
+
+	double vol1		= 0.2;		// Volatility of the first asset
+	double vol2		= 0.3;		// Volatility of the second asset
+	double rho		= 0.5;		// Correlation
+	double r		= 0.05;		// Rate
+	double q1		= 0.01;		// Dividend yield of the first asset
+	double q2		= 0.03;		// Dividend yield of the second asset
+	double T		= 1.0;		// Expiry
+	double S1		= 100;		// First stock price
+	double S2		= 95;		// Second stock price
+
+	double sigma = sqrt(vol1 * vol1 + vol2 * vol2 - 2.0 * rho * vol1 * vol2);
+	double d1 = (log(S1 / S2) + (q2 - q1 + 0.5 * sigma * sigma) * T) / (sigma * sqrt(T));
+	double d2 = d1 - sigma * sqrt(T);
+	double margrabe = S1 * exp(-q1 * T) * BlackScholes::N(d1) - S2 * exp(-q2 * T) * BlackScholes::N(d2);
+
+	TwoAssetADI adi(vol1, vol2, rho, r, q1, q2);
+	auto exchange = [](double x, double y) { return std::max(x - y, 0.0); };
+
+	double craig_sneyd = adi.Price(exchange, S1, S2, T, 100, 100, 50, ADIScheme::CraigSneyd, 1).price;
+	double craig_sneyd_fine = adi.Price(exchange, S1, S2, T, 200, 200, 100, ADIScheme::CraigSneyd).price;
+	double douglas = adi.Price(exchange, S1, S2, T, 100, 100, 100, ADIScheme::Douglas).price;
+	double craig_sneyd_threads = adi.Price(exchange, S1, S2, T, 100, 100, 50, ADIScheme::CraigSneyd, 4).price;
+
+	bool craig_sneyd_ok = std::abs(craig_sneyd - margrabe) < 2.5e-3;
+	bool fine_ok = std::abs(craig_sneyd_fine - margrabe) < 5e-4;
+	bool douglas_ok = std::abs(douglas - margrabe) < 1.5e-2;
+	bool threads_ok = craig_sneyd_threads == craig_sneyd;
+
+	std::cout << std::setprecision(8);
+	std::cout << "Margrabe price: " << margrabe << "\n";
+	std::cout << "ADI Craig-Sneyd, 100 x 100, 50 steps: " << craig_sneyd << (craig_sneyd_ok ? "  PASS" : "  FAIL") << "\n";
+	std::cout << "ADI Craig-Sneyd, 200 x 200, 100 steps: " << craig_sneyd_fine << (fine_ok ? "  PASS" : "  FAIL") << "\n";
+	std::cout << "ADI Douglas, 100 x 100, 100 steps: " << douglas << (douglas_ok ? "  PASS" : "  FAIL") << "\n";
+	std::cout << "ADI Craig-Sneyd, 4 threads: " << craig_sneyd_threads << (threads_ok ? "  PASS" : "  FAIL") << "\n";
+
+	return (craig_sneyd_ok && fine_ok && douglas_ok && threads_ok) ? 0 : 1;
+}
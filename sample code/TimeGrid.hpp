@@ -0,0 +1,133 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ===================================================================================================================================================
+*
+*	Monte Carlo Option Pricing Application - Simulation time grid built from the payoff observation schedule
+*
+*/
+
+/*   A payoff that only looks at the underlying on a few dates declares them as its observation schedule. The grid is
+*    then the union of these dates, the expiry and any dates the model needs (i.e. ex-dividend dates), refined only
+*    where an interval is longer than the largest step allowed by the scheme or by barrier monitoring. With exact
+*    GBM transitions no refinement is needed, so a monthly Asian costs 12 steps.
+*/
+
+// Multiple inclusion guards
+#ifndef TIMEGRID_HPP
+#define TIMEGRID_HPP
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+
+// Alias for the observation dates of a payoff, in years, in (0, T]
+using ObservationSchedule = std::vector<double>;
+
+// Simulation time grid class
+class TimeGrid {
+private:
+	std::vector<double> times;		// 0 = t_0 < t_1 < ... < t_n = T
+	std::vector<double> dts;		// dt_i = t_(i+1) - t_i
+	std::vector<double> sqrt_dts;	// sqrt(dt_i)
+	std::vector<char> observed;		// observed[i] = 1 if t_i is an observation date
+	std::size_t observations = 0;	// Number of observation dates
+
+	// Dates closer than this are merged
+	static constexpr double tolerance = 1e-10;
+
+	inline void Finalize() {
+		std::size_t n = times.size() - 1;
+		dts.resize(n);
+		sqrt_dts.resize(n);
+		for (std::size_t i = 0; i < n; ++i) {
+			dts[i] = times[i + 1] - times[i];
+			sqrt_dts[i] = sqrt(dts[i]);
+		}
+		observations = std::count(observed.begin(), observed.end(), 1);
+	}
+
+public:
+
+	// Constructor
+	explicit TimeGrid() : times(1, 0.0), observed(1, 0) {}
+
+	// Uniform grid of NSteps steps where every date is observed -- the classic dt = T / NSteps grid
+	inline static TimeGrid Uniform(double T, unsigned long NSteps) {
+
+		if (T <= 0.0 || NSteps == 0) throw std::invalid_argument("Invalid uniform time grid");
+
+		TimeGrid grid;
+		grid.times.resize(NSteps + 1);
+		grid.observed.assign(NSteps + 1, 1);
+		grid.observed[0] = 0;
+		for (unsigned long i = 0; i <= NSteps; ++i) grid.times[i] = T * static_cast<double>(i) / static_cast<double>(NSteps);
+		grid.times[NSteps] = T;
+		grid.Finalize();
+		return grid;
+	}
+
+	// Minimal grid for a schedule: observation dates, the expiry, and the extra dates required by the model
+	// If max_dt > 0, every interval longer than max_dt is split into equal sub-steps (scheme or barrier refinement)
+	// The expiry is observed only if it belongs to the schedule, or if the schedule is empty
+	inline static TimeGrid FromSchedule(double T, const ObservationSchedule & schedule, double max_dt = 0.0,
+		const std::vector<double> & required = std::vector<double>()) {
+
+		if (T <= 0.0) throw std::invalid_argument("Invalid expiry for the time grid");
+
+		// Collect the dates with a flag that marks observations
+		std::vector<std::pair<double, char>> dates;
+		dates.reserve(schedule.size() + required.size() + 1);
+		for (double t : schedule) if (t > tolerance && t <= T + tolerance) dates.push_back(std::make_pair(std::min(t, T), char(1)));
+		for (double t : required) if (t > tolerance && t < T - tolerance) dates.push_back(std::make_pair(t, char(0)));
+		dates.push_back(std::make_pair(T, char(schedule.empty() ? 1 : 0)));
+		std::sort(dates.begin(), dates.end());
+
+		// Merge equal dates, keeping the observation flag if any of them is observed
+		TimeGrid grid;
+		for (auto & d : dates) {
+			if (d.first - grid.times.back() <= tolerance) {
+				if (grid.times.size() > 1) grid.observed.back() = grid.observed.back() | d.second;
+				continue;
+			}
+
+			// Refine the interval if it is too long for the scheme
+			double last = grid.times.back();
+			if (max_dt > 0.0) {
+				std::size_t sub = static_cast<std::size_t>(std::ceil((d.first - last) / max_dt - tolerance));
+				for (std::size_t k = 1; k < sub; ++k) {
+					grid.times.push_back(last + (d.first - last) * static_cast<double>(k) / static_cast<double>(sub));
+					grid.observed.push_back(0);
+				}
+			}
+			grid.times.push_back(d.first);
+			grid.observed.push_back(d.second);
+		}
+
+		grid.Finalize();
+		return grid;
+	}
+
+	// Convenience schedule of n equally spaced observation dates in (0, T], i.e. Periodic(1.0, 12) for a monthly Asian
+	inline static ObservationSchedule Periodic(double T, unsigned n) {
+		ObservationSchedule schedule(n);
+		for (unsigned i = 0; i < n; ++i) schedule[i] = T * static_cast<double>(i + 1) / static_cast<double>(n);
+		return schedule;
+	}
+
+	// Getters
+	inline std::size_t Steps() const { return dts.size(); }						// Number of steps
+	inline double Time(std::size_t i) const { return times[i]; }				// Date t_i, i in [0, Steps()]
+	inline double Dt(std::size_t i) const { return dts[i]; }					// Length of step i
+	inline double SqrtDt(std::size_t i) const { return sqrt_dts[i]; }			// Square root of the length of step i
+	inline bool IsObservation(std::size_t i) const { return observed[i] != 0; }	// Is t_i an observation date?
+	inline std::size_t Observations() const { return observations; }			// Number of observation dates
+	inline const std::vector<double> & Times() const { return times; }
+
+	// Destructor
+	~TimeGrid() {}
+};
+
+#endif // !TIMEGRID_HPP
@@ -0,0 +1,401 @@
+/*
+*	© Superharmonic Technologies
+*	Pavlos Sakoglou
+*
+*  ===================================================================================================================================================
+*
+*	Monte Carlo Option Pricing Application - SVI/SSVI volatility surface, fitting and Dupire local volatility
+*
+*/
+
+/*   Each expiry slice is a raw SVI smile in total implied variance w(k) = sigma_imp^2 * T against log-moneyness
+*    k = ln(K/F):
+*
+*        w(k) = a + b * ( rho * (k - m) + sqrt((k - m)^2 + sigma^2) )
+*
+*    Slices are fitted independently and in parallel with Levenberg-Marquardt. The residuals and the analytic Jacobian
+*    of a slice are computed in one pass over contiguous arrays of quotes, which the compiler vectorizes, and the 5x5
+*    normal equations are solved directly. Between slices the total variance is interpolated linearly in T.
+*
+*    The Dupire local volatility follows from the total variance and its derivatives (Gatheral's formula) and is
+*    tabulated once on the simulation time grid, so the path loops only do table lookups.
+*/
+
+// Multiple inclusion guards
+#ifndef VOLSURFACE_HPP
+#define VOLSURFACE_HPP
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <limits>
+#include <cmath>
+
+#include "Parallel.hpp"
+
+// Raw SVI parameters of one slice
+struct SVIParameters {
+	double a;		// Vertical level of the smile
+	double b;		// Slope of the wings
+	double rho;		// Skew, in (-1, 1)
+	double m;		// Horizontal shift
+	double sigma;	// ATM curvature, > 0
+};
+
+// Market quotes of one expiry: log-moneyness and implied volatility, optionally weighted
+struct SVIQuotes {
+	double T;
+	std::vector<double> k;
+	std::vector<double> implied_vol;
+	std::vector<double> weight;		// Empty for equal weights
+};
+
+// One SVI slice and its evaluation kernels
+class SVISlice {
+private:
+	double T;
+	SVIParameters p;
+
+	// Keep the parameters inside the no-arbitrage domain: b >= 0, |rho| < 1, sigma > 0, a + b*sigma*sqrt(1-rho^2) >= 0
+	inline static void Project(SVIParameters & q) {
+		q.b = std::max(q.b, 0.0);
+		q.rho = std::min(std::max(q.rho, -0.999), 0.999);
+		q.sigma = std::max(q.sigma, 1e-4);
+		q.a = std::max(q.a, -q.b * q.sigma * sqrt(1.0 - q.rho * q.rho));
+	}
+
+	// Solve the 5x5 system A x = y with Gaussian elimination and partial pivoting
+	inline static bool Solve5(double A[5][5], double y[5], double x[5]) {
+
+		for (int c = 0; c < 5; ++c) {
+			int piv = c;
+			for (int r = c + 1; r < 5; ++r) if (std::abs(A[r][c]) > std::abs(A[piv][c])) piv = r;
+			if (std::abs(A[piv][c]) < 1e-300) return false;
+			if (piv != c) {
+				for (int j = 0; j < 5; ++j) std::swap(A[c][j], A[piv][j]);
+				std::swap(y[c], y[piv]);
+			}
+			for (int r = c + 1; r < 5; ++r) {
+				double f = A[r][c] / A[c][c];
+				for (int j = c; j < 5; ++j) A[r][j] -= f * A[c][j];
+				y[r] -= f * y[c];
+			}
+		}
+		for (int r = 4; r >= 0; --r) {
+			double s = y[r];
+			for (int j = r + 1; j < 5; ++j) s -= A[r][j] * x[j];
+			x[r] = s / A[r][r];
+		}
+		return true;
+	}
+
+	// Weighted sum of squared residuals of the parameters q
+	inline static double Cost(const SVIParameters & q, const double * k, const double * w_mkt, const double * wt, std::size_t n) {
+		double cost = 0.0;
+		for (std::size_t i = 0; i < n; ++i) {
+			double x = k[i] - q.m;
+			double r = q.a + q.b * (q.rho * x + sqrt(x * x + q.sigma * q.sigma)) - w_mkt[i];
+			cost += wt[i] * r * r;
+		}
+		return cost;
+	}
+
+public:
+
+	// Constructors
+	explicit SVISlice() : T(0.0), p{ 0.0, 0.0, 0.0, 0.0, 0.1 } {}
+	explicit SVISlice(double T_, const SVIParameters & p_) : T(T_), p(p_) {}
+
+	// SSVI slice with ATM total variance theta and power-law curvature phi(theta) = eta / theta^gamma,
+	// written as the equivalent raw SVI parameters
+	inline static SVISlice FromSSVI(double T_, double theta, double rho, double eta, double gamma) {
+		double phi = eta / pow(theta, gamma);
+		SVIParameters q;
+		q.a = 0.5 * theta * (1.0 - rho * rho);
+		q.b = 0.5 * theta * phi;
+		q.rho = rho;
+		q.m = -rho / phi;
+		q.sigma = sqrt(1.0 - rho * rho) / phi;
+		return SVISlice(T_, q);
+	}
+
+	// Getters
+	inline double Expiry() const { return T; }
+	inline const SVIParameters & Parameters() const { return p; }
+
+	// Total variance of one point
+	inline double TotalVariance(double k) const {
+		double x = k - p.m;
+		return p.a + p.b * (p.rho * x + sqrt(x * x + p.sigma * p.sigma));
+	}
+
+	// Batch kernel: total variance and its first and second derivatives in k for n points
+	// Straight-line arithmetic over contiguous arrays, so the loop is vectorized by the compiler
+	inline void TotalVariance(const double * k, double * w, double * w_k, double * w_kk, std::size_t n) const {
+
+		const double a = p.a, b = p.b, rho = p.rho, m = p.m, s2 = p.sigma * p.sigma;
+		for (std::size_t i = 0; i < n; ++i) {
+			double x = k[i] - m;
+			double root = sqrt(x * x + s2);
+			double inv = 1.0 / root;
+			w[i] = a + b * (rho * x + root);
+			w_k[i] = b * (rho + x * inv);
+			w_kk[i] = b * s2 * inv * inv * inv;
+		}
+	}
+
+	// Fit the slice to market quotes with Levenberg-Marquardt
+	// Returns the root mean square error in total variance
+	inline double Fit(const SVIQuotes & quotes, unsigned max_iterations = 200) {
+
+		std::size_t n = quotes.k.size();
+		if (n < 5 || quotes.implied_vol.size() != n) throw std::invalid_argument("SVI fit needs at least 5 quotes per slice");
+
+		T = quotes.T;
+
+		// Market total variances and weights as contiguous arrays
+		std::vector<double> w_mkt(n), wt(n, 1.0);
+		for (std::size_t i = 0; i < n; ++i) w_mkt[i] = quotes.implied_vol[i] * quotes.implied_vol[i] * T;
+		if (quotes.weight.size() == n) wt = quotes.weight;
+
+		// Initial guess around the minimum of the quoted smile
+		std::size_t imin = std::min_element(w_mkt.begin(), w_mkt.end()) - w_mkt.begin();
+		double kmin = *std::min_element(quotes.k.begin(), quotes.k.end());
+		double kmax = *std::max_element(quotes.k.begin(), quotes.k.end());
+		p.m = quotes.k[imin];
+		p.sigma = std::max(0.1 * (kmax - kmin), 0.01);
+		p.rho = -0.3;
+		p.b = std::max((w_mkt.front() + w_mkt.back() - 2.0 * w_mkt[imin]) / std::max(kmax - kmin, 1e-6), 1e-3);
+		p.a = w_mkt[imin] - p.b * p.sigma * sqrt(1.0 - p.rho * p.rho);
+		Project(p);
+
+		// Scratch arrays for residuals and the Jacobian columns
+		std::vector<double> r(n), ja(n, 1.0), jb(n), jr(n), jm(n), js(n);
+		double * J[5] = { ja.data(), jb.data(), jr.data(), jm.data(), js.data() };
+
+		double lambda = 1e-3;
+		double cost = Cost(p, quotes.k.data(), w_mkt.data(), wt.data(), n);
+
+		for (unsigned it = 0; it < max_iterations; ++it) {
+
+			// Residuals and Jacobian in one vectorizable pass
+			const double b = p.b, rho = p.rho, m = p.m, sg = p.sigma, s2 = sg * sg;
+			for (std::size_t i = 0; i < n; ++i) {
+				double x = quotes.k[i] - m;
+				double root = sqrt(x * x + s2);
+				double inv = 1.0 / root;
+				r[i] = p.a + b * (rho * x + root) - w_mkt[i];
+				jb[i] = rho * x + root;
+				jr[i] = b * x;
+				jm[i] = -b * (rho + x * inv);
+				js[i] = b * sg * inv;
+			}
+
+			// Normal equations J'WJ and J'Wr
+			double A[5][5], g[5];
+			for (int u = 0; u < 5; ++u) {
+				double gu = 0.0;
+				for (std::size_t i = 0; i < n; ++i) gu += wt[i] * J[u][i] * r[i];
+				g[u] = gu;
+				for (int v = u; v < 5; ++v) {
+					double s = 0.0;
+					for (std::size_t i = 0; i < n; ++i) s += wt[i] * J[u][i] * J[v][i];
+					A[u][v] = A[v][u] = s;
+				}
+			}
+
+			// Damped steps until the cost decreases
+			bool improved = false;
+			while (lambda < 1e10) {
+				double D[5][5], y[5], dx[5];
+				for (int u = 0; u < 5; ++u) {
+					for (int v = 0; v < 5; ++v) D[u][v] = A[u][v];
+					D[u][u] += lambda * std::max(A[u][u], 1e-12);
+					y[u] = -g[u];
+				}
+				if (!Solve5(D, y, dx)) { lambda *= 10.0; continue; }
+
+				SVIParameters q{ p.a + dx[0], p.b + dx[1], p.rho + dx[2], p.m + dx[3], p.sigma + dx[4] };
+				Project(q);
+
+				double new_cost = Cost(q, quotes.k.data(), w_mkt.data(), wt.data(), n);
+				if (new_cost < cost) {
+					improved = (cost - new_cost) > 1e-14 * std::max(cost, 1e-300);
+					p = q;
+					cost = new_cost;
+					lambda = std::max(lambda * 0.3, 1e-12);
+					break;
+				}
+				lambda *= 10.0;
+			}
+
+			if (!improved) break;
+		}
+
+		double wsum = 0.0;
+		for (std::size_t i = 0; i < n; ++i) wsum += wt[i];
+		return sqrt(cost / wsum);
+	}
+
+	// Destructor
+	~SVISlice() {}
+};
+
+// Volatility surface made of SVI slices, linear in total variance between expiries
+class VolSurface {
+private:
+	std::vector<SVISlice> slices;	// Sorted by expiry
+
+	// Find the slices around T: T lies between slices[i] and slices[i + 1], with weight w on slices[i + 1]
+	inline void Bracket(double T, std::size_t & i, double & w) const {
+		std::size_t n = slices.size();
+		if (n == 1 || T <= slices.front().Expiry()) { i = 0; w = 0.0; return; }
+		if (T >= slices.back().Expiry()) { i = n - 2; w = 1.0; return; }
+		i = 0;
+		while (slices[i + 1].Expiry() < T) ++i;
+		w = (T - slices[i].Expiry()) / (slices[i + 1].Expiry() - slices[i].Expiry());
+	}
+
+public:
+
+	// Constructors
+	explicit VolSurface() {}
+	explicit VolSurface(const std::vector<SVISlice> & slices_) : slices(slices_) {
+		std::sort(slices.begin(), slices.end(), [](const SVISlice & x, const SVISlice & y) { return x.Expiry() < y.Expiry(); });
+	}
+
+	// Fit all slices in parallel, one task per expiry
+	// Returns the RMSE of each slice in total variance, in expiry order
+	inline std::vector<double> Fit(std::vector<SVIQuotes> quotes, unsigned threads = 0) {
+
+		if (quotes.empty()) throw std::invalid_argument("No quotes to fit the volatility surface");
+		std::sort(quotes.begin(), quotes.end(), [](const SVIQuotes & x, const SVIQuotes & y) { return x.T < y.T; });
+
+		std::vector<SVISlice> fitted(quotes.size());
+		std::vector<double> rmse(quotes.size());
+
+		ParallelFor(0, quotes.size(), [&](std::size_t i, unsigned) {
+			rmse[i] = fitted[i].Fit(quotes[i]);
+		}, threads);
+
+		slices.swap(fitted);
+		return rmse;
+	}
+
+	// Getters
+	inline const std::vector<SVISlice> & Slices() const { return slices; }
+
+	// Batch evaluation at n points with the same expiry T: total variance, its k-derivatives and its T-derivative
+	// Before the first expiry the variance is scaled down to 0 at T = 0, after the last one the implied volatility is flat
+	inline void TotalVariance(double T, const double * k, double * w, double * w_k, double * w_kk, double * w_T, std::size_t n) const {
+
+		if (slices.empty()) throw std::logic_error("Volatility surface has no slices");
+
+		std::size_t i; double u;
+		Bracket(T, i, u);
+
+		slices[i].TotalVariance(k, w, w_k, w_kk, n);
+
+		if (slices.size() == 1 || T <= slices.front().Expiry() || T >= slices.back().Expiry()) {
+			// Proportional in T outside the quoted expiries
+			const SVISlice & s = (T >= slices.back().Expiry()) ? slices.back() : slices.front();
+			if (&s != &slices[i]) s.TotalVariance(k, w, w_k, w_kk, n);
+			double scale = T / s.Expiry();
+			double inv_T = 1.0 / s.Expiry();
+			for (std::size_t j = 0; j < n; ++j) {
+				w_T[j] = w[j] * inv_T;
+				w[j] *= scale;
+				w_k[j] *= scale;
+				w_kk[j] *= scale;
+			}
+			return;
+		}
+
+		std::vector<double> w1(n), wk1(n), wkk1(n);
+		slices[i + 1].TotalVariance(k, w1.data(), wk1.data(), wkk1.data(), n);
+		double inv_dT = 1.0 / (slices[i + 1].Expiry() - slices[i].Expiry());
+		for (std::size_t j = 0; j < n; ++j) {
+			w_T[j] = (w1[j] - w[j]) * inv_dT;
+			w[j] += u * (w1[j] - w[j]);
+			w_k[j] += u * (wk1[j] - w_k[j]);
+			w_kk[j] += u * (wkk1[j] - w_kk[j]);
+		}
+	}
+
+	// Implied volatility of one point
+	inline double ImpliedVol(double T, double k) const {
+		double w, w_k, w_kk, w_T;
+		TotalVariance(T, &k, &w, &w_k, &w_kk, &w_T, 1);
+		return sqrt(std::max(w, 0.0) / T);
+	}
+
+	// Batch Dupire local variance from the total variance (Gatheral):
+	// sigma_loc^2 = w_T / (1 - k w_k / w + 1/4 (-1/4 - 1/w + k^2/w^2) w_k^2 + 1/2 w_kk)
+	inline void LocalVariance(double T, const double * k, double * local_var, std::size_t n) const {
+
+		std::vector<double> w(n), w_k(n), w_kk(n), w_T(n);
+		TotalVariance(T, k, w.data(), w_k.data(), w_kk.data(), w_T.data(), n);
+
+		for (std::size_t j = 0; j < n; ++j) {
+			double inv_w = 1.0 / std::max(w[j], 1e-12);
+			double y = k[j];
+			double den = 1.0 - y * w_k[j] * inv_w + 0.25 * (-0.25 - inv_w + y * y * inv_w * inv_w) * w_k[j] * w_k[j] + 0.5 * w_kk[j];
+			local_var[j] = std::max(w_T[j], 0.0) / std::max(den, 1e-8);
+		}
+	}
+
+	// Destructor
+	~VolSurface() {}
+};
+
+// Dupire local volatility tabulated on the simulation time grid and a uniform log-moneyness grid
+// x = ln(S / F(t)) where F(t) is the forward of the underlying at time t
+class LocalVolGrid {
+private:
+	std::vector<double> times;		// Simulation times, one row per time
+	double x_min, x_max, inv_dx;	// Log-moneyness grid
+	std::size_t nx;					// Number of log-moneyness nodes
+	std::vector<double> vols;		// Local volatilities, times.size() x nx, row-major
+
+public:
+
+	// Constructors
+	// The rows are independent and are built in parallel with the batch kernels of the surface
+	explicit LocalVolGrid(const VolSurface & surface, const std::vector<double> & times_, double x_min_ = -2.0, double x_max_ = 2.0,
+		std::size_t nx_ = 201, unsigned threads = 0)
+		: times(times_), x_min(x_min_), x_max(x_max_), nx(nx_) {
+
+		if (nx < 2 || x_max <= x_min) throw std::invalid_argument("Invalid local volatility grid");
+		double dx = (x_max - x_min) / static_cast<double>(nx - 1);
+		inv_dx = 1.0 / dx;
+
+		std::vector<double> x(nx);
+		for (std::size_t j = 0; j < nx; ++j) x[j] = x_min + dx * static_cast<double>(j);
+
+		vols.resize(times.size() * nx);
+		ParallelFor(0, times.size(), [&](std::size_t i, unsigned) {
+			// The local volatility at t = 0 is taken just after 0, where the surface is still defined
+			double t = std::max(times[i], 1e-4);
+			double * row = vols.data() + i * nx;
+			surface.LocalVariance(t, x.data(), row, nx);
+			for (std::size_t j = 0; j < nx; ++j) row[j] = sqrt(row[j]);
+		}, threads);
+	}
+
+	// Local volatility at the time index i of the grid and log-moneyness x, flat outside the grid
+	inline double operator()(std::size_t i, double x) const {
+		double u = (std::min(std::max(x, x_min), x_max) - x_min) * inv_dx;
+		std::size_t j = std::min(static_cast<std::size_t>(u), nx - 2);
+		double w = u - static_cast<double>(j);
+		const double * row = vols.data() + i * nx;
+		return row[j] + w * (row[j + 1] - row[j]);
+	}
+
+	// Getters
+	inline const std::vector<double> & Times() const { return times; }
+
+	// Destructor
+	~LocalVolGrid() {}
+};
+
+#endif // !VOLSURFACE_HPP